@@ -372,6 +372,40 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Heap statistics, as reported by vPortGetHeapStats().  Only heap_tlsf.c
+ * provides them.  The free block counts and sizes come from a walk of the
+ * whole heap, so the call takes time proportional to the number of blocks.
+ */
+typedef struct xHeapStats
+{
+	size_t xAvailableHeapSpaceInBytes;		/*< The total heap size currently available - this is the sum of all the free blocks, not the largest block that can be allocated. */
+	size_t xSizeOfLargestFreeBlockInBytes;	/*< The maximum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xSizeOfSmallestFreeBlockInBytes;	/*< The minimum size, in bytes, of all the free blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xNumberOfFreeBlocks;				/*< The number of free memory blocks within the heap at the time vPortGetHeapStats() is called. */
+	size_t xMinimumEverFreeBytesRemaining;	/*< The minimum amount of total free memory (sum of all free blocks) there has been in the heap since the system booted. */
+	size_t xNumberOfSuccessfulAllocations;	/*< The number of calls to pvPortMalloc() that have returned a valid memory block. */
+	size_t xNumberOfSuccessfulFrees;		/*< The number of calls to vPortFree() that has successfully freed a block of memory. */
+	size_t xNumberOfFailedAllocations;		/*< The number of calls to pvPortMalloc() that returned NULL. */
+} HeapStats_t;
+
+/*
+ * The state of one fixed size pool of heap_tlsf.c, as reported by
+ * xPortGetHeapPoolStats().
+ */
+typedef struct xHeapPoolStats
+{
+	size_t xBlockSize;						/*< Largest request, in bytes, the pool serves. */
+	size_t xNumberOfBlocks;					/*< Blocks in the pool. */
+	size_t xNumberOfFreeBlocks;				/*< Blocks free now. */
+	size_t xMinimumEverFreeBlocks;			/*< Fewest blocks free since the system booted. */
+	size_t xNumberOfAllocations;			/*< Requests served from the pool. */
+	size_t xNumberOfMisses;					/*< Requests for this size class that found the pool empty and went to the general heap instead. */
+} HeapPoolStats_t;
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats ) PRIVILEGED_FUNCTION;
+BaseType_t xPortGetHeapPoolStats( UBaseType_t uxPool, HeapPoolStats_t *pxPoolStats ) PRIVILEGED_FUNCTION;
+
 /*
  * Setup the hardware ready for the scheduler to take control.  This generally
  * sets up a tick interrupt and sets timers for the correct tick frequency.
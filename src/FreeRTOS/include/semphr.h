@@ -180,6 +180,26 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define xSemaphoreCreateBinary() xQueueGenericCreate( ( UBaseType_t ) 1, semSEMAPHORE_QUEUE_ITEM_LENGTH, queueQUEUE_TYPE_BINARY_SEMAPHORE )
 
+/**
+ * semphr. h
+ * <pre>SemaphoreHandle_t xSemaphoreCreateBinaryStatic( StaticSemaphore_t *pxSemaphoreBuffer )</pre>
+ *
+ * As xSemaphoreCreateBinary(), but the semaphore is held in pxSemaphoreBuffer,
+ * supplied by the application, instead of memory from the FreeRTOS heap.
+ * Only available when configSUPPORT_STATIC_ALLOCATION is set to 1 in
+ * FreeRTOSConfig.h.  The semaphore is created empty.
+ *
+ * @param pxSemaphoreBuffer Must point to a variable of type StaticSemaphore_t,
+ * which then holds the semaphore's state.
+ *
+ * @return The handle of the semaphore.
+ * \defgroup xSemaphoreCreateBinaryStatic xSemaphoreCreateBinaryStatic
+ * \ingroup Semaphores
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	#define xSemaphoreCreateBinaryStatic( pxStaticSemaphore ) xQueueGenericCreateStatic( ( UBaseType_t ) 1, semSEMAPHORE_QUEUE_ITEM_LENGTH, NULL, ( pxStaticSemaphore ), queueQUEUE_TYPE_BINARY_SEMAPHORE )
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
 /**
  * semphr. h
  * <pre>xSemaphoreTake(
@@ -688,6 +708,26 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define xSemaphoreCreateMutex() xQueueCreateMutex( queueQUEUE_TYPE_MUTEX )
 
+/**
+ * semphr. h
+ * <pre>SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t *pxMutexBuffer )</pre>
+ *
+ * As xSemaphoreCreateMutex(), but the mutex is held in pxMutexBuffer,
+ * supplied by the application, instead of memory from the FreeRTOS heap.
+ * Only available when configSUPPORT_STATIC_ALLOCATION is set to 1 in
+ * FreeRTOSConfig.h.
+ *
+ * @param pxMutexBuffer Must point to a variable of type StaticSemaphore_t,
+ * which then holds the mutex's state.
+ *
+ * @return The handle of the mutex.
+ * \defgroup xSemaphoreCreateMutexStatic xSemaphoreCreateMutexStatic
+ * \ingroup Semaphores
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	#define xSemaphoreCreateMutexStatic( pxMutexBuffer ) xQueueCreateMutexStatic( queueQUEUE_TYPE_MUTEX, ( pxMutexBuffer ) )
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
 
 /**
  * semphr. h
@@ -806,6 +846,31 @@ typedef QueueHandle_t SemaphoreHandle_t;
  */
 #define xSemaphoreCreateCounting( uxMaxCount, uxInitialCount ) xQueueCreateCountingSemaphore( ( uxMaxCount ), ( uxInitialCount ) )
 
+/**
+ * semphr. h
+ * <pre>SemaphoreHandle_t xSemaphoreCreateCountingStatic( UBaseType_t uxMaxCount, UBaseType_t uxInitialCount, StaticSemaphore_t *pxSemaphoreBuffer )</pre>
+ *
+ * As xSemaphoreCreateCounting(), but the semaphore is held in
+ * pxSemaphoreBuffer, supplied by the application, instead of memory from the
+ * FreeRTOS heap.  Only available when configSUPPORT_STATIC_ALLOCATION is set
+ * to 1 in FreeRTOSConfig.h.
+ *
+ * @param uxMaxCount The maximum count value that can be reached.
+ *
+ * @param uxInitialCount The count value assigned to the semaphore when it is
+ * created.
+ *
+ * @param pxSemaphoreBuffer Must point to a variable of type StaticSemaphore_t,
+ * which then holds the semaphore's state.
+ *
+ * @return The handle of the semaphore.
+ * \defgroup xSemaphoreCreateCountingStatic xSemaphoreCreateCountingStatic
+ * \ingroup Semaphores
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	#define xSemaphoreCreateCountingStatic( uxMaxCount, uxInitialCount, pxSemaphoreBuffer ) xQueueCreateCountingSemaphoreStatic( ( uxMaxCount ), ( uxInitialCount ), ( pxSemaphoreBuffer ) )
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
 /**
  * semphr. h
  * <pre>void vSemaphoreDelete( SemaphoreHandle_t xSemaphore );</pre>
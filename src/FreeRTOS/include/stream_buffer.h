@@ -0,0 +1,326 @@
+/*
+ * Stream buffers pass a stream of bytes from one writer to one reader, each
+ * of which may be a task or an interrupt.  Bytes are copied in and out in
+ * blocks with memcpy(), not one item at a time as a queue does, and there is
+ * no lock: the writer only moves the head and the reader only moves the tail.
+ * A task blocked on a stream buffer waits on its direct to task notification
+ * (configUSE_TASK_NOTIFICATIONS), so a wakeup touches no event lists.
+ *
+ * There must only ever be one writer and one reader.  If several tasks or
+ * interrupts write to (or read from) the same stream buffer, the writes (or
+ * reads) must be serialised by the application, with a critical section or a
+ * mutex, and only one of them may block at a time.
+ *
+ * A reader blocked on an empty stream buffer is woken once the buffer holds
+ * at least its trigger level of bytes, or earlier when the writer calls
+ * xStreamBufferSendCompletedFromISR(), which lets a writer that knows where
+ * its records end (a line of text, say) hand each one over whole.
+ *
+ * Message buffers (message_buffer.h) are built on stream buffers.
+ */
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h" must appear in source files before "include stream_buffer.h"
+#endif
+
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * stream_buffer.h
+ *
+ * Type by which stream buffers are referenced.  For example, a call to
+ * xStreamBufferCreateStatic() returns a StreamBufferHandle_t variable that
+ * can then be used as a parameter to xStreamBufferSend(),
+ * xStreamBufferReceive(), etc.
+ */
+typedef void * StreamBufferHandle_t;
+
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+StreamBufferHandle_t xStreamBufferCreateStatic( size_t xBufferSizeBytes,
+                                                size_t xTriggerLevelBytes,
+                                                uint8_t *pucStreamBufferStorageArea,
+                                                StaticStreamBuffer_t *pxStaticStreamBuffer );
+</pre>
+ *
+ * Creates a stream buffer in memory provided by the caller.
+ * configSUPPORT_STATIC_ALLOCATION must be set to 1 in FreeRTOSConfig.h.
+ *
+ * @param xBufferSizeBytes The most bytes the stream buffer can hold at once.
+ *
+ * @param xTriggerLevelBytes The number of bytes that must be in the stream
+ * buffer before a task blocked on it is woken.  0 is taken as 1.
+ *
+ * @param pucStreamBufferStorageArea A uint8_t array of at least
+ * xBufferSizeBytes + 1 bytes, which holds the bytes in the stream buffer.
+ *
+ * @param pxStaticStreamBuffer Holds the stream buffer's data structure.
+ *
+ * @return The handle of the stream buffer, or NULL if a parameter was NULL.
+ *
+ * Example use:
+<pre>
+
+#define STORAGE_SIZE_BYTES 100
+
+// One more byte than the stream buffer holds.
+static uint8_t ucStorageBuffer[ STORAGE_SIZE_BYTES + 1 ];
+static StaticStreamBuffer_t xStreamBufferStruct;
+
+void MyFunction( void )
+{
+StreamBufferHandle_t xStreamBuffer;
+const size_t xTriggerLevel = 1;
+
+	xStreamBuffer = xStreamBufferCreateStatic( STORAGE_SIZE_BYTES,
+											   xTriggerLevel,
+											   ucStorageBuffer,
+											   &xStreamBufferStruct );
+}
+</pre>
+ * \defgroup xStreamBufferCreateStatic xStreamBufferCreateStatic
+ * \ingroup StreamBufferManagement
+ */
+#define xStreamBufferCreateStatic( xBufferSizeBytes, xTriggerLevelBytes, pucStreamBufferStorageArea, pxStaticStreamBuffer ) xStreamBufferGenericCreateStatic( xBufferSizeBytes, xTriggerLevelBytes, pdFALSE, pucStreamBufferStorageArea, pxStaticStreamBuffer )
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+StreamBufferHandle_t xStreamBufferCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes );
+</pre>
+ *
+ * As xStreamBufferCreateStatic(), but the memory is taken from the FreeRTOS
+ * heap.  configSUPPORT_DYNAMIC_ALLOCATION must be set to 1 in
+ * FreeRTOSConfig.h.  Returns NULL if there was not enough heap.
+ *
+ * \defgroup xStreamBufferCreate xStreamBufferCreate
+ * \ingroup StreamBufferManagement
+ */
+#define xStreamBufferCreate( xBufferSizeBytes, xTriggerLevelBytes ) xStreamBufferGenericCreate( xBufferSizeBytes, xTriggerLevelBytes, pdFALSE )
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer,
+                          const void *pvTxData,
+                          size_t xDataLengthBytes,
+                          TickType_t xTicksToWait );
+</pre>
+ *
+ * Copies bytes into a stream buffer.  Only one task or interrupt may write
+ * to a stream buffer (see the note at the top of this file).
+ *
+ * If there is not room for all the bytes the calling task waits, up to
+ * xTicksToWait, for the reader to make room.  If the time runs out as many
+ * bytes as fit are written.
+ *
+ * @param xStreamBuffer The handle of the stream buffer written to.
+ *
+ * @param pvTxData The bytes to copy into the stream buffer.
+ *
+ * @param xDataLengthBytes The number of bytes to copy.
+ *
+ * @param xTicksToWait The most time to wait for enough space.
+ *
+ * @return The number of bytes written.
+ *
+ * \defgroup xStreamBufferSend xStreamBufferSend
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer,
+                                 const void *pvTxData,
+                                 size_t xDataLengthBytes,
+                                 BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of xStreamBufferSend() that can be called from an interrupt
+ * service routine.  It never waits, and writes as many bytes as fit.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if the write took the
+ * stream buffer to its trigger level and woke a task of higher priority
+ * than the task that was interrupted, in which case a context switch should
+ * be requested before the interrupt is exited.
+ *
+ * @return The number of bytes written.
+ *
+ * \defgroup xStreamBufferSendFromISR xStreamBufferSendFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer,
+                             void *pvRxData,
+                             size_t xBufferLengthBytes,
+                             TickType_t xTicksToWait );
+</pre>
+ *
+ * Copies bytes out of a stream buffer.  Only one task or interrupt may read
+ * from a stream buffer (see the note at the top of this file).
+ *
+ * If the stream buffer is empty the calling task waits, up to xTicksToWait,
+ * until the writer takes it to its trigger level or calls
+ * xStreamBufferSendCompletedFromISR().  Whatever is there is then returned,
+ * up to xBufferLengthBytes.
+ *
+ * @param xStreamBuffer The handle of the stream buffer read from.
+ *
+ * @param pvRxData The buffer the bytes are copied into.
+ *
+ * @param xBufferLengthBytes The size of pvRxData, the most bytes returned.
+ *
+ * @param xTicksToWait The most time to wait for bytes to arrive.
+ *
+ * @return The number of bytes read, 0 if the time ran out first.
+ *
+ * \defgroup xStreamBufferReceive xStreamBufferReceive
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer,
+                                    void *pvRxData,
+                                    size_t xBufferLengthBytes,
+                                    BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of xStreamBufferReceive() that can be called from an interrupt
+ * service routine.  It never waits.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if the read woke a writer
+ * waiting for space of higher priority than the task that was interrupted.
+ *
+ * @return The number of bytes read.
+ *
+ * \defgroup xStreamBufferReceiveFromISR xStreamBufferReceiveFromISR
+ * \ingroup StreamBufferManagement
+ */
+size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer );
+</pre>
+ *
+ * Deletes a stream buffer, freeing its memory if it was created with
+ * xStreamBufferCreate().  No task may be blocked on it.
+ *
+ * \defgroup vStreamBufferDelete vStreamBufferDelete
+ * \ingroup StreamBufferManagement
+ */
+void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+BaseType_t xStreamBufferIsFull( StreamBufferHandle_t xStreamBuffer );
+BaseType_t xStreamBufferIsEmpty( StreamBufferHandle_t xStreamBuffer );
+size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer );
+size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer );
+</pre>
+ *
+ * Query how full a stream buffer is.  The answer may be stale by the time it
+ * is used, unless the caller is the reader (for the bytes available) or the
+ * writer (for the space available).
+ *
+ * \defgroup xStreamBufferBytesAvailable xStreamBufferBytesAvailable
+ * \ingroup StreamBufferManagement
+ */
+BaseType_t xStreamBufferIsFull( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+BaseType_t xStreamBufferIsEmpty( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer );
+</pre>
+ *
+ * Empties a stream buffer.  A stream buffer can only be reset when no task
+ * is blocked on it.
+ *
+ * @return pdPASS if the stream buffer was reset, otherwise pdFAIL.
+ *
+ * \defgroup xStreamBufferReset xStreamBufferReset
+ * \ingroup StreamBufferManagement
+ */
+BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel );
+</pre>
+ *
+ * Changes the trigger level of a stream buffer.  0 is taken as 1.
+ *
+ * @return pdPASS, or pdFAIL if xTriggerLevel is above the size of the stream
+ * buffer, in which case the trigger level is left as it was.
+ *
+ * \defgroup xStreamBufferSetTriggerLevel xStreamBufferSetTriggerLevel
+ * \ingroup StreamBufferManagement
+ */
+BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel ) PRIVILEGED_FUNCTION;
+
+/**
+ * stream_buffer.h
+ *
+<pre>
+BaseType_t xStreamBufferSendCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken );
+BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * Wake the task blocked to read from (or write to) a stream buffer now,
+ * whatever the trigger level.  A writer calls
+ * xStreamBufferSendCompletedFromISR() once it has written the end of a
+ * record the reader should see without waiting for more bytes.
+ *
+ * @return pdTRUE if a task was woken, otherwise pdFALSE.
+ *
+ * \defgroup xStreamBufferSendCompletedFromISR xStreamBufferSendCompletedFromISR
+ * \ingroup StreamBufferManagement
+ */
+BaseType_t xStreamBufferSendCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/* Functions below here are not part of the public API. */
+StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer ) PRIVILEGED_FUNCTION;
+StreamBufferHandle_t xStreamBufferGenericCreateStatic( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer, uint8_t * const pucStreamBufferStorageArea, StaticStreamBuffer_t * const pxStaticStreamBuffer ) PRIVILEGED_FUNCTION;
+size_t xStreamBufferNextMessageLengthBytes( StreamBufferHandle_t xStreamBuffer ) PRIVILEGED_FUNCTION;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_BUFFER_H */
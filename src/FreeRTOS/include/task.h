@@ -169,6 +169,16 @@ typedef enum
 	eNoTasksWaitingTimeout	/* No tasks are waiting for a timeout so it is safe to enter a sleep mode that can only be exited by an external interrupt. */
 } eSleepModeStatus;
 
+/* Actions that can be performed when vTaskNotify() is called. */
+typedef enum
+{
+	eNoAction = 0,				/* Notify the task without updating its notify value. */
+	eSetBits,					/* Set bits in the task's notification value. */
+	eIncrement,					/* Increment the task's notification value. */
+	eSetValueWithOverwrite,		/* Set the task's notification value to a specific value even if the previous value has not yet been read by the task. */
+	eSetValueWithoutOverwrite	/* Set the task's notification value if the previous value has been read by the task. */
+} eNotifyAction;
+
 
 /**
  * Defines the priority used by the idle task.  This must not be modified.
@@ -329,6 +339,73 @@ is used in assert() statements. */
  */
 #define xTaskCreate( pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask ) xTaskGenericCreate( ( pvTaskCode ), ( pcName ), ( usStackDepth ), ( pvParameters ), ( uxPriority ), ( pxCreatedTask ), ( NULL ), ( NULL ) )
 
+/**
+ * task. h
+ *<pre>
+ TaskHandle_t xTaskCreateStatic( TaskFunction_t pvTaskCode,
+								 const char * const pcName,
+								 uint32_t ulStackDepth,
+								 void *pvParameters,
+								 UBaseType_t uxPriority,
+								 StackType_t *pxStackBuffer,
+								 StaticTask_t *pxTaskBuffer );</pre>
+ *
+ * Create a new task and add it to the list of tasks that are ready to run,
+ * using memory supplied by the application instead of memory allocated from
+ * the FreeRTOS heap.  Only available when configSUPPORT_STATIC_ALLOCATION is
+ * set to 1 in FreeRTOSConfig.h.
+ *
+ * @param pvTaskCode Pointer to the task entry function.  Tasks
+ * must be implemented to never return (i.e. continuous loop).
+ *
+ * @param pcName A descriptive name for the task.
+ *
+ * @param ulStackDepth The size of the task stack specified as the number of
+ * variables the stack can hold - not the number of bytes.  pxStackBuffer
+ * must hold at least this many StackType_t variables.
+ *
+ * @param pvParameters Pointer that will be used as the parameter for the task
+ * being created.
+ *
+ * @param uxPriority The priority at which the task will run.
+ *
+ * @param pxStackBuffer Must point to a StackType_t array that has at least
+ * ulStackDepth indexes - the array will then be used as the task's stack,
+ * removing the need for the stack to be allocated dynamically.
+ *
+ * @param pxTaskBuffer Must point to a variable of type StaticTask_t, which will
+ * then be used to hold the task's data structures, removing the need for the
+ * memory to be allocated dynamically.
+ *
+ * @return The handle of the task, or NULL if either buffer is NULL.  The
+ * memory is never freed by the kernel, even if the task is deleted.
+ *
+ * Example usage:
+   <pre>
+ #define STACK_SIZE 200
+
+ // Structure that will hold the TCB of the task being created.
+ StaticTask_t xTaskBuffer;
+
+ // Buffer that the task being created will use as its stack.
+ StackType_t xStack[ STACK_SIZE ];
+
+ void vOtherFunction( void )
+ {
+ TaskHandle_t xHandle = NULL;
+
+	 // Create the task without using any dynamic memory allocation.
+	 xHandle = xTaskCreateStatic( vTaskCode, "NAME", STACK_SIZE, NULL, tskIDLE_PRIORITY, xStack, &xTaskBuffer );
+	 configASSERT( xHandle );
+ }
+   </pre>
+ * \defgroup xTaskCreateStatic xTaskCreateStatic
+ * \ingroup Tasks
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	TaskHandle_t xTaskCreateStatic( TaskFunction_t pxTaskCode, const char * const pcName, const uint32_t ulStackDepth, void * const pvParameters, UBaseType_t uxPriority, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
 /**
  * task. h
  *<pre>
@@ -1358,6 +1435,159 @@ void vTaskList( char * pcWriteBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unquali
  */
 void vTaskGetRunTimeStats( char *pcWriteBuffer ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
+/**
+ * task. h
+ * <PRE>BaseType_t xTaskNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction );</PRE>
+ *
+ * configUSE_TASK_NOTIFICATIONS must be undefined or defined as 1 for this
+ * function to be available.
+ *
+ * Each task has a 32-bit notification value that is initialised to zero when
+ * the task is created.  A notification is an event sent directly to a task
+ * that can unblock the receiving task, and optionally update the receiving
+ * task's notification value.  No intermediary object (queue, semaphore or
+ * event group) is needed, so a notification is both faster and smaller than
+ * giving a semaphore, at the cost of there being only one notification value
+ * per task and only one task able to wait on it.
+ *
+ * A task waits for a notification with xTaskNotifyWait() or, when the value is
+ * used as a counting semaphore, ulTaskNotifyTake().  A task blocked to wait for
+ * a notification does not consume any CPU time.
+ *
+ * @param xTaskToNotify The handle of the task being notified.
+ *
+ * @param ulValue Data that can be sent with the notification, used as
+ * described by eAction.
+ *
+ * @param eAction How the notification value of the receiving task is updated:
+ *
+ * eSetBits - ORed with ulValue.  Always returns pdPASS.
+ *
+ * eIncrement - incremented, ulValue is not used.  Always returns pdPASS.
+ *
+ * eSetValueWithOverwrite - set to ulValue, even if the task had not yet read
+ * the previous value.  Always returns pdPASS.
+ *
+ * eSetValueWithoutOverwrite - set to ulValue if the task has no notification
+ * pending, otherwise left as it is and pdFAIL is returned.
+ *
+ * eNoAction - the task is notified without its value being changed.  Always
+ * returns pdPASS.
+ *
+ * @return Dependent on eAction, see above.
+ *
+ * \defgroup xTaskNotify xTaskNotify
+ * \ingroup TaskNotifications
+ */
+BaseType_t xTaskGenericNotify( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue ) PRIVILEGED_FUNCTION;
+#define xTaskNotify( xTaskToNotify, ulValue, eAction ) xTaskGenericNotify( ( xTaskToNotify ), ( ulValue ), ( eAction ), NULL )
+#define xTaskNotifyAndQuery( xTaskToNotify, ulValue, eAction, pulPreviousNotifyValue ) xTaskGenericNotify( ( xTaskToNotify ), ( ulValue ), ( eAction ), ( pulPreviousNotifyValue ) )
+
+/**
+ * task. h
+ * <PRE>BaseType_t xTaskNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken );</PRE>
+ *
+ * A version of xTaskNotify() that can be used from an interrupt service
+ * routine.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if sending the notification
+ * unblocked a task of higher priority than the task that was interrupted, in
+ * which case a context switch should be requested before the interrupt is
+ * exited.
+ *
+ * \defgroup xTaskNotifyFromISR xTaskNotifyFromISR
+ * \ingroup TaskNotifications
+ */
+BaseType_t xTaskGenericNotifyFromISR( TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+#define xTaskNotifyFromISR( xTaskToNotify, ulValue, eAction, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( ulValue ), ( eAction ), NULL, ( pxHigherPriorityTaskWoken ) )
+#define xTaskNotifyAndQueryFromISR( xTaskToNotify, ulValue, eAction, pulPreviousNotificationValue, pxHigherPriorityTaskWoken ) xTaskGenericNotifyFromISR( ( xTaskToNotify ), ( ulValue ), ( eAction ), ( pulPreviousNotificationValue ), ( pxHigherPriorityTaskWoken ) )
+
+/**
+ * task. h
+ * <PRE>BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait );</PRE>
+ *
+ * Waits, optionally in the Blocked state, for the calling task to receive a
+ * notification.
+ *
+ * @param ulBitsToClearOnEntry Bits cleared in the notification value before
+ * waiting, if no notification is already pending.
+ *
+ * @param ulBitsToClearOnExit Bits cleared in the notification value before
+ * returning, if a notification was received.
+ *
+ * @param pulNotificationValue Receives the notification value, before
+ * ulBitsToClearOnExit is applied.  May be NULL.
+ *
+ * @param xTicksToWait The maximum time to wait in the Blocked state.
+ *
+ * @return pdTRUE if a notification was received (or was already pending),
+ * pdFALSE if the call timed out.
+ *
+ * \defgroup xTaskNotifyWait xTaskNotifyWait
+ * \ingroup TaskNotifications
+ */
+BaseType_t xTaskNotifyWait( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <PRE>BaseType_t xTaskNotifyGive( TaskHandle_t xTaskToNotify );</PRE>
+ *
+ * Increments the notification value of a task, so the value can be used as a
+ * lighter weight binary or counting semaphore.  The receiving task takes it
+ * with ulTaskNotifyTake().  Always returns pdPASS.
+ *
+ * \defgroup xTaskNotifyGive xTaskNotifyGive
+ * \ingroup TaskNotifications
+ */
+#define xTaskNotifyGive( xTaskToNotify ) xTaskGenericNotify( ( xTaskToNotify ), ( 0 ), eIncrement, NULL )
+
+/**
+ * task. h
+ * <PRE>void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken );</PRE>
+ *
+ * A version of xTaskNotifyGive() that can be called from an interrupt service
+ * routine, the equivalent of xSemaphoreGiveFromISR().
+ *
+ * \defgroup vTaskNotifyGiveFromISR vTaskNotifyGiveFromISR
+ * \ingroup TaskNotifications
+ */
+void vTaskNotifyGiveFromISR( TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <PRE>uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait );</PRE>
+ *
+ * Waits, optionally in the Blocked state, for the calling task's notification
+ * value to be non-zero, the equivalent of xSemaphoreTake().
+ *
+ * @param xClearCountOnExit If pdFALSE the notification value is decremented
+ * before returning, so it behaves as a counting semaphore.  Otherwise it is
+ * cleared to zero, so it behaves as a binary semaphore.
+ *
+ * @param xTicksToWait The maximum time to wait in the Blocked state.
+ *
+ * @return The notification value before it was decremented or cleared, zero
+ * if the call timed out.
+ *
+ * \defgroup ulTaskNotifyTake ulTaskNotifyTake
+ * \ingroup TaskNotifications
+ */
+uint32_t ulTaskNotifyTake( BaseType_t xClearCountOnExit, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * <PRE>BaseType_t xTaskNotifyStateClear( TaskHandle_t xTask );</PRE>
+ *
+ * Clears a pending notification of xTask, or of the calling task if xTask is
+ * NULL, without changing its notification value.
+ *
+ * @return pdPASS if a notification was pending, otherwise pdFAIL.
+ *
+ * \defgroup xTaskNotifyStateClear xTaskNotifyStateClear
+ * \ingroup TaskNotifications
+ */
+BaseType_t xTaskNotifyStateClear( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
 /*-----------------------------------------------------------
  * SCHEDULER INTERNALS AVAILABLE FOR PORTING PURPOSES
  *----------------------------------------------------------*/
@@ -1515,6 +1745,16 @@ void vTaskPriorityDisinherit( TaskHandle_t const pxMutexHolder ) PRIVILEGED_FUNC
  */
 BaseType_t xTaskGenericCreate( TaskFunction_t pxTaskCode, const char * const pcName, const uint16_t usStackDepth, void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask, StackType_t * const puxStackBuffer, const MemoryRegion_t * const xRegions ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
+/*
+ * When configSUPPORT_STATIC_ALLOCATION is 1 the application must provide the
+ * memory for the idle task, which vTaskStartScheduler() creates, by
+ * implementing this function.  The TCB and stack must stay valid for as long
+ * as the scheduler runs, so are normally declared static.
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize );
+#endif
+
 /*
  * Get the uxTCBNumber assigned to the task referenced by the xTask parameter.
  */
@@ -84,6 +84,11 @@ task.h is included from an application file. */
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
+/* With only static allocation there is no heap to manage, and no ucHeap
+array to take RAM.  Any remaining call to pvPortMalloc() fails to link.  With
+configUSE_TLSF_HEAP set heap_tlsf.c provides the heap instead. */
+#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_TLSF_HEAP == 0 ) )
+
 /* A few bytes might be lost to byte aligning the heap start address. */
 #define configADJUSTED_HEAP_SIZE	( configTOTAL_HEAP_SIZE - portBYTE_ALIGNMENT )
 
@@ -297,3 +302,5 @@ uint8_t *pucAlignedHeap;
 	pxFirstFreeBlock->pxNextFreeBlock = &xEnd;
 }
 /*-----------------------------------------------------------*/
+
+#endif /* ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_TLSF_HEAP == 0 ) */
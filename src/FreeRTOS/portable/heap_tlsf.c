@@ -0,0 +1,673 @@
+/*
+ * An implementation of pvPortMalloc() and vPortFree() whose run time does not
+ * depend on the number or layout of the blocks in the heap, and which combines
+ * adjacent free blocks so the heap does not fragment the way heap_2.c does.
+ *
+ * Free blocks are kept in a two level segregated fit (TLSF) index: the first
+ * level splits sizes by power of two, the second splits each power of two
+ * into heapSL_COUNT equal ranges, and a bitmap at each level records which
+ * lists hold blocks.  A request is rounded up to the start of the next range,
+ * so the head of any non empty list at or above it fits, and the list is
+ * found with two count leading zeros instructions.  Every block records the
+ * physical block before it and the end of the heap is marked by a used
+ * sentinel, so a freed block is merged with both of its neighbours at once.
+ * Both pvPortMalloc() and vPortFree() are O(1).
+ *
+ * Requests up to a size class can also be served from fixed size pools,
+ * configured with configHEAP_POOL_SIZES and configHEAP_POOL_BLOCKS (both
+ * array initialisers, sizes in ascending order).  The pools are carved out of
+ * the heap on first use.  A request goes to the first pool whose blocks are
+ * large enough, and to the general heap when that pool is empty.
+ *
+ * vPortGetHeapStats() and xPortGetHeapPoolStats() report the state of the
+ * heap and of each pool, so fragmentation can be watched over a long run.
+ * tools/heap_soak builds this file on the host and soaks it with random
+ * requests.
+ *
+ * Select this file with configUSE_TLSF_HEAP, in place of heap_2.c.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_TLSF_HEAP == 1 ) )
+
+#if( portBYTE_ALIGNMENT == 8 )
+	#define heapALIGNMENT_LOG2		3
+#elif( portBYTE_ALIGNMENT == 4 )
+	#define heapALIGNMENT_LOG2		2
+#else
+	#error heap_tlsf.c supports a portBYTE_ALIGNMENT of 4 or 8 only.
+#endif
+
+/* Second level lists per power of two.  Sizes below heapSMALL_BLOCK_SIZE
+all go in the first first level list, heapSL_COUNT lists one alignment unit
+apart. */
+#define heapSL_LOG2				3
+#define heapSL_COUNT			( 1UL << heapSL_LOG2 )
+#define heapFL_SHIFT			( heapSL_LOG2 + heapALIGNMENT_LOG2 )
+#define heapSMALL_BLOCK_SIZE	( ( size_t ) 1 << heapFL_SHIFT )
+
+/* The heap, configTOTAL_HEAP_SIZE, must be below 2 ^ heapFL_MAX_LOG2. */
+#define heapFL_MAX_LOG2			16
+#define heapFL_COUNT			( heapFL_MAX_LOG2 - heapFL_SHIFT + 1 )
+
+/* Set in xSize while a block is free.  Block sizes are a multiple of the
+alignment, so the bit is otherwise always clear. */
+#define heapBLOCK_FREE			( ( size_t ) 1 )
+
+/* Every block, used or free, starts with the header fields of HeapBlock_t.
+The free list links are only valid while the block is free, and then live
+in what is otherwise the caller's memory. */
+typedef struct HEAP_BLOCK
+{
+	struct HEAP_BLOCK *pxPrevPhysBlock;		/*<< The block just below this one in memory, NULL for the first. */
+	size_t xSize;							/*<< Size of the whole block, header included, with heapBLOCK_FREE. */
+	struct HEAP_BLOCK *pxNextFreeBlock;		/*<< Next block in the same free list. */
+	struct HEAP_BLOCK *pxPrevFreeBlock;		/*<< Previous block in the same free list. */
+} HeapBlock_t;
+
+#define heapROUND_UP( x )		( ( ( x ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+#define heapHEADER_SIZE			heapROUND_UP( sizeof( struct HEAP_BLOCK * ) + sizeof( size_t ) )
+#define heapMINIMUM_BLOCK_SIZE	heapROUND_UP( sizeof( HeapBlock_t ) )
+#define heapBLOCK_SIZE( pxBlock )	( ( pxBlock )->xSize & ~heapBLOCK_FREE )
+#define heapNEXT_BLOCK( pxBlock )	( ( HeapBlock_t * ) ( ( ( uint8_t * ) ( pxBlock ) ) + heapBLOCK_SIZE( pxBlock ) ) )
+
+/* Index of the most and least significant set bit, the value must not be 0.
+On the Cortex-M3 each is a CLZ instruction (with an RBIT for the second). */
+#define heapFLS( x )			( ( UBaseType_t ) ( 31 - __builtin_clz( ( uint32_t ) ( x ) ) ) )
+#define heapFFS( x )			( ( UBaseType_t ) ( __builtin_ctz( ( uint32_t ) ( x ) ) ) )
+
+/* Allocate the memory for the heap. */
+static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+
+/* The free list index. */
+static HeapBlock_t *pxFreeLists[ heapFL_COUNT ][ heapSL_COUNT ];
+static uint32_t ulFLBitmap = 0;
+static uint32_t ulSLBitmap[ heapFL_COUNT ];
+
+static BaseType_t xHeapHasBeenInitialised = pdFALSE;
+static HeapBlock_t *pxFirstBlock = NULL;
+
+/* Statistics.  xFreeBytesRemaining counts free pool blocks as well as the
+free blocks of the general heap. */
+static size_t xFreeBytesRemaining = 0;
+static size_t xMinimumEverFreeBytesRemaining = 0;
+static size_t xNumberOfSuccessfulAllocations = 0;
+static size_t xNumberOfSuccessfulFrees = 0;
+static size_t xNumberOfFailedAllocations = 0;
+
+#ifdef configHEAP_POOL_SIZES
+
+	typedef struct HEAP_POOL
+	{
+		uint8_t *pucStart;					/*<< First byte of the pool, NULL if it could not be created. */
+		uint8_t *pucEnd;					/*<< One past the last byte of the pool. */
+		void *pvFreeList;					/*<< Free blocks, linked through their first word. */
+		size_t xBlockSize;
+		size_t xNumberOfBlocks;
+		size_t xNumberOfFreeBlocks;
+		size_t xMinimumEverFreeBlocks;
+		size_t xNumberOfAllocations;
+		size_t xNumberOfMisses;
+	} HeapPool_t;
+
+	static const uint16_t usPoolSizes[] = configHEAP_POOL_SIZES;
+	static const uint16_t usPoolBlocks[] = configHEAP_POOL_BLOCKS;
+	#define heapNUM_POOLS	( sizeof( usPoolSizes ) / sizeof( usPoolSizes[ 0 ] ) )
+
+	static HeapPool_t xPools[ heapNUM_POOLS ];
+
+#endif /* configHEAP_POOL_SIZES */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Initialises the heap structures before their first use.
+ */
+static void prvHeapInit( void );
+
+/*
+ * The first and second level list a block of xSize bytes is kept in.
+ */
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL );
+
+/*
+ * Add a block to, or take it out of, the free list for its size.
+ */
+static void prvInsertFreeBlock( HeapBlock_t *pxBlock );
+static void prvRemoveFreeBlock( HeapBlock_t *pxBlock );
+
+/*
+ * Allocate or free a block of the general heap.  xBlockSize includes the
+ * header and is aligned.  Called with the scheduler suspended.
+ */
+static HeapBlock_t *prvBlockAllocate( size_t xBlockSize );
+static void prvBlockFree( HeapBlock_t *pxBlock );
+
+#ifdef configHEAP_POOL_SIZES
+
+	/*
+	 * Carve the pools out of the general heap.
+	 */
+	static void prvPoolsInit( void );
+
+#endif /* configHEAP_POOL_SIZES */
+
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+HeapBlock_t *pxBlock;
+size_t xBlockSize;
+void *pvReturn = NULL;
+
+	vTaskSuspendAll();
+	{
+		/* If this is the first call to malloc then the heap will require
+		initialisation to setup the free lists. */
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+
+		#ifdef configHEAP_POOL_SIZES
+		{
+		UBaseType_t uxPool;
+		HeapPool_t *pxPool;
+
+			/* The first pool of a large enough size class serves the request
+			if it has a block left. */
+			for( uxPool = 0; uxPool < heapNUM_POOLS; uxPool++ )
+			{
+				pxPool = &xPools[ uxPool ];
+
+				if( ( xWantedSize > 0 ) && ( xWantedSize <= pxPool->xBlockSize ) && ( pxPool->pucStart != NULL ) )
+				{
+					if( pxPool->pvFreeList != NULL )
+					{
+						pvReturn = pxPool->pvFreeList;
+						pxPool->pvFreeList = *( ( void ** ) pvReturn );
+
+						pxPool->xNumberOfFreeBlocks--;
+						if( pxPool->xNumberOfFreeBlocks < pxPool->xMinimumEverFreeBlocks )
+						{
+							pxPool->xMinimumEverFreeBlocks = pxPool->xNumberOfFreeBlocks;
+						}
+						pxPool->xNumberOfAllocations++;
+						xFreeBytesRemaining -= pxPool->xBlockSize;
+					}
+					else
+					{
+						pxPool->xNumberOfMisses++;
+					}
+					break;
+				}
+			}
+		}
+		#endif /* configHEAP_POOL_SIZES */
+
+		/* The wanted size is increased so it can contain the block header
+		in addition to the requested amount of bytes, and must leave room
+		for the free list links once the block is freed. */
+		if( ( pvReturn == NULL ) && ( xWantedSize > 0 ) && ( xWantedSize < configTOTAL_HEAP_SIZE ) )
+		{
+			xBlockSize = heapROUND_UP( xWantedSize + heapHEADER_SIZE );
+			if( xBlockSize < heapMINIMUM_BLOCK_SIZE )
+			{
+				xBlockSize = heapMINIMUM_BLOCK_SIZE;
+			}
+
+			pxBlock = prvBlockAllocate( xBlockSize );
+			if( pxBlock != NULL )
+			{
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE );
+			}
+		}
+
+		if( pvReturn != NULL )
+		{
+			if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+			{
+				xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+			}
+			xNumberOfSuccessfulAllocations++;
+		}
+		else
+		{
+			xNumberOfFailedAllocations++;
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+	}
+	#endif
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+uint8_t *puc = ( uint8_t * ) pv;
+HeapBlock_t *pxBlock;
+
+	if( pv != NULL )
+	{
+		vTaskSuspendAll();
+		{
+			#ifdef configHEAP_POOL_SIZES
+			{
+			UBaseType_t uxPool;
+			HeapPool_t *pxPool;
+
+				for( uxPool = 0; uxPool < heapNUM_POOLS; uxPool++ )
+				{
+					pxPool = &xPools[ uxPool ];
+
+					if( ( puc >= pxPool->pucStart ) && ( puc < pxPool->pucEnd ) )
+					{
+						*( ( void ** ) pv ) = pxPool->pvFreeList;
+						pxPool->pvFreeList = pv;
+						pxPool->xNumberOfFreeBlocks++;
+						xFreeBytesRemaining += pxPool->xBlockSize;
+						xNumberOfSuccessfulFrees++;
+						traceFREE( pv, pxPool->xBlockSize );
+						puc = NULL;
+						break;
+					}
+				}
+			}
+			#endif /* configHEAP_POOL_SIZES */
+
+			if( puc != NULL )
+			{
+				/* The memory being freed will have a block header immediately
+				before it. */
+				pxBlock = ( void * ) ( puc - heapHEADER_SIZE );
+				configASSERT( ( pxBlock->xSize & heapBLOCK_FREE ) == 0 );
+
+				traceFREE( pv, heapBLOCK_SIZE( pxBlock ) );
+				prvBlockFree( pxBlock );
+				xNumberOfSuccessfulFrees++;
+			}
+		}
+		( void ) xTaskResumeAll();
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+HeapBlock_t *pxBlock;
+size_t xBlockSize, xLargest = 0, xSmallest = ( size_t ) -1, xBlocks = 0;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapHasBeenInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+
+		/* Walk the heap in address order, up to the sentinel. */
+		for( pxBlock = pxFirstBlock; heapBLOCK_SIZE( pxBlock ) != 0; pxBlock = heapNEXT_BLOCK( pxBlock ) )
+		{
+			if( ( pxBlock->xSize & heapBLOCK_FREE ) != 0 )
+			{
+				xBlockSize = heapBLOCK_SIZE( pxBlock );
+				xBlocks++;
+
+				if( xBlockSize > xLargest )
+				{
+					xLargest = xBlockSize;
+				}
+				if( xBlockSize < xSmallest )
+				{
+					xSmallest = xBlockSize;
+				}
+			}
+		}
+
+		pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+		pxHeapStats->xSizeOfLargestFreeBlockInBytes = xLargest;
+		pxHeapStats->xSizeOfSmallestFreeBlockInBytes = ( xBlocks != 0 ) ? xSmallest : 0;
+		pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+		pxHeapStats->xNumberOfFailedAllocations = xNumberOfFailedAllocations;
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGetHeapPoolStats( UBaseType_t uxPool, HeapPoolStats_t *pxPoolStats )
+{
+BaseType_t xReturn = pdFAIL;
+
+	#ifdef configHEAP_POOL_SIZES
+	{
+	HeapPool_t *pxPool;
+
+		if( uxPool < heapNUM_POOLS )
+		{
+			vTaskSuspendAll();
+			{
+				if( xHeapHasBeenInitialised == pdFALSE )
+				{
+					prvHeapInit();
+				}
+
+				pxPool = &xPools[ uxPool ];
+				pxPoolStats->xBlockSize = pxPool->xBlockSize;
+				pxPoolStats->xNumberOfBlocks = pxPool->xNumberOfBlocks;
+				pxPoolStats->xNumberOfFreeBlocks = pxPool->xNumberOfFreeBlocks;
+				pxPoolStats->xMinimumEverFreeBlocks = pxPool->xMinimumEverFreeBlocks;
+				pxPoolStats->xNumberOfAllocations = pxPool->xNumberOfAllocations;
+				pxPoolStats->xNumberOfMisses = pxPool->xNumberOfMisses;
+			}
+			( void ) xTaskResumeAll();
+
+			xReturn = pdPASS;
+		}
+	}
+	#else
+	{
+		( void ) uxPool;
+		( void ) pxPoolStats;
+	}
+	#endif /* configHEAP_POOL_SIZES */
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxBit;
+
+	if( xSize < heapSMALL_BLOCK_SIZE )
+	{
+		/* Small blocks are spread linearly over the first list. */
+		*puxFL = 0;
+		*puxSL = ( UBaseType_t ) ( xSize >> heapALIGNMENT_LOG2 );
+	}
+	else
+	{
+		uxBit = heapFLS( xSize );
+		*puxSL = ( UBaseType_t ) ( ( xSize >> ( uxBit - heapSL_LOG2 ) ) ^ heapSL_COUNT );
+		*puxFL = uxBit - heapFL_SHIFT + 1;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( HeapBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMappingInsert( heapBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	pxBlock->xSize |= heapBLOCK_FREE;
+	pxBlock->pxPrevFreeBlock = NULL;
+	pxBlock->pxNextFreeBlock = pxFreeLists[ uxFL ][ uxSL ];
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock;
+	}
+	pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+
+	ulFLBitmap |= ( 1UL << uxFL );
+	ulSLBitmap[ uxFL ] |= ( 1UL << uxSL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( HeapBlock_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMappingInsert( heapBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		/* The block was the head of its list. */
+		pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFreeBlock;
+
+		if( pxFreeLists[ uxFL ][ uxSL ] == NULL )
+		{
+			ulSLBitmap[ uxFL ] &= ~( 1UL << uxSL );
+			if( ulSLBitmap[ uxFL ] == 0 )
+			{
+				ulFLBitmap &= ~( 1UL << uxFL );
+			}
+		}
+	}
+
+	pxBlock->xSize &= ~heapBLOCK_FREE;
+}
+/*-----------------------------------------------------------*/
+
+static HeapBlock_t *prvBlockAllocate( size_t xBlockSize )
+{
+HeapBlock_t *pxBlock, *pxRemainder;
+UBaseType_t uxFL, uxSL;
+uint32_t ulMap;
+size_t xSearchSize = xBlockSize;
+
+	/* Round the size up to the start of the next second level range, so
+	that any block in the list found is large enough. */
+	if( xSearchSize >= heapSMALL_BLOCK_SIZE )
+	{
+		xSearchSize += ( ( size_t ) 1 << ( heapFLS( xSearchSize ) - heapSL_LOG2 ) ) - 1;
+	}
+	prvMappingInsert( xSearchSize, &uxFL, &uxSL );
+
+	if( uxFL >= heapFL_COUNT )
+	{
+		return NULL;
+	}
+
+	/* A list in the same power of two, or failing that the smallest list
+	of a larger one. */
+	ulMap = ulSLBitmap[ uxFL ] & ( ~0UL << uxSL );
+	if( ulMap == 0 )
+	{
+		ulMap = ulFLBitmap & ( ~0UL << ( uxFL + 1 ) );
+		if( ulMap == 0 )
+		{
+			return NULL;
+		}
+
+		uxFL = heapFFS( ulMap );
+		ulMap = ulSLBitmap[ uxFL ];
+	}
+	uxSL = heapFFS( ulMap );
+
+	pxBlock = pxFreeLists[ uxFL ][ uxSL ];
+	prvRemoveFreeBlock( pxBlock );
+
+	/* If the block is larger than required, the end of it goes back into
+	the free lists.  Its upper neighbour is in use, or the two would already
+	have been merged. */
+	if( ( heapBLOCK_SIZE( pxBlock ) - xBlockSize ) >= heapMINIMUM_BLOCK_SIZE )
+	{
+		pxRemainder = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+		pxRemainder->xSize = heapBLOCK_SIZE( pxBlock ) - xBlockSize;
+		pxRemainder->pxPrevPhysBlock = pxBlock;
+		heapNEXT_BLOCK( pxRemainder )->pxPrevPhysBlock = pxRemainder;
+		pxBlock->xSize = xBlockSize;
+
+		prvInsertFreeBlock( pxRemainder );
+	}
+
+	xFreeBytesRemaining -= heapBLOCK_SIZE( pxBlock );
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBlockFree( HeapBlock_t *pxBlock )
+{
+HeapBlock_t *pxNeighbour;
+
+	xFreeBytesRemaining += heapBLOCK_SIZE( pxBlock );
+
+	/* Merge with the block above.  The sentinel is never free. */
+	pxNeighbour = heapNEXT_BLOCK( pxBlock );
+	if( ( pxNeighbour->xSize & heapBLOCK_FREE ) != 0 )
+	{
+		prvRemoveFreeBlock( pxNeighbour );
+		pxBlock->xSize += pxNeighbour->xSize;
+		heapNEXT_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+	}
+
+	/* Merge with the block below. */
+	pxNeighbour = pxBlock->pxPrevPhysBlock;
+	if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xSize & heapBLOCK_FREE ) != 0 ) )
+	{
+		prvRemoveFreeBlock( pxNeighbour );
+		pxNeighbour->xSize += pxBlock->xSize;
+		pxBlock = pxNeighbour;
+		heapNEXT_BLOCK( pxBlock )->pxPrevPhysBlock = pxBlock;
+	}
+
+	prvInsertFreeBlock( pxBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+HeapBlock_t *pxSentinel;
+uint8_t *pucAlignedHeap;
+size_t xHeapSize;
+
+	/* The first level index has to reach the largest block. */
+	configASSERT( configTOTAL_HEAP_SIZE < ( ( size_t ) 1 << heapFL_MAX_LOG2 ) );
+
+	xHeapHasBeenInitialised = pdTRUE;
+
+	/* Ensure the heap starts and ends on a correctly aligned boundary. */
+	pucAlignedHeap = ( uint8_t * ) ( ( ( portPOINTER_SIZE_TYPE ) &ucHeap[ portBYTE_ALIGNMENT_MASK ] ) & ( ( portPOINTER_SIZE_TYPE ) ~portBYTE_ALIGNMENT_MASK ) );
+	xHeapSize = ( configTOTAL_HEAP_SIZE - ( size_t ) ( pucAlignedHeap - ucHeap ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	/* One free block takes the whole heap but for a used, zero sized
+	sentinel header at the end, which stops merges and walks. */
+	pxFirstBlock = ( void * ) pucAlignedHeap;
+	pxFirstBlock->pxPrevPhysBlock = NULL;
+	pxFirstBlock->xSize = xHeapSize - heapHEADER_SIZE;
+
+	pxSentinel = heapNEXT_BLOCK( pxFirstBlock );
+	pxSentinel->pxPrevPhysBlock = pxFirstBlock;
+	pxSentinel->xSize = 0;
+
+	prvInsertFreeBlock( pxFirstBlock );
+	xFreeBytesRemaining = heapBLOCK_SIZE( pxFirstBlock );
+
+	#ifdef configHEAP_POOL_SIZES
+	{
+		prvPoolsInit();
+	}
+	#endif /* configHEAP_POOL_SIZES */
+
+	xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+#ifdef configHEAP_POOL_SIZES
+
+	static void prvPoolsInit( void )
+	{
+	UBaseType_t uxPool;
+	HeapPool_t *pxPool;
+	HeapBlock_t *pxBlock;
+	size_t xBlock;
+	uint8_t *puc;
+
+		configASSERT( sizeof( usPoolBlocks ) == sizeof( usPoolSizes ) );
+
+		for( uxPool = 0; uxPool < heapNUM_POOLS; uxPool++ )
+		{
+			pxPool = &xPools[ uxPool ];
+
+			/* Size classes must ascend, so a request finds the smallest one
+			that fits. */
+			configASSERT( ( uxPool == 0 ) || ( usPoolSizes[ uxPool ] > usPoolSizes[ uxPool - 1 ] ) );
+
+			/* Each free block holds the free list link. */
+			pxPool->xBlockSize = heapROUND_UP( ( size_t ) usPoolSizes[ uxPool ] );
+			if( pxPool->xBlockSize < sizeof( void * ) )
+			{
+				pxPool->xBlockSize = heapROUND_UP( sizeof( void * ) );
+			}
+
+			pxBlock = prvBlockAllocate( heapROUND_UP( pxPool->xBlockSize * usPoolBlocks[ uxPool ] + heapHEADER_SIZE ) );
+			configASSERT( pxBlock != NULL );
+
+			if( pxBlock != NULL )
+			{
+				pxPool->pucStart = ( ( uint8_t * ) pxBlock ) + heapHEADER_SIZE;
+				pxPool->pucEnd = pxPool->pucStart + ( pxPool->xBlockSize * usPoolBlocks[ uxPool ] );
+				pxPool->xNumberOfBlocks = usPoolBlocks[ uxPool ];
+
+				/* Link the blocks in address order. */
+				for( xBlock = pxPool->xNumberOfBlocks; xBlock > 0; xBlock-- )
+				{
+					puc = pxPool->pucStart + ( ( xBlock - 1 ) * pxPool->xBlockSize );
+					*( ( void ** ) puc ) = pxPool->pvFreeList;
+					pxPool->pvFreeList = puc;
+				}
+
+				pxPool->xNumberOfFreeBlocks = pxPool->xNumberOfBlocks;
+				pxPool->xMinimumEverFreeBlocks = pxPool->xNumberOfBlocks;
+				xFreeBytesRemaining += pxPool->xBlockSize * pxPool->xNumberOfBlocks;
+			}
+		}
+	}
+
+#endif /* configHEAP_POOL_SIZES */
+/*-----------------------------------------------------------*/
+
+#endif /* ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) && ( configUSE_TLSF_HEAP == 1 ) */
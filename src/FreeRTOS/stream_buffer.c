@@ -0,0 +1,784 @@
+/*
+ * Stream buffers and message buffers: a single reader, single writer byte
+ * ring with block copies in and out, see stream_buffer.h and
+ * message_buffer.h.
+ *
+ * The ring has one byte more storage than it can hold, so head == tail means
+ * empty without a separate count.  Only the writer moves xHead and only the
+ * reader moves xTail, each after its bytes have been copied, so neither needs
+ * a lock to see a consistent ring.  Critical sections are only taken around
+ * the decision to block, so a wakeup sent between the check and the wait is
+ * not lost: the waiting task's handle is published, and its notification
+ * state cleared, inside the same critical section as the check.
+ */
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stream_buffer.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_TASK_NOTIFICATIONS != 1 )
+	#error configUSE_TASK_NOTIFICATIONS must be set to 1 to build stream_buffer.c
+#endif
+
+/* Each message in a message buffer is stored behind its length. */
+#define sbBYTES_TO_STORE_MESSAGE_LENGTH		( sizeof( size_t ) )
+
+/* Bits in ucFlags. */
+#define sbFLAGS_IS_MESSAGE_BUFFER			( ( uint8_t ) 1 )
+#define sbFLAGS_IS_STATICALLY_ALLOCATED		( ( uint8_t ) 2 )
+
+/* Keeps the compiler from moving the copy of the bytes past the index that
+publishes them. */
+#define sbCOMPILER_BARRIER()				__asm volatile( "" ::: "memory" )
+
+/* Wake the task blocked to read, if there is one.  The scheduler is suspended
+rather than interrupts disabled, as a notify from a task may yield. */
+#define sbSEND_COMPLETED( pxStreamBuffer )										\
+	vTaskSuspendAll();															\
+	{																			\
+		if( ( pxStreamBuffer )->xTaskWaitingToReceive != NULL )					\
+		{																		\
+			( void ) xTaskNotify( ( pxStreamBuffer )->xTaskWaitingToReceive,	\
+								  ( uint32_t ) 0,								\
+								  eNoAction );									\
+			( pxStreamBuffer )->xTaskWaitingToReceive = NULL;					\
+		}																		\
+	}																			\
+	( void ) xTaskResumeAll();
+
+#define sbRECEIVE_COMPLETED( pxStreamBuffer )									\
+	vTaskSuspendAll();															\
+	{																			\
+		if( ( pxStreamBuffer )->xTaskWaitingToSend != NULL )					\
+		{																		\
+			( void ) xTaskNotify( ( pxStreamBuffer )->xTaskWaitingToSend,		\
+								  ( uint32_t ) 0,								\
+								  eNoAction );									\
+			( pxStreamBuffer )->xTaskWaitingToSend = NULL;						\
+		}																		\
+	}																			\
+	( void ) xTaskResumeAll();
+
+/*
+ * The stream buffer data structure.  StaticStreamBuffer_t in FreeRTOS.h must
+ * match it.
+ */
+typedef struct xSTREAM_BUFFER
+{
+	volatile size_t xTail;						/*< Index of the next byte to read, moved by the reader only. */
+	volatile size_t xHead;						/*< Index of the next byte to write, moved by the writer only. */
+	size_t xLength;								/*< Size of the storage area, one more than the bytes held. */
+	size_t xTriggerLevelBytes;					/*< Bytes there must be before a blocked reader is woken. */
+	volatile TaskHandle_t xTaskWaitingToReceive;	/*< Reader blocked waiting for bytes, or NULL. */
+	volatile TaskHandle_t xTaskWaitingToSend;	/*< Writer blocked waiting for space, or NULL. */
+	uint8_t *pucBuffer;							/*< The storage area. */
+	uint8_t ucFlags;							/*< sbFLAGS_* */
+} StreamBuffer_t;
+
+/*
+ * Bytes in the ring.
+ */
+static size_t prvBytesInBuffer( const StreamBuffer_t * const pxStreamBuffer ) PRIVILEGED_FUNCTION;
+
+/*
+ * Copy xCount bytes into the ring at xHead, or out of it at xTail, wrapping
+ * at the end of the storage.  The caller must have checked there is room (or
+ * that there are enough bytes).  The index is only moved if xUpdateIndex is
+ * pdTRUE, so the length of a message can be looked at without taking it.
+ */
+static void prvWriteBytesToBuffer( StreamBuffer_t * const pxStreamBuffer, const uint8_t *pucData, size_t xCount ) PRIVILEGED_FUNCTION;
+static void prvReadBytesFromBuffer( StreamBuffer_t * const pxStreamBuffer, uint8_t *pucData, size_t xCount, BaseType_t xUpdateIndex ) PRIVILEGED_FUNCTION;
+
+/*
+ * Write a message or stream data, given the space there is, and return the
+ * bytes of data written.  A message is written whole or not at all.
+ */
+static size_t prvWriteMessageToBuffer( StreamBuffer_t * const pxStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, size_t xSpace, size_t xRequiredSpace ) PRIVILEGED_FUNCTION;
+
+/*
+ * Read the next message, or up to xBufferLengthBytes of stream data, given
+ * the bytes there are, and return the bytes of data read.
+ */
+static size_t prvReadMessageFromBuffer( StreamBuffer_t * const pxStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, size_t xBytesAvailable ) PRIVILEGED_FUNCTION;
+
+/*
+ * Set up a stream buffer in the given memory.
+ */
+static void prvInitialiseNewStreamBuffer( StreamBuffer_t * const pxStreamBuffer, uint8_t * const pucBuffer, size_t xBufferSizeBytes, size_t xTriggerLevelBytes, uint8_t ucFlags ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	StreamBufferHandle_t xStreamBufferGenericCreate( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer )
+	{
+	uint8_t *pucAllocatedMemory;
+
+		configASSERT( xBufferSizeBytes > 0 );
+		configASSERT( xTriggerLevelBytes <= xBufferSizeBytes );
+
+		/* The structure and the storage area, with its spare byte, are taken
+		in one allocation. */
+		pucAllocatedMemory = ( uint8_t * ) pvPortMalloc( sizeof( StreamBuffer_t ) + xBufferSizeBytes + 1 );
+
+		if( pucAllocatedMemory != NULL )
+		{
+			prvInitialiseNewStreamBuffer( ( StreamBuffer_t * ) pucAllocatedMemory, pucAllocatedMemory + sizeof( StreamBuffer_t ), xBufferSizeBytes, xTriggerLevelBytes, ( xIsMessageBuffer != pdFALSE ) ? sbFLAGS_IS_MESSAGE_BUFFER : 0 ); /*lint !e826 Area is large enough. */
+			traceSTREAM_BUFFER_CREATE( ( ( StreamBuffer_t * ) pucAllocatedMemory ), xIsMessageBuffer );
+		}
+		else
+		{
+			traceSTREAM_BUFFER_CREATE_FAILED( xIsMessageBuffer );
+		}
+
+		return ( StreamBufferHandle_t ) pucAllocatedMemory;
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	StreamBufferHandle_t xStreamBufferGenericCreateStatic( size_t xBufferSizeBytes, size_t xTriggerLevelBytes, BaseType_t xIsMessageBuffer, uint8_t * const pucStreamBufferStorageArea, StaticStreamBuffer_t * const pxStaticStreamBuffer )
+	{
+	StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) pxStaticStreamBuffer; /*lint !e740 Unusual cast is ok as the structures are designed to have the same alignment, and the size is checked by an assert. */
+	uint8_t ucFlags;
+
+		configASSERT( pucStreamBufferStorageArea );
+		configASSERT( pxStaticStreamBuffer );
+		configASSERT( xBufferSizeBytes > 0 );
+		configASSERT( xTriggerLevelBytes <= xBufferSizeBytes );
+
+		/* Sanity check that the size of the structure used to declare a
+		variable of type StaticStreamBuffer_t equals the size of the real
+		stream buffer structure. */
+		configASSERT( sizeof( StaticStreamBuffer_t ) == sizeof( StreamBuffer_t ) );
+
+		if( ( pucStreamBufferStorageArea == NULL ) || ( pxStaticStreamBuffer == NULL ) )
+		{
+			traceSTREAM_BUFFER_CREATE_FAILED( xIsMessageBuffer );
+			return NULL;
+		}
+
+		ucFlags = sbFLAGS_IS_STATICALLY_ALLOCATED;
+		if( xIsMessageBuffer != pdFALSE )
+		{
+			ucFlags |= sbFLAGS_IS_MESSAGE_BUFFER;
+		}
+
+		prvInitialiseNewStreamBuffer( pxStreamBuffer, pucStreamBufferStorageArea, xBufferSizeBytes, xTriggerLevelBytes, ucFlags );
+		traceSTREAM_BUFFER_CREATE( pxStreamBuffer, xIsMessageBuffer );
+
+		return ( StreamBufferHandle_t ) pxStreamBuffer;
+	}
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+void vStreamBufferDelete( StreamBufferHandle_t xStreamBuffer )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+	configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+	configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+
+	traceSTREAM_BUFFER_DELETE( xStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) 0 )
+	{
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+		{
+			vPortFree( ( void * ) pxStreamBuffer );
+		}
+		#endif
+	}
+	else
+	{
+		/* The memory is the application's, just leave it unusable. */
+		memset( pxStreamBuffer, 0x00, sizeof( StreamBuffer_t ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferReset( StreamBufferHandle_t xStreamBuffer )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+BaseType_t xReturn = pdFAIL;
+
+	configASSERT( pxStreamBuffer );
+
+	taskENTER_CRITICAL();
+	{
+		if( ( pxStreamBuffer->xTaskWaitingToReceive == NULL ) && ( pxStreamBuffer->xTaskWaitingToSend == NULL ) )
+		{
+			pxStreamBuffer->xTail = 0;
+			pxStreamBuffer->xHead = 0;
+			xReturn = pdPASS;
+			traceSTREAM_BUFFER_RESET( xStreamBuffer );
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferSetTriggerLevel( StreamBufferHandle_t xStreamBuffer, size_t xTriggerLevel )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+BaseType_t xReturn;
+
+	configASSERT( pxStreamBuffer );
+
+	/* It is not valid for the trigger level to be 0. */
+	if( xTriggerLevel == ( size_t ) 0 )
+	{
+		xTriggerLevel = ( size_t ) 1;
+	}
+
+	/* The trigger level is the number of bytes that must be in the stream
+	buffer before a task that is waiting for data is unblocked, so it cannot
+	be more than the stream buffer holds. */
+	if( xTriggerLevel < pxStreamBuffer->xLength )
+	{
+		pxStreamBuffer->xTriggerLevelBytes = xTriggerLevel;
+		xReturn = pdPASS;
+	}
+	else
+	{
+		xReturn = pdFAIL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSpacesAvailable( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xSpace;
+
+	configASSERT( pxStreamBuffer );
+
+	xSpace = pxStreamBuffer->xLength + pxStreamBuffer->xTail;
+	xSpace -= pxStreamBuffer->xHead;
+	xSpace -= ( size_t ) 1;
+
+	if( xSpace >= pxStreamBuffer->xLength )
+	{
+		xSpace -= pxStreamBuffer->xLength;
+	}
+
+	return xSpace;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferBytesAvailable( StreamBufferHandle_t xStreamBuffer )
+{
+	configASSERT( xStreamBuffer );
+
+	return prvBytesInBuffer( ( StreamBuffer_t * ) xStreamBuffer );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferIsEmpty( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+
+	configASSERT( pxStreamBuffer );
+
+	return ( pxStreamBuffer->xHead == pxStreamBuffer->xTail ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferIsFull( StreamBufferHandle_t xStreamBuffer )
+{
+const StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xBytesToStoreMessageLength;
+
+	configASSERT( pxStreamBuffer );
+
+	/* A message buffer with no room for a length is full too. */
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = 0;
+	}
+
+	return ( xStreamBufferSpacesAvailable( xStreamBuffer ) <= xBytesToStoreMessageLength ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSend( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReturn, xSpace = 0;
+size_t xRequiredSpace = xDataLengthBytes;
+TimeOut_t xTimeOut;
+
+	configASSERT( pvTxData );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xRequiredSpace += sbBYTES_TO_STORE_MESSAGE_LENGTH;
+
+		/* A message that can never fit would wait for ever. */
+		configASSERT( xRequiredSpace < pxStreamBuffer->xLength );
+	}
+
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		vTaskSetTimeOutState( &xTimeOut );
+
+		do
+		{
+			/* Wait until there is room for everything, or the time runs
+			out. */
+			taskENTER_CRITICAL();
+			{
+				xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+
+				if( xSpace < xRequiredSpace )
+				{
+					/* Clear a stale notification, so the wait below only ends
+					on one sent after the handle is published. */
+					( void ) xTaskNotifyStateClear( NULL );
+
+					/* Only one writer may block at a time. */
+					configASSERT( pxStreamBuffer->xTaskWaitingToSend == NULL );
+					pxStreamBuffer->xTaskWaitingToSend = xTaskGetCurrentTaskHandle();
+				}
+				else
+				{
+					taskEXIT_CRITICAL();
+					break;
+				}
+			}
+			taskEXIT_CRITICAL();
+
+			traceBLOCKING_ON_STREAM_BUFFER_SEND( xStreamBuffer );
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToSend = NULL;
+
+		} while( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE );
+	}
+
+	if( xSpace == ( size_t ) 0 )
+	{
+		xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+	}
+
+	xReturn = prvWriteMessageToBuffer( pxStreamBuffer, pvTxData, xDataLengthBytes, xSpace, xRequiredSpace );
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		traceSTREAM_BUFFER_SEND( xStreamBuffer, xReturn );
+
+		/* Was a task waiting for the data? */
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			sbSEND_COMPLETED( pxStreamBuffer );
+		}
+	}
+	else
+	{
+		traceSTREAM_BUFFER_SEND_FAILED( xStreamBuffer );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferSendFromISR( StreamBufferHandle_t xStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReturn, xSpace;
+size_t xRequiredSpace = xDataLengthBytes;
+
+	configASSERT( pvTxData );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xRequiredSpace += sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+
+	xSpace = xStreamBufferSpacesAvailable( pxStreamBuffer );
+	xReturn = prvWriteMessageToBuffer( pxStreamBuffer, pvTxData, xDataLengthBytes, xSpace, xRequiredSpace );
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		/* Was a task waiting for the data? */
+		if( prvBytesInBuffer( pxStreamBuffer ) >= pxStreamBuffer->xTriggerLevelBytes )
+		{
+			( void ) xStreamBufferSendCompletedFromISR( xStreamBuffer, pxHigherPriorityTaskWoken );
+		}
+	}
+
+	traceSTREAM_BUFFER_SEND_FROM_ISR( xStreamBuffer, xReturn );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceive( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReceivedLength = 0, xBytesAvailable, xBytesToStoreMessageLength;
+
+	configASSERT( pvRxData );
+	configASSERT( pxStreamBuffer );
+
+	/* A message buffer holding no more than a length holds no message. */
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = 0;
+	}
+
+	if( xTicksToWait != ( TickType_t ) 0 )
+	{
+		/* Checking if there is data and clearing the notification state must
+		be performed atomically. */
+		taskENTER_CRITICAL();
+		{
+			xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+			if( xBytesAvailable <= xBytesToStoreMessageLength )
+			{
+				/* Clear a stale notification, so the wait below only ends on
+				one sent after the handle is published. */
+				( void ) xTaskNotifyStateClear( NULL );
+
+				/* Only one reader may block at a time. */
+				configASSERT( pxStreamBuffer->xTaskWaitingToReceive == NULL );
+				pxStreamBuffer->xTaskWaitingToReceive = xTaskGetCurrentTaskHandle();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		if( xBytesAvailable <= xBytesToStoreMessageLength )
+		{
+			/* Wait for data to be available. */
+			traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( xStreamBuffer );
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+			pxStreamBuffer->xTaskWaitingToReceive = NULL;
+
+			/* Recheck the data available after blocking. */
+			xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+		}
+	}
+	else
+	{
+		xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+	}
+
+	if( xBytesAvailable > xBytesToStoreMessageLength )
+	{
+		xReceivedLength = prvReadMessageFromBuffer( pxStreamBuffer, pvRxData, xBufferLengthBytes, xBytesAvailable );
+
+		/* Was a task waiting for space in the buffer? */
+		if( xReceivedLength != ( size_t ) 0 )
+		{
+			traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xReceivedLength );
+			sbRECEIVE_COMPLETED( pxStreamBuffer );
+		}
+	}
+	else
+	{
+		traceSTREAM_BUFFER_RECEIVE_FAILED( xStreamBuffer );
+	}
+
+	return xReceivedLength;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferReceiveFromISR( StreamBufferHandle_t xStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReceivedLength = 0, xBytesAvailable, xBytesToStoreMessageLength;
+
+	configASSERT( pvRxData );
+	configASSERT( pxStreamBuffer );
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		xBytesToStoreMessageLength = sbBYTES_TO_STORE_MESSAGE_LENGTH;
+	}
+	else
+	{
+		xBytesToStoreMessageLength = 0;
+	}
+
+	xBytesAvailable = prvBytesInBuffer( pxStreamBuffer );
+
+	if( xBytesAvailable > xBytesToStoreMessageLength )
+	{
+		xReceivedLength = prvReadMessageFromBuffer( pxStreamBuffer, pvRxData, xBufferLengthBytes, xBytesAvailable );
+
+		/* Was a task waiting for space in the buffer? */
+		if( xReceivedLength != ( size_t ) 0 )
+		{
+			( void ) xStreamBufferReceiveCompletedFromISR( xStreamBuffer, pxHigherPriorityTaskWoken );
+		}
+	}
+
+	traceSTREAM_BUFFER_RECEIVE_FROM_ISR( xStreamBuffer, xReceivedLength );
+
+	return xReceivedLength;
+}
+/*-----------------------------------------------------------*/
+
+size_t xStreamBufferNextMessageLengthBytes( StreamBufferHandle_t xStreamBuffer )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+size_t xReturn = 0;
+
+	configASSERT( pxStreamBuffer );
+
+	/* Only called by the reader, so the message cannot be taken meanwhile. */
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		if( prvBytesInBuffer( pxStreamBuffer ) > sbBYTES_TO_STORE_MESSAGE_LENGTH )
+		{
+			prvReadBytesFromBuffer( pxStreamBuffer, ( uint8_t * ) &xReturn, sbBYTES_TO_STORE_MESSAGE_LENGTH, pdFALSE );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferSendCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+BaseType_t xReturn;
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( pxStreamBuffer );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( pxStreamBuffer->xTaskWaitingToReceive != NULL )
+		{
+			( void ) xTaskNotifyFromISR( pxStreamBuffer->xTaskWaitingToReceive, ( uint32_t ) 0, eNoAction, pxHigherPriorityTaskWoken );
+			pxStreamBuffer->xTaskWaitingToReceive = NULL;
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			xReturn = pdFALSE;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xStreamBufferReceiveCompletedFromISR( StreamBufferHandle_t xStreamBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+{
+StreamBuffer_t * const pxStreamBuffer = ( StreamBuffer_t * ) xStreamBuffer;
+BaseType_t xReturn;
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( pxStreamBuffer );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		if( pxStreamBuffer->xTaskWaitingToSend != NULL )
+		{
+			( void ) xTaskNotifyFromISR( pxStreamBuffer->xTaskWaitingToSend, ( uint32_t ) 0, eNoAction, pxHigherPriorityTaskWoken );
+			pxStreamBuffer->xTaskWaitingToSend = NULL;
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			xReturn = pdFALSE;
+		}
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvWriteMessageToBuffer( StreamBuffer_t * const pxStreamBuffer, const void *pvTxData, size_t xDataLengthBytes, size_t xSpace, size_t xRequiredSpace )
+{
+size_t xReturn;
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		/* A message is written whole, behind its length, or not at all.  An
+		empty message could not be told from no message, so is not sent. */
+		if( ( xDataLengthBytes > ( size_t ) 0 ) && ( xSpace >= xRequiredSpace ) )
+		{
+			prvWriteBytesToBuffer( pxStreamBuffer, ( const uint8_t * ) &xDataLengthBytes, sbBYTES_TO_STORE_MESSAGE_LENGTH );
+			xReturn = xDataLengthBytes;
+		}
+		else
+		{
+			xReturn = 0;
+		}
+	}
+	else
+	{
+		/* As much of the stream as fits. */
+		xReturn = ( xDataLengthBytes < xSpace ) ? xDataLengthBytes : xSpace;
+	}
+
+	if( xReturn > ( size_t ) 0 )
+	{
+		prvWriteBytesToBuffer( pxStreamBuffer, ( const uint8_t * ) pvTxData, xReturn );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvReadMessageFromBuffer( StreamBuffer_t * const pxStreamBuffer, void *pvRxData, size_t xBufferLengthBytes, size_t xBytesAvailable )
+{
+size_t xCount;
+
+	if( ( pxStreamBuffer->ucFlags & sbFLAGS_IS_MESSAGE_BUFFER ) != ( uint8_t ) 0 )
+	{
+		/* Look at the length first, a message too long for the caller's
+		buffer is left where it is. */
+		prvReadBytesFromBuffer( pxStreamBuffer, ( uint8_t * ) &xCount, sbBYTES_TO_STORE_MESSAGE_LENGTH, pdFALSE );
+
+		if( xCount > xBufferLengthBytes )
+		{
+			return 0;
+		}
+
+		prvReadBytesFromBuffer( pxStreamBuffer, ( uint8_t * ) &xCount, sbBYTES_TO_STORE_MESSAGE_LENGTH, pdTRUE );
+	}
+	else
+	{
+		xCount = ( xBufferLengthBytes < xBytesAvailable ) ? xBufferLengthBytes : xBytesAvailable;
+	}
+
+	if( xCount > ( size_t ) 0 )
+	{
+		prvReadBytesFromBuffer( pxStreamBuffer, ( uint8_t * ) pvRxData, xCount, pdTRUE );
+	}
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteBytesToBuffer( StreamBuffer_t * const pxStreamBuffer, const uint8_t *pucData, size_t xCount )
+{
+size_t xNextHead = pxStreamBuffer->xHead;
+size_t xFirstLength;
+
+	configASSERT( xCount > ( size_t ) 0 );
+
+	/* Up to the end of the storage, then from the start. */
+	xFirstLength = pxStreamBuffer->xLength - xNextHead;
+	if( xFirstLength > xCount )
+	{
+		xFirstLength = xCount;
+	}
+
+	memcpy( ( void * ) &( pxStreamBuffer->pucBuffer[ xNextHead ] ), ( const void * ) pucData, xFirstLength );
+
+	if( xCount > xFirstLength )
+	{
+		memcpy( ( void * ) pxStreamBuffer->pucBuffer, ( const void * ) &( pucData[ xFirstLength ] ), xCount - xFirstLength );
+	}
+
+	xNextHead += xCount;
+	if( xNextHead >= pxStreamBuffer->xLength )
+	{
+		xNextHead -= pxStreamBuffer->xLength;
+	}
+
+	/* The bytes must be in place before the reader can see them. */
+	sbCOMPILER_BARRIER();
+	pxStreamBuffer->xHead = xNextHead;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReadBytesFromBuffer( StreamBuffer_t * const pxStreamBuffer, uint8_t *pucData, size_t xCount, BaseType_t xUpdateIndex )
+{
+size_t xNextTail = pxStreamBuffer->xTail;
+size_t xFirstLength;
+
+	configASSERT( xCount > ( size_t ) 0 );
+
+	/* Up to the end of the storage, then from the start. */
+	xFirstLength = pxStreamBuffer->xLength - xNextTail;
+	if( xFirstLength > xCount )
+	{
+		xFirstLength = xCount;
+	}
+
+	memcpy( ( void * ) pucData, ( const void * ) &( pxStreamBuffer->pucBuffer[ xNextTail ] ), xFirstLength );
+
+	if( xCount > xFirstLength )
+	{
+		memcpy( ( void * ) &( pucData[ xFirstLength ] ), ( const void * ) pxStreamBuffer->pucBuffer, xCount - xFirstLength );
+	}
+
+	if( xUpdateIndex != pdFALSE )
+	{
+		xNextTail += xCount;
+		if( xNextTail >= pxStreamBuffer->xLength )
+		{
+			xNextTail -= pxStreamBuffer->xLength;
+		}
+
+		/* The bytes must be out before the writer can reuse them. */
+		sbCOMPILER_BARRIER();
+		pxStreamBuffer->xTail = xNextTail;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvBytesInBuffer( const StreamBuffer_t * const pxStreamBuffer )
+{
+size_t xCount;
+
+	xCount = pxStreamBuffer->xLength + pxStreamBuffer->xHead;
+	xCount -= pxStreamBuffer->xTail;
+
+	if( xCount >= pxStreamBuffer->xLength )
+	{
+		xCount -= pxStreamBuffer->xLength;
+	}
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitialiseNewStreamBuffer( StreamBuffer_t * const pxStreamBuffer, uint8_t * const pucBuffer, size_t xBufferSizeBytes, size_t xTriggerLevelBytes, uint8_t ucFlags )
+{
+	/* A trigger level of 0 would wake a reader with nothing to read. */
+	if( xTriggerLevelBytes == ( size_t ) 0 )
+	{
+		xTriggerLevelBytes = ( size_t ) 1;
+	}
+
+	memset( ( void * ) pxStreamBuffer, 0x00, sizeof( StreamBuffer_t ) );
+	pxStreamBuffer->pucBuffer = pucBuffer;
+	pxStreamBuffer->xLength = xBufferSizeBytes + ( size_t ) 1;
+	pxStreamBuffer->xTriggerLevelBytes = xTriggerLevelBytes;
+	pxStreamBuffer->ucFlags = ucFlags;
+}
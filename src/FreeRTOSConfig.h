@@ -59,6 +59,16 @@
 #define configTICK_RATE_HZ			( ( portTickType ) 1000 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 100 )
 #define configTOTAL_HEAP_SIZE		( ( size_t ) ( 20 * 1024 ) )
+/* Every task, queue and semaphore is created in memory the application
+declares, so RAM use is fixed at link time and the heap compiles to nothing.
+Set configSUPPORT_DYNAMIC_ALLOCATION to 1 to bring the heap back. */
+#define configSUPPORT_STATIC_ALLOCATION		1
+#define configSUPPORT_DYNAMIC_ALLOCATION	0
+/* When the heap is enabled it is heap_tlsf.c: bounded time, merges freed
+blocks, and serves small requests from fixed pools of the sizes below. */
+#define configUSE_TLSF_HEAP			1
+#define configHEAP_POOL_SIZES		{ 16, 32, 96 }
+#define configHEAP_POOL_BLOCKS		{ 16, 8, 8 }
 #define configMAX_TASK_NAME_LEN		( 12 )
 #define configUSE_TRACE_FACILITY	0
 #define configUSE_16_BIT_TICKS		0
@@ -75,6 +85,7 @@
 #define configQUEUE_REGISTRY_SIZE		0
 #define configGENERATE_RUN_TIME_STATS	0
 #define configUSE_MALLOC_FAILED_HOOK	1
+#define configUSE_QUEUE_SETS			1
 
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
@@ -87,6 +98,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
 
 /* Use the system definition, if there is one */
 #ifdef __NVIC_PRIO_BITS
@@ -1,8 +1,36 @@
 #include <adc_task.h>
+#include "main.h"
+#include "cyclecount.h"
 
 static xQueueHandle sampQ;
+#ifdef ADC_WAKE_SEMAPHORE
+static xSemaphoreHandle xAdcSemaphore;
+static StaticSemaphore_t xAdcSemaphoreBuffer;
+#else
+static TaskHandle_t xAdcTaskHandle;
+#endif
+
+#ifdef ADC_WAKEUP_STATS
+/* Cycle counter when TIMER3 last woke the task, and the wakeups since the
+ * last report */
+static volatile uint32_t adcWakeCycles;
+static struct
+{
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t count;
+} adcWakeup;
+#endif
 DTMFSampleType ADC_BUFFERS[NUM_ADC_BUFFERS][DTMFSampleSize];
 
+#ifdef DTMF_ECHO_CANCEL
+/* DAC output at each sample, for own-signal cancellation (echo_cancel.h) */
+static DTMFSampleType ADC_REF_BUFFERS[NUM_ADC_BUFFERS][DTMFSampleSize];
+static DTMFSampleType adc_ref_data;
+static DTMFSampleType adc_ref_next;
+#endif
+
 int32_t adc_init(void)
 {
 	/* Enable Power in SC register */
@@ -37,8 +65,20 @@ DTMFSampleType adc_read(void)
 	 * !!! WARNING !!!! This will block */
 	while ((LPC_ADC->ADGDR & 0x80000000) == 0x0); //Done bit auto clear
 
+#ifdef LOOPBACK_DIGITAL
+	/* Stand-in for the analog loop, the DAC register in the same format */
+	adc_data = ADC_FROM_DACR(LPC_DAC->DACR);
+#else
 	/* Get the result and mask it off, format it to a int16_t for DTMF Task */
-	adc_data = (~LPC_ADC->ADGDR) & 0xFFFF;
+	adc_data = ADC_SAMPLE(LPC_ADC->ADGDR);
+#endif
+
+#ifdef DTMF_ECHO_CANCEL
+	/* The DAC output this result was converted against is the one
+	 * captured when its conversion was started */
+	adc_ref_data = adc_ref_next;
+	adc_ref_next = ADC_FROM_DACR(LPC_DAC->DACR);
+#endif
 
 	/* start the conversion so it is ready when the next interrupt fires */
 	LPC_ADC->ADCR |= (0x1 << 24); //start in ADCR
@@ -46,6 +86,28 @@ DTMFSampleType adc_read(void)
 	return adc_data;
 }
 
+#ifdef ADC_WAKEUP_STATS
+/* Accumulate the cycles of one wakeup, and report every ADC_WAKEUP_REPORT */
+static void adc_wakeup_record(uint32_t cycles)
+{
+	if (adcWakeup.count == 0 || cycles < adcWakeup.min) {
+		adcWakeup.min = cycles;
+	}
+	if (cycles > adcWakeup.max) {
+		adcWakeup.max = cycles;
+	}
+	adcWakeup.sum += cycles;
+
+	if (++adcWakeup.count == ADC_WAKEUP_REPORT) {
+		LOG_INFO("ADC wakeup cycles min %lu max %lu avg %lu\n", adcWakeup.min,
+				 adcWakeup.max, (uint32_t)(adcWakeup.sum / adcWakeup.count));
+		adcWakeup.count = 0;
+		adcWakeup.max = 0;
+		adcWakeup.sum = 0;
+	}
+}
+#endif
+
 void vAdcTask( void *pvParameters )
 {
 	uint32_t read_cnt = 0;
@@ -55,10 +117,20 @@ void vAdcTask( void *pvParameters )
 
 	sampQ = (xQueueHandle)pvParameters;
 
-	xAdcSemaphore = xSemaphoreCreateBinary();
+#ifdef ADC_WAKE_SEMAPHORE
+	xAdcSemaphore = xSemaphoreCreateBinaryStatic(&xAdcSemaphoreBuffer);
 
 	if (xAdcSemaphore != NULL && sampQ != NULL)
+#else
+	/* Set before TIMER3 is enabled, so the interrupt always has it */
+	xAdcTaskHandle = xTaskGetCurrentTaskHandle();
+
+	if (sampQ != NULL)
+#endif
 	{
+#ifdef ADC_WAKEUP_STATS
+		CycleCounterInit();
+#endif
 		adc_init();
 		timer_init();
 
@@ -67,14 +139,24 @@ void vAdcTask( void *pvParameters )
 		NVIC_ClearPendingIRQ(TIMER3_IRQn);
 		NVIC_EnableIRQ(TIMER3_IRQn);
 
-		vPrintString( "ADC Reading Started\n" );
+		LOG_INFO("ADC Reading Started\n");
 		/* As per most tasks, this task is implemented in an infinite loop. */
 		for( ;; )
 		{
-			/* Get semaphore give from ISR */
+			/* Wait for the ISR to signal a sample is due */
+#ifdef ADC_WAKE_SEMAPHORE
 			xSemaphoreTake(xAdcSemaphore, portMAX_DELAY);
+#else
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif
+#ifdef ADC_WAKEUP_STATS
+			adc_wakeup_record(CycleCounterGet() - adcWakeCycles);
+#endif
 
 			ADC_BUFFERS[current_buffer][read_cnt] = adc_read();
+#ifdef DTMF_ECHO_CANCEL
+			ADC_REF_BUFFERS[current_buffer][read_cnt] = adc_ref_data;
+#endif
 
 			/* Fill current buffer */
 			if (read_cnt < NUM_ADC_SAMPLES-1) {
@@ -93,10 +175,21 @@ void vAdcTask( void *pvParameters )
 			}
 		}
 	} else {
-		vPrintString( "ADC Task Failed to Initialize!\n" );
+		LOG_ERROR("ADC Task Failed to Initialize!\n");
 	}
 }
 
+/* Reference samples that go with a buffer of ADC_BUFFERS, NULL if none
+ * are captured */
+const DTMFSampleType* adc_reference(const DTMFSampleType* samples)
+{
+#ifdef DTMF_ECHO_CANCEL
+	return ADC_REF_BUFFERS[(samples - &ADC_BUFFERS[0][0]) / DTMFSampleSize];
+#else
+	return NULL;
+#endif
+}
+
 int32_t timer_init(void)
 {
 	/* Enable the clock to the timer */
@@ -135,13 +228,23 @@ void TIMER3_IRQHandler(void)
 	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 
 	/* If the time to match is pending for this timer
-	 * clear the pending interrupt and give the semaphore
-	 * for the ADC to begin processing
+	 * clear the pending interrupt and notify the ADC
+	 * task to begin processing
 	 */
 	if (LPC_TIM3->IR &= (1 << CT_MAT0_INTERRUPT) != 0) {
 		LPC_TIM3->IR &= ~(1 << CT_MAT0_INTERRUPT);
+#ifdef ADC_WAKEUP_STATS
+		adcWakeCycles = CycleCounterGet();
+#endif
+#ifdef ADC_WAKE_SEMAPHORE
 		xSemaphoreGiveFromISR(xAdcSemaphore, &xHigherPriorityTaskWoken);
+#else
+		vTaskNotifyGiveFromISR(xAdcTaskHandle, &xHigherPriorityTaskWoken);
+#endif
 	}
 	NVIC_ClearPendingIRQ(TIMER3_IRQn);
+
+	/* Switch straight to the ADC task rather than at the next tick */
+	portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
 
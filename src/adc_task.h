@@ -38,13 +38,29 @@
 #define ADC_DATA_TYPE uint16_t
 #define ADC_QUEUE_LEN 1
 
-/* Hanldes to RTOS types */
-static xSemaphoreHandle xAdcSemaphore;
+/* An ADC result register (offset binary, bits 15:4) as a signed sample,
+ * inverted, with bit 15 flipped so that mid-scale is 0 and a tone swings
+ * both ways from it instead of wrapping at mid-scale */
+#define ADC_SAMPLE(result) ((DTMFSampleType)(((~(result)) & 0xFFFF) ^ 0x8000))
+
+/* A DAC register value as adc_read() returns it: the DAC value (bits 15:6)
+ * where the ADC result (bits 15:4) would be */
+#define ADC_FROM_DACR(dacr) ADC_SAMPLE((dacr) & 0xFFC0)
+
+/*
+ * TIMER3 wakes vAdcTask once a sample with a direct task notification, which
+ * skips the queue object and event lists of a semaphore give and take. With
+ * ADC_WAKE_SEMAPHORE the binary semaphore it replaced is built instead, and
+ * ADC_WAKEUP_STATS reports the cycles from the give in the interrupt to the
+ * task running, every ADC_WAKEUP_REPORT wakeups, to compare the two.
+ */
+#define ADC_WAKEUP_REPORT (16000 * 10)    //CONFIGURABLE - wakeups between reports (10 s)
 
 /* The task function. */
 void vAdcTask( void *pvParameters );
 int32_t adc_init(void);
 int32_t timer_init(void);
 DTMFSampleType adc_read(void);
+const DTMFSampleType* adc_reference(const DTMFSampleType* samples);
 
 #endif // __ADC_H__
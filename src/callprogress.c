@@ -0,0 +1,308 @@
+#include "callprogress.h"
+
+/*-----------------------------------------------------------
+ * Call progress tone generation
+ *
+ * Each tone step gets its own loop table.  Its length is searched
+ * (CP_MIN_TABLE up to the step's share of CP_TABLE_SAMPLES) for the
+ * smallest frequency error once every component is rounded to whole
+ * cycles, so the table loops without a phase step.  The loop is then
+ * repeated in the table as often as the share (and the largest DMA
+ * transfer) allows, which keeps the descriptor count of long steps
+ * down.  Silence steps all point at one midscale word.
+ *
+ * Rendering is the only CPU cost; the resulting chain is played by
+ * the DMA engine alone.
+ */
+
+/* Loop Tables */
+static DAC_Sample cpTable[CP_TABLE_SAMPLES] DAC_DMA_BUFFER;
+static DAC_Sample cpSilence = DAC_SAMPLE(DAC_MIDSCALE);
+
+/* 350 + 440 Hz, continuous */
+const CP_CADENCE cpDialTone =
+{
+  1, 1,
+  {
+    { 1000, 2, { { 350.0f, CP_AMPLITUDE }, { 440.0f, CP_AMPLITUDE } } },
+  }
+};
+
+/* 440 + 480 Hz, 2 s on, 4 s off */
+const CP_CADENCE cpRingback =
+{
+  2, 1,
+  {
+    { 2000, 2, { { 440.0f, CP_AMPLITUDE }, { 480.0f, CP_AMPLITUDE } } },
+    { 4000, 0, { { 0.0f, 0 } } },
+  }
+};
+
+/* 480 + 620 Hz, 0.5 s on, 0.5 s off */
+const CP_CADENCE cpBusy =
+{
+  2, 1,
+  {
+    { 500, 2, { { 480.0f, CP_AMPLITUDE }, { 620.0f, CP_AMPLITUDE } } },
+    { 500, 0, { { 0.0f, 0 } } },
+  }
+};
+
+/* 480 + 620 Hz, 0.25 s on, 0.25 s off */
+const CP_CADENCE cpReorder =
+{
+  2, 1,
+  {
+    { 250, 2, { { 480.0f, CP_AMPLITUDE }, { 620.0f, CP_AMPLITUDE } } },
+    { 250, 0, { { 0.0f, 0 } } },
+  }
+};
+
+/* Special information tone, vacant code / intercept, played once */
+const CP_CADENCE cpSitIntercept =
+{
+  3, 0,
+  {
+    { 274, 1, { {  913.8f, CP_AMPLITUDE } } },
+    { 274, 1, { { 1370.6f, CP_AMPLITUDE } } },
+    { 380, 1, { { 1776.7f, CP_AMPLITUDE } } },
+  }
+};
+
+//=============================================================================
+// CpLoopLength() - loop table length for a step, 0 if none fits
+//=============================================================================
+static uint32_t CpLoopLength(const CP_STEP *step, uint32_t maxLen, uint32_t *cycles)
+{
+  float bestError = 1.0f;
+  uint32_t best = 0;
+  uint32_t len;
+  uint32_t k;
+
+  for(len = CP_MIN_TABLE; len <= maxLen; len++)
+  {
+    float worst = 0.0f;
+
+    for(k = 0; k < step->numComponents; k++)
+    {
+      float exact = step->component[k].freq * len / DAC_SAMPLE_PER_SECOND;
+      float whole = (float)(uint32_t)(exact + 0.5f);
+      float error = (whole > exact) ? (whole - exact) / exact : (exact - whole) / exact;
+
+      if(whole < 1.0f || whole * 2 >= len)
+      {
+        error = 1.0f;
+      }
+      if(error > worst)
+      {
+        worst = error;
+      }
+    }
+
+    // Strictly better only, so the shortest of equal loops wins
+    if(worst < bestError)
+    {
+      bestError = worst;
+      best = len;
+    }
+  }
+
+  for(k = 0; best && k < step->numComponents; k++)
+  {
+    cycles[k] = (uint32_t)(step->component[k].freq * best / DAC_SAMPLE_PER_SECOND + 0.5f);
+  }
+  return best;
+}
+
+//=============================================================================
+// CpRenderStep() - fill a loop table, returns its length (0 on failure)
+//=============================================================================
+static uint32_t CpRenderStep(const CP_STEP *step, DAC_Sample *dst, uint32_t share, uint32_t *loop)
+{
+  TONE_OSC osc[CP_MAX_COMPONENTS];
+  uint32_t cycles[CP_MAX_COMPONENTS];
+  int32_t peak = 0;
+  uint32_t len;
+  uint32_t k;
+
+  if(step->numComponents > CP_MAX_COMPONENTS)
+  {
+    return 0;
+  }
+  for(k = 0; k < step->numComponents; k++)
+  {
+    peak += step->component[k].amplitude;
+  }
+  if(peak >= DAC_MIDSCALE)
+  {
+    LOG_ERROR("Call progress step would clip\n");
+    return 0;
+  }
+
+  len = CpLoopLength(step, share, cycles);
+  if(len == 0)
+  {
+    return 0;
+  }
+  *loop = len;
+
+  // Repeat the loop to fill the share, a single transfer at most
+  if(share > DAC_CHAIN_MAX_SEGMENT)
+  {
+    share = DAC_CHAIN_MAX_SEGMENT;
+  }
+  len *= share / len;
+
+  // Exactly cycles per loop, so the phase comes back to 0 at each wrap
+  for(k = 0; k < step->numComponents; k++)
+  {
+    osc[k].phase = 0;
+    osc[k].step = (uint32_t)(((uint64_t)cycles[k] << 32) / *loop);
+    osc[k].amplitude = step->component[k].amplitude;
+  }
+  ToneGenBlock(osc, step->numComponents, DAC_MIDSCALE, dst, len);
+  return len;
+}
+
+//=============================================================================
+// CallProgressPlay() - render a cadence and loop it on the DAC
+//=============================================================================
+portBASE_TYPE CallProgressPlay(const CP_CADENCE *cadence)
+{
+  DAC_Setup_Message dmaReq;
+  DMA_LinkedList *head = NULL;
+  DMA_LinkedList *tail = NULL;
+  const CP_STEP *step;
+  uint32_t toneSteps = 0;
+  uint32_t share;
+  uint32_t used = 0;
+  uint32_t samples;
+  uint32_t len;
+  uint32_t loop;
+  uint32_t i;
+
+  if(cadence->numSteps == 0 || cadence->numSteps > CP_MAX_STEPS)
+  {
+    return pdFAIL;
+  }
+  for(i = 0; i < cadence->numSteps; i++)
+  {
+    if(cadence->step[i].numComponents)
+    {
+      toneSteps++;
+    }
+  }
+  share = toneSteps ? CP_TABLE_SAMPLES / toneSteps : 0;
+
+  for(i = 0; i < cadence->numSteps; i++)
+  {
+    step = &cadence->step[i];
+    samples = step->durationMs * (DAC_SAMPLE_PER_SECOND / 1000);
+    if(samples == 0)
+    {
+      continue;
+    }
+
+    if(step->numComponents)
+    {
+      len = CpRenderStep(step, &cpTable[used], share, &loop);
+      if(len == 0)
+      {
+        DMA_ReleaseChain(head);
+        return pdFAIL;
+      }
+
+      // A steady tone loops onto itself, so it must end on a whole loop
+      if(cadence->repeat && cadence->numSteps == 1)
+      {
+        samples = ((samples + loop / 2) / loop) * loop;
+        if(samples == 0)
+        {
+          samples = loop;
+        }
+      }
+      tail = DAC_ChainAppend(&head, tail, &cpTable[used], len, 1, samples);
+      used += len;
+    }
+    else
+    {
+      tail = DAC_ChainAppend(&head, tail, &cpSilence, 0, 0, samples);
+    }
+
+    if(tail == NULL)
+    {
+      LOG_ERROR("Call progress cadence does not fit the LLI pool\n");
+      DMA_ReleaseChain(head);
+      return pdFAIL;
+    }
+  }
+
+  if(head == NULL)
+  {
+    return pdFAIL;
+  }
+
+  dmaReq.firstSample = NULL;
+  dmaReq.numberSamples = 0;
+  dmaReq.flags = DAC_FLAG_CHAIN;
+  dmaReq.ringCount = 0;
+  dmaReq.index = DAC_INDEX_NONE;
+  dmaReq.chain = head;
+
+  if(cadence->repeat)
+  {
+    tail->NextLinkedList = (uint32_t) head;
+    dmaReq.flags |= DAC_FLAG_CONTINUOUS;
+  }
+  else
+  {
+    tail->control |= (1UL << 31);
+  }
+
+  if(xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 ) != pdPASS)
+  {
+    LOG_ERROR("Failed to send DMA request\n");
+    DMA_ReleaseChain(head);
+    return pdFAIL;
+  }
+  return pdPASS;
+}
+
+//=============================================================================
+// CallProgressStop() - end the cadence playing
+//=============================================================================
+portBASE_TYPE CallProgressStop(void)
+{
+  DAC_Setup_Message dmaReq;
+
+  dmaReq.firstSample = NULL;
+  dmaReq.numberSamples = 0;
+  dmaReq.flags = 0;
+  dmaReq.ringCount = 0;
+  dmaReq.index = DAC_INDEX_NONE;
+  dmaReq.chain = NULL;
+
+  return xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 );
+}
+
+#ifdef CALLPROGRESS_UNIT_TEST
+/* Unit Test Task Cycling Through The Call Progress Tones */
+void vTaskCallProgressTest( void *pvParameters )
+{
+  const CP_CADENCE *tones[] = { &cpDialTone, &cpRingback, &cpBusy, &cpReorder, &cpSitIntercept };
+  uint32_t i = 0;
+
+  for( ;; )
+  {
+    LOG_INFO("Call progress tone %lu\n", i);
+    if(CallProgressPlay(tones[i]) != pdPASS)
+    {
+      LOG_ERROR("Call progress tone failed\n");
+    }
+    LOG_INFO("LLI free %lu\n", DMA_FreeLLICount());
+
+    vTaskDelay(8000 / portTICK_RATE_MS);
+    i = (i + 1) % (sizeof(tones) / sizeof(tones[0]));
+  }
+}
+#endif
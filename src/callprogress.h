@@ -0,0 +1,73 @@
+#ifndef CALLPROGRESS_H
+#define CALLPROGRESS_H
+
+/*
+ * callprogress.h
+ * Call progress tones (dial, ringback, busy, SIT, ...) on the DAC
+ *
+ * A tone is described as a cadence: a list of steps, each a sum of up to
+ * CP_MAX_COMPONENTS sine components (none for silence) held for a duration.
+ * CallProgressPlay() renders every tone step once into a loop table holding a
+ * whole number of cycles of each component, then links the steps into a single
+ * DAC_FLAG_CHAIN program of table loops and silences. A repeating cadence is a
+ * circular chain that the DMA engine runs on its own, so playing busy or
+ * ringback costs no more CPU than a steady DTMF tone: none at all until the next
+ * message to the DAC stops it.
+ *
+ * Resources used:
+ * CP_TABLE_SAMPLES * 4 bytes of AHB SRAM for the loop tables
+ * LLI pool descriptors while a cadence plays (returned by DAC_Handler)
+ *
+ * Assumptions:
+ * Tone tables are rebuilt in place, so a new cadence should only be started
+ * from one task at a time. The few samples of the old cadence still playing
+ * while its replacement is rendered may come out of the new tables.
+ */
+
+#include "tonegen.h"
+
+#define CP_MAX_COMPONENTS   4        // Frequencies summed in one step
+#define CP_MAX_STEPS        8        // Steps in one cadence
+#define CP_TABLE_SAMPLES    2048     //CONFIGURABLE - Loop table space shared by the tone steps
+#define CP_MIN_TABLE        32       // Shortest loop table searched
+#define CP_AMPLITUDE        (MAX_AMPLITUDE/4)   // Peak of each component of the standard tones
+
+typedef struct
+{
+  float    freq;           // Hz
+  int32_t  amplitude;      // peak in DAC counts
+} CP_COMPONENT;
+
+typedef struct
+{
+  uint16_t durationMs;     // time the step lasts
+  uint8_t  numComponents;  // 0 for silence
+  CP_COMPONENT component[CP_MAX_COMPONENTS];
+} CP_STEP;
+
+typedef struct
+{
+  uint8_t  numSteps;
+  uint8_t  repeat;         // loop the cadence until stopped, otherwise play it once
+  CP_STEP  step[CP_MAX_STEPS];
+} CP_CADENCE;
+
+/* North American call progress tones (ANSI T1.401) */
+extern const CP_CADENCE cpDialTone;
+extern const CP_CADENCE cpRingback;
+extern const CP_CADENCE cpBusy;
+extern const CP_CADENCE cpReorder;
+extern const CP_CADENCE cpSitIntercept;
+
+/*
+ * Renders a cadence and hands it to the DAC. Returns pdFAIL, playing nothing,
+ * if it does not fit the tables or the LLI pool, or the DAC queue is full.
+ * Any message to the DAC (a key press, CallProgressStop()) ends it.
+ */
+portBASE_TYPE CallProgressPlay(const CP_CADENCE *cadence);
+portBASE_TYPE CallProgressStop(void);
+
+/* Unit Test Task */
+void vTaskCallProgressTest( void *pvParameters );
+
+#endif
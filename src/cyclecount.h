@@ -0,0 +1,44 @@
+#ifndef CYCLECOUNT_H
+#define CYCLECOUNT_H
+
+/*
+ * cyclecount.h
+ * Access to the Cortex-M3 DWT cycle counter, for timing code on target.
+ *
+ * The counter runs at the core clock (configCPU_CLOCK_HZ) and wraps every
+ * ~43 s at 100 MHz, so differences of two readings taken with unsigned
+ * arithmetic are valid across a wrap. The DWT is not described by the
+ * CMSIS v1.30 headers, so its two registers are declared here.
+ */
+
+#include "LPC17xx.h"
+#include <stdint.h>
+
+#define DWT_CTRL            (*(volatile uint32_t *) 0xE0001000)
+#define DWT_CYCCNT          (*(volatile uint32_t *) 0xE0001004)
+#define DWT_CTRL_CYCCNTENA  (1 << 0)
+
+#define CYCLES_PER_USEC     (configCPU_CLOCK_HZ / 1000000UL)
+
+/* Enable the trace block and start the counter. Safe to call from every
+ * module that times something: a running count is left alone, so stamps
+ * already taken stay valid. */
+static __INLINE void CycleCounterInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+/* Restart the count from 0, only for a benchmark that owns the counter */
+static __INLINE void CycleCounterReset(void)
+{
+  DWT_CYCCNT = 0;
+}
+
+/* Current cycle count */
+static __INLINE uint32_t CycleCounterGet(void)
+{
+  return DWT_CYCCNT;
+}
+
+#endif
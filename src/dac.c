@@ -1,63 +1,246 @@
 #include <dac.h>
+#include "task.h"
 #include "semphr.h"
+#include "cyclecount.h"
 
 /*
- * This structure exactly matches the linked list structure for the chip
+ * DAC task, notified by the DMA interrupt for deferred processing. Its
+ * notification value counts terminal count interrupts, so ring laps of a
+ * looping transfer are never merged.
  */
-typedef struct DMA_LinkedList
-{
-  uint32_t Src;
-  uint32_t Destination;
-  uint32_t NextLinkedList;
-  uint32_t control;
+static TaskHandle_t xDacTask = NULL;
 
-} DMA_LinkedList;
+#if defined(DAC_RESPONSE_QUEUE)
+extern SemaphoreHandle_t DAC_RESPONSE_QUEUE;
+#endif
 
 /*
- * Semaphore used for deferred interrupt processing
+ * Self linked descriptor used for DAC_FLAG_CONTINUOUS transfers
  */
-SemaphoreHandle_t xDacDmaSem = NULL;
+static DMA_LinkedList continuousList;
 
-#if defined(DAC_RESPONSE_QUEUE)
-extern SemaphoreHandle_t DAC_RESPONSE_QUEUE;
+/*
+ * Descriptor ring and interrupt side state for DAC_FLAG_STREAM transfers
+ */
+static DMA_LinkedList streamList[DAC_STREAM_MAX_BUFFERS];
+static volatile uint8_t streamActive = 0;
+static uint32_t streamIndex;
+static uint32_t streamCount;
+static uint32_t streamSamples;
+static DAC_Sample* streamFirst;
+static xQueueHandle streamQueue;
+static uint32_t streamBase;
+volatile uint32_t dacStartCycles = 0;
+volatile uint32_t dacStreamDropped = 0;
+
+static void StopDMA (void);
+static void SendCompletion (DAC_Setup_Message* message);
+
+#if defined(ALLOW_LOOPING_DAC_DMA)
+#if defined(DAC_SAMPLE_PER_SECOND)
+#define DAC_MESSAGE_RATE(message) DAC_SAMPLE_PER_SECOND
+#else
+#define DAC_MESSAGE_RATE(message) ((message)->samplesPerSecond)
 #endif
 
+/*
+ * Descriptors of one looping transfer, all taken from the shared LLI pool
+ */
+typedef struct LoopingTransfer
+{
+  DMA_LinkedList* list[DAC_LOOP_MAX_LLI];	/* every descriptor, in play order */
+  uint32_t count;				/* descriptors in list, 0 if none */
+  DMA_LinkedList* ringEnd;			/* last descriptor of the ring, NULL if no ring */
+  DMA_LinkedList* tail;				/* partial pass after the ring, NULL if none */
+  uint32_t laps;				/* passes through the ring */
+} LoopingTransfer;
+
+static portBASE_TYPE BuildLoopingTransfer (DAC_Setup_Message* message, LoopingTransfer* loop);
+static void ReleaseLoopingTransfer (LoopingTransfer* loop);
+#endif
+
+/*
+ * Handles interrupt by deferring processing to task
+ * While streaming, the completion of the drained ring buffer is posted directly
+ */
+static void
+DacDmaHandler (portBASE_TYPE* rerunScheduler)
+{
+  LPC_GPDMA->DMACIntErrClr = 1;
+  if (LPC_GPDMA->DMACIntTCStat & 1)
+    {
+      LPC_GPDMA->DMACIntTCClear = 1;
+      if (streamActive)
+	{
+	  DAC_Complete_Message complete;
+	  complete.firstSample = streamFirst + streamIndex * streamSamples;
+	  complete.numberSamples = streamSamples;
+	  complete.index = streamBase + streamIndex;
+	  if (pdPASS != xQueueSendFromISR(streamQueue, &complete, rerunScheduler))
+	    {
+	      ++dacStreamDropped;
+	    }
+	  if (++streamIndex == streamCount)
+	    {
+	      streamIndex = 0;
+	    }
+	}
+      else if (xDacTask)
+	{
+	  vTaskNotifyGiveFromISR(xDacTask, rerunScheduler);
+	}
+
+    }
+}
+
 /*
  * Sets up DMA resources on channel 0
  */
 void
 InitializeDMA ()
 {
-  LPC_SC->PCONP |= 0x20000000;
-  LPC_GPDMA->DMACConfig = 1; /* Enable */
+  DMA_Initialize ();
   LPC_GPDMACH0->DMACCConfig = 0;
-  NVIC_SetPriority (DMA_IRQn, configMAX_SYSCALL_INTERRUPT_PRIORITY);
-  NVIC_EnableIRQ (DMA_IRQn);
+  DMA_RegisterHandler (0, DacDmaHandler);
+}
 
-  xDacDmaSem = xSemaphoreCreateBinary();
+/*
+ * Stops the DAC channel mid transfer. The channel is halted so it ignores further
+ * requests, allowed to drain its FIFO and then disabled.
+ */
+static void
+StopDMA (void)
+{
+  LPC_GPDMACH0->DMACCConfig |= (1 << 18);
+  while (LPC_GPDMACH0->DMACCConfig & (1 << 17))
+    {
+    }
+  LPC_GPDMACH0->DMACCConfig = 0;
+  LPC_DAC->DACCTRL = 0;
+  LPC_GPDMA->DMACIntTCClear = 1;
+  LPC_GPDMA->DMACIntErrClr = 1;
 }
 
 /*
- * Handles interrupt by deferring processing to task
+ * Informs the originator of a message that its buffer is no longer in use
  */
-void
-DMA_IRQHandler (void)
+static void
+SendCompletion (DAC_Setup_Message* message)
 {
-  portBASE_TYPE rerunScheduler = pdFALSE;
-  if (LPC_GPDMA->DMACIntTCStat & 1)
+#if !defined(DAC_RESPONSE_QUEUE)
+  if(message->completionResponseQueue)
+#else
+#endif
     {
-      LPC_GPDMA->DMACIntTCClear = 1;
-      if (xDacDmaSem)
+      DAC_Complete_Message complete;
+      complete.firstSample = message->firstSample;
+      complete.numberSamples = message->numberSamples;
+      complete.index = message->index;
+
+#if !defined(DAC_RESPONSE_QUEUE)
+      xQueueSend(message->completionResponseQueue,&complete,portMAX_DELAY);
+#else
+      xQueueSend(DAC_RESPONSE_QUEUE, &complete, portMAX_DELAY);
+#endif
+    }
+}
+
+#if defined(ALLOW_LOOPING_DAC_DMA)
+/*
+ * Splits the play time into whole passes over the buffer plus a partial pass.
+ * Short tones are a straight chain of descriptors. Longer ones are a head of
+ * (passes % DAC_LOOP_RING_LLI) descriptors, a ring of DAC_LOOP_RING_LLI that
+ * is lapped as many times as needed, and the partial tail. Either way no more
+ * than DAC_LOOP_MAX_LLI descriptors are used, however long the tone is.
+ * Only the last descriptor of the chain, and of the ring, interrupt.
+ */
+static portBASE_TYPE
+BuildLoopingTransfer (DAC_Setup_Message* message, LoopingTransfer* loop)
+{
+  uint32_t totalSamples = (uint32_t) (DAC_MESSAGE_RATE(message) * message->playTimeSeconds);
+  uint32_t passes = totalSamples / message->numberSamples;
+  uint32_t samplesExtraPass = totalSamples - passes * message->numberSamples;
+  uint32_t headCount = passes;
+  uint32_t ringCount = 0;
+  uint32_t ii;
+
+  if (passes + (samplesExtraPass ? 1 : 0) > DAC_LOOP_MAX_LLI)
+    {
+      ringCount = DAC_LOOP_RING_LLI;
+      headCount = passes % ringCount;
+    }
+  loop->laps = ringCount ? passes / ringCount : 0;
+  loop->count = headCount + ringCount + (samplesExtraPass ? 1 : 0);
+  loop->ringEnd = NULL;
+  loop->tail = NULL;
+
+  for (ii = 0; ii < loop->count; ++ii)
+    {
+      loop->list[ii] = DMA_AcquireLLI ();
+      if (loop->list[ii] == NULL)
 	{
-	  xSemaphoreGiveFromISR(xDacDmaSem, &rerunScheduler);
+	  loop->count = ii;
+	  ReleaseLoopingTransfer (loop);
+	  return pdFAIL;
 	}
 
+      /*
+       * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source | do not increment dest
+       */
+      loop->list[ii]->Src = (uint32_t) message->firstSample;
+      loop->list[ii]->Destination = (uint32_t) &LPC_DAC->DACR;
+      loop->list[ii]->NextLinkedList = 0;
+      loop->list[ii]->control = message->numberSamples | (0 << 12) | (0 << 15)
+	  | (0x2 << 18) | (0x2 << 21) | (1 << 26) | (0 << 27);
+      if (ii)
+	{
+	  loop->list[ii - 1]->NextLinkedList = (uint32_t) loop->list[ii];
+	}
     }
 
-  NVIC_ClearPendingIRQ (DMA_IRQn);
+  if (loop->count == 0)
+    {
+      return pdFAIL;
+    }
+
+  if (samplesExtraPass)
+    {
+      loop->tail = loop->list[loop->count - 1];
+      loop->tail->control = samplesExtraPass | (0 << 12) | (0 << 15)
+	  | (0x2 << 18) | (0x2 << 21) | (1 << 26) | (0 << 27);
+    }
+
+  /*
+   * Add in interrupt on completion
+   */
+  loop->list[loop->count - 1]->control |= (1UL << 31);
+
+  if (ringCount)
+    {
+      loop->ringEnd = loop->list[headCount + ringCount - 1];
+      loop->ringEnd->control |= (1UL << 31);
+      if (loop->laps > 1)
+	{
+	  loop->ringEnd->NextLinkedList = (uint32_t) loop->list[headCount];
+	}
+    }
+  return pdPASS;
+}
 
-  portEND_SWITCHING_ISR(rerunScheduler);
+/*
+ * Returns the descriptors of a looping transfer to the pool
+ */
+static void
+ReleaseLoopingTransfer (LoopingTransfer* loop)
+{
+  uint32_t ii;
+  for (ii = 0; ii < loop->count; ++ii)
+    {
+      DMA_ReleaseLLI (loop->list[ii]);
+    }
+  loop->count = 0;
 }
+#endif
 
 /*
  * Sets DAC up (i/o pins, clock rate)
@@ -100,35 +283,64 @@ InitializeDAC ()
  *   It can send a "finished" message to a desired queue in case more than one
  *   task feeding the ISR
  *   It can loop the DAC output to play for loner duration than the samples,
- *   allocating an appropriate linked list with an interrupt on total completion
+ *   using a bounded linked list from the LLI pool with an interrupt on total completion
+ *
+ * Continuous messages (DAC_FLAG_CONTINUOUS) are looped by the DMA engine through
+ * a descriptor that links to itself. No interrupt is taken; the task returns to
+ * the message queue right away and the next message stops the loop.
+ *
+ * Streaming messages (DAC_FLAG_STREAM) link their buffers into a circular ring
+ * with an interrupt per buffer; the interrupt posts the completions and the
+ * task again only waits for the next message, which stops the stream.
  */
 void
 DAC_Handler (void* queue)
 {
 #if 0
     {
-      DAC_Sample testCode;
-      testCode.RESERVED_SET_ZERO=0;
-      testCode.Value=1;
-      testCode.Bias=0;
-      testCode.RESERVED_SET_ZERO_2=0;
-
-      if(0x40 != *((uint32_t*)&testCode))
+      if(0x40 != DAC_SAMPLE(1))
 	{
 	  printf("Bad layout DAC sample\n");
 	}
-      testCode.Value=0xffff;
     }
 #endif
 
   xQueueHandle inboundQueue = (xQueueHandle) queue;
   DAC_Setup_Message message;
+  DAC_Setup_Message continuousMessage;
+  uint8_t continuousActive = 0;
+
+  /* Nothing is started before this, so no completion can be missed */
+  xDacTask = xTaskGetCurrentTaskHandle ();
+
   for (;;)
     {
       if (pdFAIL == xQueueReceive(inboundQueue, &message, portMAX_DELAY))
 	{
 	  continue;
 	}
+
+      /* Any new message ends a continuous transfer or a stream */
+      if (continuousActive)
+	{
+	  StopDMA ();
+	  continuousActive = 0;
+	  if (continuousMessage.flags & DAC_FLAG_CHAIN)
+	    {
+	      DMA_ReleaseChain (continuousMessage.chain);
+	    }
+	  SendCompletion (&continuousMessage);
+	}
+      else if (streamActive)
+	{
+	  StopDMA ();
+	  streamActive = 0;
+	}
+
+      if (message.numberSamples == 0 && !(message.flags & DAC_FLAG_CHAIN))
+	{
+	  continue;
+	}
       LPC_DAC->DACCTRL = 0;
 
 #if !defined(DAC_SAMPLE_PER_SECOND)
@@ -137,50 +349,128 @@ DAC_Handler (void* queue)
       LPC_DAC->DACCNTVAL = period;
 #endif
 
-#if defined(ALLOW_LOOPING_DAC_DMA)
-      uint32_t numberCompleteCycles = floor((message.samplesPerSecond*message.playTimeSeconds)/message.numberSamples);
-      uint32_t samplesExtraPass = (message.samplesPerSecond*message.playTimeSeconds)-(numberCompleteCycles*message.numberSamples);
-      uint32_t dmaListToAllocate = numberCompleteCycles;
-      if(samplesExtraPass)
+      if (message.flags & DAC_FLAG_CONTINUOUS)
 	{
-	  ++dmaListToAllocate;
+	  /*
+	   * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source | do not increment dest
+	   */
+	  continuousList.Src = (uint32_t) message.firstSample;
+	  continuousList.Destination = (uint32_t) &LPC_DAC->DACR;
+	  continuousList.NextLinkedList = (uint32_t) &continuousList;
+	  continuousList.control = message.numberSamples | (0 << 12) | (0 << 15)
+	      | (0x2 << 18) | (0x2 << 21) | (1 << 26) | (0 << 27);
+
+	  LPC_GPDMACH0->DMACCControl = continuousList.control;
+	  LPC_GPDMACH0->DMACCSrcAddr = continuousList.Src;
+	  LPC_GPDMACH0->DMACCDestAddr = continuousList.Destination;
+	  LPC_GPDMACH0->DMACCLLI = continuousList.NextLinkedList;
+
+	  /*
+	   * Enable | DAC destination | memory to peripheral
+	   */
+	  LPC_GPDMACH0->DMACCConfig = 0x1 | (7 << 6) | (1 << 11);
+	  LPC_DAC->DACCTRL = 1 << 3 | 1 << 2;
+	  dacStartCycles = CycleCounterGet ();
+
+	  continuousMessage = message;
+	  continuousActive = 1;
+	  continue;
 	}
 
-      DMA_LinkedList* linkedList = calloc(dmaListToAllocate,sizeof(DMA_LinkedList));
-      for(uint32_t ii=0;ii<dmaListToAllocate;++ii)
+      if (message.flags & DAC_FLAG_STREAM)
 	{
-	  linkedList[ii].Src = (uint32_t)message.firstSample;
-	  linkedList[ii].Destination = (uint32_t)&LPC_DAC->DACR;
-	  if(ii != (dmaListToAllocate-1))
+	  uint32_t ii;
+	  configASSERT(message.ringCount > 1 && message.ringCount <= DAC_STREAM_MAX_BUFFERS);
+
+	  /*
+	   * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source | do not increment dest | interrupt on complete
+	   */
+	  for (ii = 0; ii < message.ringCount; ++ii)
 	    {
-	      linkedList[ii].NextLinkedList = (uint32_t)&linkedList[ii+1].NextLinkedList;
+	      streamList[ii].Src = (uint32_t) (message.firstSample + ii * message.numberSamples);
+	      streamList[ii].Destination = (uint32_t) &LPC_DAC->DACR;
+	      streamList[ii].NextLinkedList = (uint32_t) &streamList[(ii + 1) % message.ringCount];
+	      streamList[ii].control = message.numberSamples | (0 << 12) | (0 << 15)
+		  | (0x2 << 18) | (0x2 << 21) | (1 << 26) | (0 << 27) | (1 << 31);
 	    }
+
+	  streamFirst = message.firstSample;
+	  streamSamples = message.numberSamples;
+	  streamCount = message.ringCount;
+	  streamIndex = 0;
+	  streamBase = message.index;
+#if !defined(DAC_RESPONSE_QUEUE)
+	  streamQueue = message.completionResponseQueue;
+#else
+	  streamQueue = DAC_RESPONSE_QUEUE;
+#endif
+	  streamActive = 1;
+
+	  LPC_GPDMACH0->DMACCControl = streamList[0].control;
+	  LPC_GPDMACH0->DMACCSrcAddr = streamList[0].Src;
+	  LPC_GPDMACH0->DMACCDestAddr = streamList[0].Destination;
+	  LPC_GPDMACH0->DMACCLLI = streamList[0].NextLinkedList;
+
 	  /*
-	   * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source | do not increment dest
+	   * Enable | DAC destination | memory to peripheral | terminal interrupt
 	   */
-	  linkedList[ii].control = message.numberSamples|(0<<12)|(0<<15)|(0x2<<18)|(0x2<<21)|(1<<26)|(0<<27);
+	  LPC_GPDMACH0->DMACCConfig = 0x1 | (7 << 6) | (1 << 11) | (1 << 15);
+	  LPC_DAC->DACCTRL = 1 << 3 | 1 << 2;
+	  dacStartCycles = CycleCounterGet ();
+	  continue;
 	}
-      uint32_t samplesLastPass = (samplesExtraPass>0)?samplesExtraPass:message.numberSamples;
-      /*
-       * Add in interrupt on completion
-       */
-      linkedList[dmaListToAllocate-1].control = samplesLastPass|(0<<12)|(0<<15)|(0x2<<18)|(0x2<<21)|(1<<26)|(0<<27)|(1<<31);
-      /* Program DMA controller (to copy of first entry)*/
-      LPC_GPDMACH0->DMACCControl = linkedList[0].control;
-      LPC_GPDMACH0->DMACCSrcAddr = linkedList[0].Src;
-      LPC_GPDMACH0->DMACCDestAddr = linkedList[0].Destination;
-      LPC_GPDMACH0->DMACCLLI = linkedList[0].NextLinkedList;
 
-#else
-      /*
-       * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source | do not increment dest | interrupt on complete
-       */
-      LPC_GPDMACH0->DMACCControl = message.numberSamples | (0 << 12) | (0 << 15)
-	  | (0x2 << 18) | (0x2 << 21) | (1 << 26) | (0 << 27) | (1 << 31);
-      LPC_GPDMACH0->DMACCSrcAddr = (uint32_t) message.firstSample;
-      LPC_GPDMACH0->DMACCDestAddr = (uint32_t) &LPC_DAC->DACR;
-      LPC_GPDMACH0->DMACCLLI = 0;
+      if (message.flags & DAC_FLAG_CHAIN)
+	{
+	  /* Program DMA controller (to copy of first entry)*/
+	  LPC_GPDMACH0->DMACCControl = message.chain->control;
+	  LPC_GPDMACH0->DMACCSrcAddr = message.chain->Src;
+	  LPC_GPDMACH0->DMACCDestAddr = message.chain->Destination;
+	  LPC_GPDMACH0->DMACCLLI = message.chain->NextLinkedList;
+
+	  /*
+	   * Enable | DAC destination | memory to peripheral | terminal interrupt
+	   */
+	  LPC_GPDMACH0->DMACCConfig = 0x1 | (7 << 6) | (1 << 11) | (1 << 15);
+	  LPC_DAC->DACCTRL = 1 << 3 | 1 << 2;
+	  dacStartCycles = CycleCounterGet ();
+
+	  if (message.flags & DAC_FLAG_CONTINUOUS)
+	    {
+	      /* Circular program, runs until the next message */
+	      continuousMessage = message;
+	      continuousActive = 1;
+	      continue;
+	    }
+
+	  ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	  DMA_ReleaseChain (message.chain);
+	  SendCompletion (&message);
+	  continue;
+	}
+
+#if defined(ALLOW_LOOPING_DAC_DMA)
+      LoopingTransfer loop;
+      if (pdPASS == BuildLoopingTransfer (&message, &loop))
+	{
+	  /* Program DMA controller (to copy of first entry)*/
+	  LPC_GPDMACH0->DMACCControl = loop.list[0]->control;
+	  LPC_GPDMACH0->DMACCSrcAddr = loop.list[0]->Src;
+	  LPC_GPDMACH0->DMACCDestAddr = loop.list[0]->Destination;
+	  LPC_GPDMACH0->DMACCLLI = loop.list[0]->NextLinkedList;
+	}
+      else
 #endif
+	{
+	  /*
+	   * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source | do not increment dest | interrupt on complete
+	   */
+	  LPC_GPDMACH0->DMACCControl = message.numberSamples | (0 << 12) | (0 << 15)
+	      | (0x2 << 18) | (0x2 << 21) | (1 << 26) | (0 << 27) | (1 << 31);
+	  LPC_GPDMACH0->DMACCSrcAddr = (uint32_t) message.firstSample;
+	  LPC_GPDMACH0->DMACCDestAddr = (uint32_t) &LPC_DAC->DACR;
+	  LPC_GPDMACH0->DMACCLLI = 0;
+	}
 
       /*
        * Enable | DAC destination | memory to peripheral | terminal interrupt
@@ -189,29 +479,80 @@ DAC_Handler (void* queue)
 
       /* Start the DAC/DMA*/
       LPC_DAC->DACCTRL = 1 << 3 | 1 << 2;
+      dacStartCycles = CycleCounterGet ();
 
-      xSemaphoreTake(xDacDmaSem, portMAX_DELAY);
 #if defined(ALLOW_LOOPING_DAC_DMA)
-      free(linkedList);
-      linkedList = NULL;
-#endif
-
-#if !defined(DAC_RESPONSE_QUEUE)
-      if(message.completionResponseQueue)
-#else
+      if (loop.count)
+	{
+	  /*
+	   * A ring interrupts once per lap. When the last lap starts, the end of
+	   * the ring is pointed at the tail (or at nothing) so it runs out. The
+	   * descriptor being patched has just completed and will not be fetched
+	   * again for a whole lap.
+	   */
+	  uint32_t interrupts = loop.ringEnd ? loop.laps + (loop.tail ? 1 : 0) : 1;
+	  uint32_t lapsDone = 0;
+	  while (interrupts--)
+	    {
+	      ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	      if (loop.ringEnd && ++lapsDone == loop.laps - 1)
+		{
+		  loop.ringEnd->NextLinkedList = (uint32_t) loop.tail;
+		}
+	    }
+	  ReleaseLoopingTransfer (&loop);
+	}
+      else
 #endif
 	{
-	  DAC_Complete_Message complete;
-	  complete.firstSample = message.firstSample;
-	  complete.numberSamples = message.numberSamples;
+	  ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	}
 
-#if !defined(DAC_RESPONSE_QUEUE)
-	  xQueueSend(message.completionResponseQueue,&complete,portMAX_DELAY);
-#else
-	  xQueueSend(DAC_RESPONSE_QUEUE, &complete, portMAX_DELAY);
-#endif
+      SendCompletion (&message);
+    }
+}
+
+DMA_LinkedList*
+DAC_ChainAppend (DMA_LinkedList** head, DMA_LinkedList* tail,
+		 DAC_Sample* src, uint32_t period, uint32_t srcIncrement,
+		 uint32_t count)
+{
+  DMA_LinkedList* item;
+  uint32_t chunk;
+
+  if (!srcIncrement || period > DAC_CHAIN_MAX_SEGMENT)
+    {
+      period = DAC_CHAIN_MAX_SEGMENT;
+    }
 
+  while (count > 0)
+    {
+      chunk = (count < period) ? count : period;
+      item = DMA_AcquireLLI ();
+      if (item == NULL)
+	{
+	  return NULL;
 	}
 
+      /*
+       * Burst size 1 word | Burst size 1 word | width 4 bytes | width 4 bytes | increment source as asked | do not increment dest
+       */
+      item->Src = (uint32_t) src;
+      item->Destination = (uint32_t) &LPC_DAC->DACR;
+      item->NextLinkedList = 0;
+      item->control = chunk | (0 << 12) | (0 << 15)
+	  | (0x2 << 18) | (0x2 << 21) | ((srcIncrement ? 1 : 0) << 26) | (0 << 27);
+
+      if (tail)
+	{
+	  tail->NextLinkedList = (uint32_t) item;
+	}
+      else
+	{
+	  *head = item;
+	}
+      tail = item;
+      count -= chunk;
     }
+  return tail;
 }
@@ -17,6 +17,16 @@
  * "completion" queue at a sufficient rate will cause breaks in the DAC playback, as this task
  * will pend.
  *
+ * A continuous (DAC_FLAG_CONTINUOUS) transfer is the exception to step 2: the DMA engine
+ * loops the buffer on its own and the task goes straight back to waiting for the next
+ * message, which stops the loop before it is processed. A steady tone therefore costs no
+ * CPU at all while it plays.
+ *
+ * A streaming (DAC_FLAG_STREAM) transfer also runs without the task: a ring of buffers is
+ * linked circularly and the DMA interrupt itself posts a completion as each buffer drains.
+ * The producer refills that buffer in place while the others play, so output is gapless
+ * and the channel is never reprogrammed until the next message stops the stream.
+ *
  *
  * Resources used:
  * DMA interrupt handler   -- set to configMAX_SYSCALL_INTERRUPT_PRIORITY
@@ -27,7 +37,7 @@
  * Needs a task, highest priority is best. Only active during the setup of a DMA to the DAC, and to respond on completion
  * 1-2 message queues. One for messages to the DAC, other (optional) for responses for completion
  * Message queue DAC task receives messages on is passed in as the argument on creation
- * Creates/uses a semaphore for the ISR that defers processing to the task (processing is basically releasing a sempahore).
+ * The ISR defers processing to the task with a direct task notification, counting completions (processing is basically giving the notification).
  * Reasonable minimum stack size will work (minimal call depth, little direct stack usage)
  *
  * CPU usage:
@@ -46,20 +56,29 @@
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "stdlib.h"
+#include "dma.h"
 
 
 #define TICKS_PER_SECOND_DAC 50000000UL
 
 /*
-Samples to the DAC, following the format of the DAC register.
-Reserved fields must be set to zero, per spec
+ * Placement for large DAC source buffers, see DMA_BUFFER
+ */
+#define DAC_DMA_BUFFER DMA_BUFFER
+
+/*
+Samples to the DAC, as raw words in the format of the DAC register: the 10 bit
+value in bits 15:6, bias in bit 16, reserved bits zero. Buffers of these go to
+the DMA engine untouched, and producers can build them with plain integer
+shifts instead of bitfield stores.
 */
-typedef struct DAC_Sample{
-	uint32_t RESERVED_SET_ZERO:6;
-	uint32_t Value:10;
-	uint32_t Bias:1;
-	uint32_t RESERVED_SET_ZERO_2:15;
-} DAC_Sample;
+typedef uint32_t DAC_Sample;
+
+#define DAC_VALUE_SHIFT     6
+#define DAC_VALUE_MASK      0x3FF
+#define DAC_BIAS            (1 << 16)
+#define DAC_SAMPLE(value)   ((DAC_Sample)((value) & DAC_VALUE_MASK) << DAC_VALUE_SHIFT)
+#define DAC_SAMPLE_VALUE(s) (((s) >> DAC_VALUE_SHIFT) & DAC_VALUE_MASK)
 
 /* If desire to hardcode the sample count, uncomment next line*/
 /**/
@@ -73,10 +92,70 @@ typedef struct DAC_Sample{
 /**/
 
 
+/*
+Flags for DAC_Setup_Message.flags
+
+DAC_FLAG_CONTINUOUS - the samples are replayed back to back by the DMA engine
+                      (self linked descriptor, no CPU involvement) until the
+                      next message arrives on the DAC queue. The buffer should
+                      hold a whole number of periods of the waveform. The
+                      completion for a continuous buffer is sent once it has
+                      been stopped.
+*/
+#define DAC_FLAG_CONTINUOUS (1 << 0)
+
+/*
+DAC_FLAG_STREAM     - firstSample points at ringCount buffers of numberSamples
+                      each, laid out back to back. They are linked into a
+                      circular descriptor ring with an interrupt on each
+                      terminal count. As each buffer finishes playing a
+                      completion carrying index plus its ring index is posted
+                      from the interrupt, and the producer must refill that buffer
+                      before the ring comes back around to it (ringCount - 1
+                      buffer times). An unrefilled buffer is played again, not
+                      skipped. The stream runs until the next message; after
+                      that every buffer belongs to the producer again and no
+                      further completions are sent. The response queue should
+                      hold at least ringCount messages.
+*/
+#define DAC_FLAG_STREAM     (1 << 1)
+#define DAC_STREAM_MAX_BUFFERS 8
+
+/*
+DAC_FLAG_CHAIN      - the transfer is a prebuilt chain of descriptors from the
+                      LLI pool (dma.h), given in chain; firstSample and
+                      numberSamples are ignored. The last descriptor must end
+                      the chain and interrupt on completion. This lets a whole
+                      timed program of segments (tones, silences) play with
+                      sample accurate timing and a single interrupt.
+                      DAC_Handler returns the descriptors to the pool before
+                      sending the completion.
+                      With DAC_FLAG_CONTINUOUS as well, the chain is circular
+                      and must not interrupt: it runs on its own like any
+                      continuous transfer until the next message, and is
+                      released when stopped.
+*/
+#define DAC_FLAG_CHAIN      (1 << 2)
+
+/*
+Completion index for transfers that do not belong to a buffer pool
+*/
+#define DAC_INDEX_NONE      0xFFFFFFFFUL
+
+/*
+Descriptor budget of one ALLOW_LOOPING_DAC_DMA transfer. Tones needing more
+passes than DAC_LOOP_MAX_LLI lap a ring of DAC_LOOP_RING_LLI descriptors.
+*/
+#define DAC_LOOP_RING_LLI   4
+#define DAC_LOOP_MAX_LLI    (2 * DAC_LOOP_RING_LLI)
+
 /*
 This is the structure that is sent from the user of the DAC to send list
 of samples to send. Optionally, can be told a sample rate, playback time, and
 dynamic allocated queue to send response to
+
+A message with numberSamples of 0 (and no DAC_FLAG_CHAIN) only stops whatever
+is currently playing.
 */
 typedef struct DAC_Setup_Message{
 #if !defined(DAC_SAMPLE_PER_SECOND)
@@ -84,6 +163,10 @@ typedef struct DAC_Setup_Message{
 #endif
 	DAC_Sample* firstSample;
 	uint32_t numberSamples;
+	uint32_t flags;
+	uint32_t ringCount;
+	uint32_t index;      /* caller's buffer index, returned in the completion */
+	DMA_LinkedList* chain;   /* descriptors for DAC_FLAG_CHAIN, otherwise NULL */
 #if defined(ALLOW_LOOPING_DAC_DMA)
 	double playTimeSeconds;
 #endif
@@ -100,8 +183,19 @@ has finished making it out the DAC
 typedef struct DAC_Complete_Message{
 	DAC_Sample* firstSample;
 	uint32_t numberSamples;
+	uint32_t index;      /* index from the setup message, plus the ring index for DAC_FLAG_STREAM */
 }DAC_Complete_Message;
 
+/*
+ * Stream completions that were dropped because the response queue was full
+ */
+extern volatile uint32_t dacStreamDropped;
+
+/*
+ * Cycle counter (cyclecount.h) reading taken as the last transfer was started
+ */
+extern volatile uint32_t dacStartCycles;
+
 /*
  * Required as part of setup to initialize DMA resources used
  */
@@ -115,8 +209,21 @@ void InitializeDAC();
 /*
  * This is the task that handles pumping data to the DMA. Strongly recommended
  * to be highest priority to reduce gaps between playing segments
- * If (optionally) the "ALLOW_LOOPING_DAC_DMA" flag is set, the task will do dynamic
- * malloc/frees to handle sizing a linked list
+ * If (optionally) the "ALLOW_LOOPING_DAC_DMA" flag is set, the task takes at most
+ * DAC_LOOP_MAX_LLI linked list items from the static pool in dma.h per transfer
  */
 void DAC_Handler(void* queue);
+
+/*
+ * Appends descriptors to a DAC_FLAG_CHAIN program (head/tail, both NULL to
+ * start) that play count samples. With srcIncrement the samples loop a buffer
+ * of period samples at src, otherwise the single word at src is repeated (up
+ * to DAC_CHAIN_MAX_SEGMENT per descriptor). Descriptors come from the LLI
+ * pool; returns the new tail, or NULL once the pool runs dry (the chain built
+ * so far is left for the caller to release)
+ */
+#define DAC_CHAIN_MAX_SEGMENT 4095
+DMA_LinkedList* DAC_ChainAppend(DMA_LinkedList** head, DMA_LinkedList* tail,
+                                DAC_Sample* src, uint32_t period,
+                                uint32_t srcIncrement, uint32_t count);
 #endif
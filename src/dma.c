@@ -0,0 +1,149 @@
+#include <dma.h>
+#include "task.h"
+#include "LPC17xx.h"
+
+/*
+ * The pool itself. Items must be word aligned for the GPDMA.
+ */
+static DMA_LinkedList lliPool[DMA_LLI_POOL_SIZE] DMA_BUFFER __attribute__ ((aligned(4)));
+static DMA_LinkedList* lliFreeHead = NULL;
+static uint32_t lliFree = 0;
+static uint32_t lliMinFree = DMA_LLI_POOL_SIZE;
+static uint8_t lliPoolReady = 0;
+
+/*
+ * Per channel interrupt handlers
+ */
+static DMA_ChannelHandler channelHandler[DMA_CHANNELS];
+
+void
+DMA_Initialize (void)
+{
+  LPC_SC->PCONP |= 0x20000000;
+  LPC_GPDMA->DMACConfig = 1; /* Enable */
+  NVIC_SetPriority (DMA_IRQn, configMAX_SYSCALL_INTERRUPT_PRIORITY);
+  NVIC_EnableIRQ (DMA_IRQn);
+}
+
+void
+DMA_RegisterHandler (uint32_t channel, DMA_ChannelHandler handler)
+{
+  if (channel < DMA_CHANNELS)
+    {
+      channelHandler[channel] = handler;
+    }
+}
+
+/*
+ * Passes each pending channel to its owner. A channel nobody owns only has its
+ * status cleared.
+ */
+void
+DMA_IRQHandler (void)
+{
+  portBASE_TYPE rerunScheduler = pdFALSE;
+  uint32_t pending = LPC_GPDMA->DMACIntStat;
+  uint32_t channel;
+
+  for (channel = 0; pending; ++channel, pending >>= 1)
+    {
+      if (!(pending & 1))
+	{
+	  continue;
+	}
+      if (channelHandler[channel])
+	{
+	  channelHandler[channel] (&rerunScheduler);
+	}
+      else
+	{
+	  LPC_GPDMA->DMACIntTCClear = 1UL << channel;
+	  LPC_GPDMA->DMACIntErrClr = 1UL << channel;
+	}
+    }
+
+  NVIC_ClearPendingIRQ (DMA_IRQn);
+
+  portEND_SWITCHING_ISR(rerunScheduler);
+}
+
+/*
+ * Chains every item of the pool onto the free list
+ */
+static void
+InitializeLLIPool (void)
+{
+  uint32_t ii;
+  for (ii = 0; ii < DMA_LLI_POOL_SIZE; ++ii)
+    {
+      lliPool[ii].NextLinkedList = (uint32_t) lliFreeHead;
+      lliFreeHead = &lliPool[ii];
+    }
+  lliFree = DMA_LLI_POOL_SIZE;
+  lliPoolReady = 1;
+}
+
+DMA_LinkedList*
+DMA_AcquireLLI (void)
+{
+  DMA_LinkedList* item;
+
+  taskENTER_CRITICAL();
+  if (!lliPoolReady)
+    {
+      InitializeLLIPool ();
+    }
+  item = lliFreeHead;
+  if (item)
+    {
+      lliFreeHead = (DMA_LinkedList*) item->NextLinkedList;
+      if (--lliFree < lliMinFree)
+	{
+	  lliMinFree = lliFree;
+	}
+    }
+  taskEXIT_CRITICAL();
+
+  return item;
+}
+
+void
+DMA_ReleaseLLI (DMA_LinkedList* item)
+{
+  if (item == NULL)
+    {
+      return;
+    }
+
+  taskENTER_CRITICAL();
+  item->NextLinkedList = (uint32_t) lliFreeHead;
+  lliFreeHead = item;
+  ++lliFree;
+  taskEXIT_CRITICAL();
+}
+
+void
+DMA_ReleaseChain (DMA_LinkedList* head)
+{
+  DMA_LinkedList* item = head;
+  DMA_LinkedList* next;
+
+  while (item)
+    {
+      next = (DMA_LinkedList*) item->NextLinkedList;
+      DMA_ReleaseLLI (item);
+      item = (next == head) ? NULL : next;
+    }
+}
+
+uint32_t
+DMA_FreeLLICount (void)
+{
+  return lliPoolReady ? lliFree : DMA_LLI_POOL_SIZE;
+}
+
+uint32_t
+DMA_MinFreeLLICount (void)
+{
+  return lliMinFree;
+}
@@ -0,0 +1,83 @@
+#if !defined(___DMA__H__)
+#define ___DMA__H__
+
+/*
+ * DMA.h
+ * Shared GPDMA support
+ *
+ * Linked list items (LLI) for the GPDMA come from a fixed, statically allocated pool
+ * rather than the FreeRTOS heap. Free items are chained through their NextLinkedList
+ * word, so acquire and release are both a single list operation. The pool is protected
+ * by a critical section and may only be used from tasks.
+ *
+ * The controller's one interrupt is shared: DMA_IRQHandler() calls the handler each
+ * channel's owner registered with DMA_RegisterHandler(). Channel 0, the highest
+ * priority, belongs to the DAC.
+ *
+ * Resources used:
+ * DMA_LLI_POOL_SIZE * 16 bytes of AHB SRAM
+ */
+
+/* FreeRTOS.org includes. */
+#include "FreeRTOS.h"
+
+#define DMA_LLI_POOL_SIZE 320    //CONFIGURABLE - Number of linked list items shared by all DMA users
+#define DMA_CHANNELS 8
+
+/*
+ * Large DMA buffers (waveform tables, rings, the LLI pool) are placed in the 32 KB
+ * AHB SRAM bank rather than the local SRAM that holds the FreeRTOS heap and the task
+ * stacks. The Code Red managed linker script maps ".bss.$RAM2" there.
+ */
+#define DMA_BUFFER __attribute__ ((section(".bss.$RAM2")))
+
+/*
+ * This structure exactly matches the linked list structure for the chip
+ */
+typedef struct DMA_LinkedList
+{
+  uint32_t Src;
+  uint32_t Destination;
+  uint32_t NextLinkedList;
+  uint32_t control;
+
+} DMA_LinkedList;
+
+/*
+ * Interrupt handler of one channel. It must clear the channel's terminal count and
+ * error status itself, and sets *woken when it readied a higher priority task.
+ */
+typedef void (*DMA_ChannelHandler) (portBASE_TYPE* woken);
+
+/*
+ * Powers and enables the controller and its interrupt, may be called by every user
+ */
+void DMA_Initialize (void);
+
+/*
+ * Routes the interrupts of a channel to handler
+ */
+void DMA_RegisterHandler (uint32_t channel, DMA_ChannelHandler handler);
+
+/*
+ * Takes an item from the pool, returns NULL if the pool is empty
+ */
+DMA_LinkedList* DMA_AcquireLLI (void);
+
+/*
+ * Returns an item to the pool
+ */
+void DMA_ReleaseLLI (DMA_LinkedList* item);
+
+/*
+ * Returns every item of a chain to the pool, following NextLinkedList until it
+ * ends or comes back around to the first item
+ */
+void DMA_ReleaseChain (DMA_LinkedList* head);
+
+/*
+ * Number of items currently free, and the lowest that number has been
+ */
+uint32_t DMA_FreeLLICount (void);
+uint32_t DMA_MinFreeLLICount (void);
+#endif
@@ -5,6 +5,7 @@
 #define DTMFSampleSize 256
 #define DTMFSampleType int16_t
 #define DTMFSampleRate 8000
+#define DTMFPeakThreshold 5.0f   /* Bin power over the mean bin power that is a tone */
 
 /* DTMF frequencies (Hz) */
 #define DTMF_NO_FREQ 0
@@ -18,7 +19,7 @@
 #define DTMF_H3_FREQ 1633
 
 /* DTMF frequency FFT bins */
-#define DTMF_BIN(x) ((int16_t)((float)x / ((float)DTMFSampleRate / (float)DTMFSampleSize)) )
+#define DTMF_BIN(x) ((int16_t)((float)x / ((float)DTMFSampleRate / (float)DTMFSampleSize) + 0.5f) )
 #define DTMF_L0_BIN DTMF_BIN(DTMF_L0_FREQ)
 #define DTMF_L1_BIN DTMF_BIN(DTMF_L1_FREQ)
 #define DTMF_L2_BIN DTMF_BIN(DTMF_L2_FREQ)
@@ -31,10 +32,13 @@
 /* Result of the DTMF detection */
 /* Code is the ASCII of the detected tones (space for none) */
 /* toneX is the tone frequency in hz */
+/* cycles is the cycle counter (cyclecount.h) when the frame was decoded */
 struct DTMFResult_t {
 	int8_t code;
 	int16_t toneA;
 	int16_t toneB;
+	float snr;          // weaker tone's bin power over the mean bin power
+	uint32_t cycles;
 };
 
 #endif
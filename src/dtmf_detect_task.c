@@ -13,24 +13,38 @@
 #include "fft/fft.h"
 
 #include "uart.h"
+#include "cyclecount.h"
+#include "echo_cancel.h"
+#include "event_proto.h"
+#include "adc_task.h"
+#include "main.h"
 
 static DTMFSampleType* s;
 static struct DTMFResult_t r;
 static complex cs[DTMFSampleSize];
+#ifdef DTMF_ECHO_CANCEL
+static struct EchoCanceller_t ec;
+#endif
 
 #define spec_power(x) ((x.Re * x.Re) + (x.Im * x.Im))
-void pick_peaks(complex *cs, float thresh, int16_t *toneA, int16_t *toneB);
-int8_t decode_tones(int16_t toneA, int16_t toneB);
 
 void vDTMFDetectTask( void *pvParameters ) {
 
 	struct DTMFDetectTaskParam_t* params = (struct DTMFDetectTaskParam_t *)pvParameters;
+#ifdef DTMF_BINARY_EVENTS
+	struct EventStats_t stats = { 0 };
+	TickType_t stats_last = xTaskGetTickCount();
+#else
 	char output[50];
+#endif
 
-	vPrintString( "DTMF Detector started\n" );
+	LOG_INFO("DTMF Detector started\n");
 
 	/* Prepare FFT */
 	init_Wn();
+#ifdef DTMF_ECHO_CANCEL
+	echo_cancel_init(&ec);
+#endif
 
 	for( ;; )
 	{
@@ -52,13 +66,24 @@ void vDTMFDetectTask( void *pvParameters ) {
 				cs[ii].Im = 0.0f;
 			}
 
+#ifdef DTMF_ECHO_CANCEL
+			/* Take out our own tones before the buffer is released */
+			echo_cancel_frame(&ec, cs, adc_reference(s), DTMFSampleSize);
+#endif
+
 			/* Now that we have a separate copy, release the buffer */
 			xQueueReceive( params->sampQ, &s, portMAX_DELAY );
 
 			/* Do real work here */
 			fft(cs, DTMFSampleSize); // Need to ensure second arg is log2(DTMFSampleSize)
-			pick_peaks(cs, 5.0f, &r.toneA, &r.toneB);
+			pick_peaks(cs, DTMFPeakThreshold, &r.toneA, &r.toneB, &r.snr);
 			r.code = decode_tones(r.toneA,r.toneB);
+			r.cycles = CycleCounterGet();
+
+			/* Every frame's result, latest wins, for a test bench or benchmark */
+			if (params->resultQ != NULL) {
+				xQueueOverwrite( params->resultQ, &r );
+			}
 
 #ifdef __DTMF_PERF__
 			t1 = xTaskGetTickCount();
@@ -66,12 +91,29 @@ void vDTMFDetectTask( void *pvParameters ) {
 #endif
 
 			// Send, but allow dropping
+#ifdef DTMF_BINARY_EVENTS
+			stats.frames++;
+			if(r.code != ' ')
+			{
+				stats.detections++;
+				event_send_detect(r.code, r.snr);
+			}
+			if(xTaskGetTickCount() - stats_last >= EVENT_STATS_PERIOD_MS / portTICK_RATE_MS)
+			{
+				stats_last = xTaskGetTickCount();
+				stats.tx_dropped = uart_tx_dropped;
+				stats.rx_overruns = uart_rx_overruns;
+				stats.tx_high_water = uart_tx_high_water;
+				event_send_stats(&stats);
+			}
+#else
 			if(r.code != ' ')
 			{
 				sprintf(output,"Detected code %c\r\n",r.code);
 				uart_send_noblock(output,strlen(output));
-				printf("Detected code %c\n",r.code);
+				LOG_INFO("Detected code %c\n", r.code);
 			}
+#endif
 		}
 	}
 }
@@ -79,11 +121,15 @@ void vDTMFDetectTask( void *pvParameters ) {
 /* Pick the DTMF tones from FFT resuts */
 /* threshold is the minimum amount above noise floor required to declare a tone */
 /* toneX ar the detected tones (Hz) */
-void pick_peaks(complex *cs, float threshold, int16_t *toneA, int16_t *toneB) {
+/* snr is the weaker detected tone's power over the average, 0 if none */
+void pick_peaks(complex *cs, float threshold, int16_t *toneA, int16_t *toneB, float *snr) {
 
 	*toneA = 0;
 	*toneB = 0;
+	*snr = 0.0f;
 	float avg = 0.0f;
+	float powA = 0.0f;
+	float powB = 0.0f;
 	int ii;
 
 	/* Compute the average spectrum power */
@@ -98,23 +144,35 @@ void pick_peaks(complex *cs, float threshold, int16_t *toneA, int16_t *toneB) {
 	/* check low bins for power */
 	if (cs[DTMF_L0_BIN].Re > threshold) {
 		*toneA = DTMF_L0_FREQ;
+		powA = cs[DTMF_L0_BIN].Re;
 	} else if (cs[DTMF_L1_BIN].Re > threshold) {
 		*toneA = DTMF_L1_FREQ;
+		powA = cs[DTMF_L1_BIN].Re;
 	} else if (cs[DTMF_L2_BIN].Re > threshold) {
 		*toneA = DTMF_L2_FREQ;
+		powA = cs[DTMF_L2_BIN].Re;
 	} else if (cs[DTMF_L3_BIN].Re > threshold) {
 		*toneA = DTMF_L3_FREQ;
+		powA = cs[DTMF_L3_BIN].Re;
 	}
 
 	/* check high bins for power */
 	if (cs[DTMF_H0_BIN].Re > threshold) {
 		*toneB = DTMF_H0_FREQ;
+		powB = cs[DTMF_H0_BIN].Re;
 	} else if (cs[DTMF_H1_BIN].Re > threshold) {
 		*toneB = DTMF_H1_FREQ;
+		powB = cs[DTMF_H1_BIN].Re;
 	} else if (cs[DTMF_H2_BIN].Re > threshold) {
 		*toneB = DTMF_H2_FREQ;
+		powB = cs[DTMF_H2_BIN].Re;
 	} else if (cs[DTMF_H3_BIN].Re > threshold) {
 		*toneB = DTMF_H3_FREQ;
+		powB = cs[DTMF_H3_BIN].Re;
+	}
+
+	if (avg > 0.0f) {
+		*snr = ((powA < powB) ? powA : powB) / avg;
 	}
 }
 
@@ -1,6 +1,8 @@
 #ifndef DTMF_DETECT_TASK_H
 #define DTMF_DETECT_TASK_H
 
+#include "fft/complex_numbers.h"
+
 /* Parameters passed to the task */
 struct DTMFDetectTaskParam_t {
 	QueueHandle_t sampQ;
@@ -9,4 +11,9 @@ struct DTMFDetectTaskParam_t {
 
 void vDTMFDetectTask( void *pvParameters );
 
+/* The task's analysis of one transformed frame, also run on the host by
+ * tools/loopback_host */
+void pick_peaks(complex *cs, float thresh, int16_t *toneA, int16_t *toneB, float *snr);
+int8_t decode_tones(int16_t toneA, int16_t toneB);
+
 #endif
@@ -0,0 +1,74 @@
+#include <string.h>
+#include "echo_cancel.h"
+
+void echo_cancel_init(struct EchoCanceller_t *ec) {
+	memset(ec, 0, sizeof(*ec));
+}
+
+/* Remove the echo of ref from the real parts of cs, in place.  The samples
+ * in cs are already scaled as the detector uses them; ref is raw ADC format
+ * and is scaled the same way here.  Both have their frame mean removed so
+ * the DC offsets of the two paths do not enter the filter. */
+void echo_cancel_frame(struct EchoCanceller_t *ec, complex *cs, const DTMFSampleType *ref, int n) {
+
+	float meanX = 0.0f;
+	float meanR = 0.0f;
+	float refPower = 0.0f;
+	float power = 0.0f;
+	int ii, kk;
+
+	for (ii=0; ii<n; ii++) {
+		meanX += cs[ii].Re;
+		meanR += (float)ref[ii] / 16384.0f;
+	}
+	meanX /= n;
+	meanR /= n;
+
+	for (ii=0; ii<n; ii++) {
+		float r = (float)ref[ii] / 16384.0f - meanR;
+		refPower += r * r;
+	}
+
+	/* Power of the history window, kept up to date as it slides */
+	for (kk=0; kk<ECHO_TAPS; kk++) {
+		power += ec->hist[kk] * ec->hist[kk];
+	}
+
+	for (ii=0; ii<n; ii++) {
+		float r = (float)ref[ii] / 16384.0f - meanR;
+		float x = cs[ii].Re - meanX;
+		float y = 0.0f;
+		float peak = 0.0f;
+		float e;
+
+		power -= ec->hist[ECHO_TAPS-1] * ec->hist[ECHO_TAPS-1];
+		for (kk=ECHO_TAPS-1; kk>0; kk--) {
+			ec->hist[kk] = ec->hist[kk-1];
+		}
+		ec->hist[0] = r;
+		power += r * r;
+		if (power < 0.0f) {
+			power = 0.0f;
+		}
+
+		for (kk=0; kk<ECHO_TAPS; kk++) {
+			float a = (ec->hist[kk] < 0.0f) ? -ec->hist[kk] : ec->hist[kk];
+			y += ec->w[kk] * ec->hist[kk];
+			if (a > peak) {
+				peak = a;
+			}
+		}
+		e = x - y;
+		cs[ii].Re = e;
+
+		/* Learn only from our own signal, not over the far end */
+		if (refPower > ECHO_MIN_REF_POWER * n &&
+			power > ECHO_MIN_REF_POWER * ECHO_TAPS &&
+			((x < 0.0f) ? -x : x) <= ECHO_DOUBLE_TALK * peak) {
+			float g = ECHO_STEP * e / power;
+			for (kk=0; kk<ECHO_TAPS; kk++) {
+				ec->w[kk] += g * ec->hist[kk];
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef ECHO_CANCEL_H
+#define ECHO_CANCEL_H
+
+#include <stdint.h>
+#include "dtmf_data.h"
+#include "fft/complex_numbers.h"
+
+/*
+ * Own-signal cancellation for the DTMF detector
+ *
+ * With DTMF_ECHO_CANCEL (main.h) the ADC task captures, for every sample, the
+ * value the DAC was driving when that sample's conversion started. Before
+ * detection the detector runs each frame through an NLMS filter of
+ * ECHO_TAPS taps on that reference, which learns the delay and gain of the
+ * path from the DAC to the ADC, and subtracts the estimate. Our own tones
+ * are removed, so the board can dial and listen at once without reporting
+ * its own digits, while tones from the far end pass through.
+ *
+ * Adaptation is held while the reference is quiet (nothing to learn from)
+ * and, per sample, while the input is louder than ECHO_DOUBLE_TALK times the
+ * recent reference peak (a Geigel detector: the far end is talking over us),
+ * so the filter is not pulled off by signals it should keep.
+ */
+
+#define ECHO_TAPS          8        //CONFIGURABLE - Longest DAC to ADC delay modelled, in samples
+#define ECHO_STEP          0.3f     //CONFIGURABLE - NLMS step size (0..1)
+#define ECHO_MIN_REF_POWER 1e-5f    // Mean reference power below which the filter holds
+#define ECHO_DOUBLE_TALK   1.5f     //CONFIGURABLE - Input over reference peak that holds adaptation
+
+struct EchoCanceller_t {
+	float w[ECHO_TAPS];       // filter taps
+	float hist[ECHO_TAPS];    // reference history, newest first
+};
+
+void echo_cancel_init(struct EchoCanceller_t *ec);
+void echo_cancel_frame(struct EchoCanceller_t *ec, complex *cs, const DTMFSampleType *ref, int n);
+
+#endif
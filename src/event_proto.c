@@ -0,0 +1,148 @@
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "event_proto.h"
+#include "uart.h"
+
+static uint8_t event_seq = 0;
+static TickType_t event_last = 0;
+
+/* CRC-16/CCITT-FALSE, a nibble at a time */
+static const uint16_t crc16_nibble[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+uint16_t event_crc16(const uint8_t *data, int len) {
+	uint16_t crc = 0xffff;
+	int ii;
+
+	for (ii = 0; ii < len; ii++) {
+		crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[ii] >> 4)];
+		crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[ii] & 0x0f)];
+	}
+	return crc;
+}
+
+/* COBS encode len bytes, appending the 0 delimiter. Returns the bytes
+ * written, at most len + len / 254 + 2. */
+int event_cobs_encode(const uint8_t *in, int len, uint8_t *out) {
+	int code_at = 0;
+	int o = 1;
+	uint8_t code = 1;
+	int ii;
+
+	for (ii = 0; ii < len; ii++) {
+		if (in[ii] == 0) {
+			out[code_at] = code;
+			code_at = o++;
+			code = 1;
+		} else {
+			out[o++] = in[ii];
+			if (++code == 0xff) {
+				out[code_at] = code;
+				code_at = o++;
+				code = 1;
+			}
+		}
+	}
+	out[code_at] = code;
+	out[o++] = 0;
+	return o;
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+	return p + 4;
+}
+
+/* Starts a record in buf, leaving room for its time stamp, and returns
+ * where the body goes */
+static uint8_t *event_begin(uint8_t *buf, uint8_t type) {
+	buf[0] = type;
+	return buf + 2 + ((type == EVENT_DETECT) ? 2 : 4);
+}
+
+/* Stamps the record with its seq and time, adds the CRC, frames it and
+ * queues it. Several tasks send records, so this runs with the scheduler
+ * suspended: frames go out in seq order and each delta is taken against
+ * the frame queued just before it. */
+static int event_finish(uint8_t *buf, uint8_t *end) {
+	uint8_t frame[EVENT_FRAME_MAX];
+	int len = end - buf;
+	TickType_t now;
+	uint32_t delta;
+	int ret;
+
+	vTaskSuspendAll();
+	now = xTaskGetTickCount();
+	buf[1] = event_seq++;
+	if (buf[0] == EVENT_DETECT) {
+		delta = (now - event_last) * portTICK_RATE_MS;
+		put_u16(buf + 2, (delta > 0xffff) ? 0xffff : (uint16_t)delta);
+	} else {
+		put_u32(buf + 2, now * portTICK_RATE_MS);
+	}
+	event_last = now;
+
+	end = put_u16(end, event_crc16(buf, len));
+	len = event_cobs_encode(buf, len + 2, frame);
+	ret = uart_send_noblock((char *)frame, len);
+	xTaskResumeAll();
+	return ret;
+}
+
+/* Power ratio to half dB steps: 10 log10(x) = 3.0103 log2(x), with log2
+ * taken from the float's exponent and a straight line through the
+ * mantissa (within 0.3 dB) */
+static uint8_t event_snr(float ratio) {
+	union { float f; uint32_t u; } v;
+	float half_db;
+
+	if (ratio <= 1.0f) {
+		return 0;
+	}
+	v.f = ratio;
+	half_db = 6.0206f * ((float)((int32_t)((v.u >> 23) & 0xff) - 127) +
+	                     (float)(v.u & 0x7fffff) / 8388608.0f);
+	return (half_db >= 255.0f) ? 255 : (uint8_t)(half_db + 0.5f);
+}
+
+int event_send_detect(char code, float snr) {
+	uint8_t buf[2 + EVENT_MAX_BODY + 2];
+	uint8_t *p = event_begin(buf, EVENT_DETECT);
+
+	*p++ = (uint8_t)code;
+	*p++ = event_snr(snr);
+	return event_finish(buf, p);
+}
+
+int event_send_stats(const struct EventStats_t *st) {
+	uint8_t buf[2 + EVENT_MAX_BODY + 2];
+	uint8_t *p = event_begin(buf, EVENT_STATS);
+
+	p = put_u32(p, st->frames);
+	p = put_u32(p, st->detections);
+	p = put_u32(p, st->tx_dropped);
+	p = put_u32(p, st->rx_overruns);
+	p = put_u16(p, st->tx_high_water);
+	return event_finish(buf, p);
+}
+
+int event_send_ack(uint8_t command, uint8_t status) {
+	uint8_t buf[2 + EVENT_MAX_BODY + 2];
+	uint8_t *p = event_begin(buf, EVENT_ACK);
+
+	*p++ = command;
+	*p++ = status;
+	return event_finish(buf, p);
+}
@@ -4,7 +4,8 @@
 
 #include "fft.h"
 
-complex** Wn_k;   //Arrays containing the complex Wn^k required for FFT
+complex* Wn_k[FFT_LOG_MAX_SIZE];           //Arrays containing the complex Wn^k required for FFT
+static complex Wn_storage[MAX_FFT_SIZE-1];  //Backing store of all of them, 1+2+...+MAX_FFT_SIZE/2
 complex unity = {.Re = 1, .Im = 0};
 complex negative_unity = {.Re = -1, .Im = 0};
 
@@ -19,17 +20,18 @@ const unsigned char lookup[16] = {  //Lookup table for bit-reversed order
  * the size 2 iteration requires a size 1 Wn^k array, the size 4 iteration
  * requires a size 2 Wn^k array, and so on.  The size of the Wn^k array is half
  * the size of the FFT since we can take advantage of the symmetry of the Wns.
+ * The arrays are carved out of Wn_storage, so nothing is allocated.
  * Parameters: none
  * Returns: void
  */
 void init_Wn()
 {
-	int num_Wn_arrays = logTwo(MAX_FFT_SIZE);
-	Wn_k = malloc(sizeof(complex*)*num_Wn_arrays);
-	for(int i=0; i<num_Wn_arrays; ++i)
+	complex* next = Wn_storage;
+	for(int i=0; i<FFT_LOG_MAX_SIZE; ++i)
 	{
 		int N = powTwo(i+1);                       //N = FFT size
-		Wn_k[i] = malloc(sizeof(complex)*N/2);     //Wn^k = exp(-j*2PI*k/N), 0<=k<=N-1
+		Wn_k[i] = next;                            //Wn^k = exp(-j*2PI*k/N), 0<=k<=N-1
+		next += N/2;
 
 		for(int k=0; k<N/2; ++k)
 		{
@@ -40,18 +42,12 @@ void init_Wn()
 	}
 }
 
-/* Frees the memory associated with the Wn^k arrays
+/* Releases the Wn^k arrays. They are static, so there is nothing to free.
  * Parameters: none
  * Returns: void
  */
 void teardown_Wn()
 {
-	int num_Wn_arrays = logTwo(MAX_FFT_SIZE);
-	for(int i=0; i<num_Wn_arrays; ++i)
-	{
-		free(Wn_k[i]);
-	}
-	free(Wn_k);
 }
 
 /* Computes an FFT
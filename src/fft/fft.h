@@ -7,8 +7,9 @@
 #include "trig_approximations.h"
 
 #define MAX_FFT_SIZE 256
+#define FFT_LOG_MAX_SIZE 8   //logTwo(MAX_FFT_SIZE), the number of Wn^k arrays
 
-extern complex** Wn_k;   //Arrays containing the complex Wn^k required for FFT
+extern complex* Wn_k[FFT_LOG_MAX_SIZE];   //Arrays containing the complex Wn^k required for FFT
 extern complex unity;
 extern complex negative_unity;
 
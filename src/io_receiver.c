@@ -9,34 +9,52 @@
  * vIoRxTask
  *
  * Description:
- *   This task runs in an infinite loop checking the xIoQueue for a message.
+ *   This task runs in an infinite loop waiting on xIoEventSet for a key from
+ *   xIoQueue or a command line from the UART on xUartCmdQueue.
  *   If a message contains a character, the task will validate the following
  *   characters.
- *   (1) If character is in the range of 'a'-'d' or 'A'-'D', send the embedded
- *       10 digits number (speed dial) to DAC via function xSend_Dac_Char()
- *       followed by '\0' (release key indicator).
+ *   (1) If character is in the range of 'a'-'d' or 'A'-'D', dial the embedded
+ *       10 digits number (speed dial) via xDialNumber().
  *   (2) If character is in the range of '0'-'9' send the single character
  *       to DAC via function xSend_Dac_Char() followed by '\0' (release key
  *       indicator).
- *   (3) If character is '+', send the embedded 10 digits number from UART to
- *       DAC via function xSend_Dac_Char(), followed by '\0' (release key
- *       indicator).
+ *   (3) KEYPAD_CHORD_SYMBOL: keys held together on the keypad, dialled in
+ *       the order they were pressed via xDialNumber().
+ *   With KEYPAD_FAST_TONE (keypad.h) the keypad interrupt starts digit
+ *   tones itself, so only its other keys, or a digit it could not queue,
+ *   arrive here.
+ *   A UART command is a whole line, of any length up to UART_CMD_LENGTH:
+ *   the dial string after an optional leading '+' is dialled via
+ *   xDialNumber() and the command buffer handed back to the UART.
+ *
+ *   With TONEGEN_USE_TONE_TABLES a number is handed to ToneSequencePlay(),
+ *   which compiles it into DMA programs of tones and silences a few digits
+ *   at a time, so the digit timing is sample accurate. This task waits
+ *   only until the last of them is queued.
  *
  *   Otherwise return immediately if the queue is already empty.
  *
  * Inputs:
  *   xIoQueue - Message Queue for Character Input Requests
+ *   xUartCmdQueue - Message Queue for UART Command Lines (uart_command_t*)
  *
  * Outputs:
  *   xQueueToneInput - Message Queue for New Tone Requests to DAC
  *
  */
 #include "io_receiver.h"
+#include "tonegen.h"
+#include "event_proto.h"
+#include "keypad.h"
 
 extern xQueueHandle xIoQueue;
+extern xQueueHandle xUartCmdQueue;
+extern QueueSetHandle_t xIoEventSet;
 
 // Forward declaration
 portBASE_TYPE xSend_Dac_Char( const char *pcChar );
+portBASE_TYPE xDialNumber( const char *pcNumber, uint32_t ulCount );
+void vUartCommand( uart_command_t *pxCmd );
 
 //=============================================================================
 // vIoRxTask() - IO Receive Task
@@ -47,20 +65,32 @@ void vIoRxTask( void *pvParameters )
   cIoMsg cIoMsgBuf;
   static char xDacTxChar;
   portBASE_TYPE xStatus;
-  const portTickType xTicksToWait = 100 / portTICK_RATE_MS;
-  TickType_t xLastWakeTime;
-  const TickType_t xPeriod_200ms = (200 / portTICK_RATE_MS);
-  const TickType_t xPeriod_10ms  = (10 / portTICK_RATE_MS);
+  QueueSetMemberHandle_t xActivated;
+  uart_command_t *pxCmd;
+  char cChord[KEYPAD_KEYS];
+  uint32_t ulChordLength;
 
   char speed_dial_number[SPEED_DAIL_NUMBER_COUNT]={"2246250000"};
 
-  //set the UART to receive every ten characters
-  uart_receive_block(NUMBER_COUNT, &xIoQueue);
+  //have the UART post whole command lines
+  uart_receive_commands(xUartCmdQueue);
 
   /* This task is also defined within an infinite loop. */
   for( ;; )
   {
-	xStatus = xQueueReceive( xIoQueue, &cIoMsgBuf, portMAX_DELAY );
+	xActivated = xQueueSelectFromSet( xIoEventSet, portMAX_DELAY );
+
+	if( xActivated == xUartCmdQueue )
+	{
+	  pxCmd = uart_cmd_poolReceive( xUartCmdQueue, 0 );
+	  if( pxCmd != NULL )
+	  {
+	    vUartCommand( pxCmd );
+	  }
+	  continue;
+	}
+
+	xStatus = xQueueReceive( xIoQueue, &cIoMsgBuf, 0 );
 
 	if( xStatus == pdPASS )
 	{
@@ -68,19 +98,7 @@ void vIoRxTask( void *pvParameters )
 	  if( (cIoMsgBuf >= 'a' && cIoMsgBuf <= 'd') ||
           (cIoMsgBuf >= 'A' && cIoMsgBuf <= 'D') )
 	  {
-	    for(int i=0; i<SPEED_DAIL_NUMBER_COUNT; i++)
-	    {
-	      // Send one character
-	      xDacTxChar = speed_dial_number[i];
-	      xSend_Dac_Char(&xDacTxChar);
-		  vTaskDelayUntil( &xLastWakeTime, xPeriod_200ms);
-
-		  // Send null - keypad released.
-		  // For autodial, we need to manually insert pauses
-		  xDacTxChar = '\0';     // button released
-	      xSend_Dac_Char(&xDacTxChar);
-		  vTaskDelayUntil( &xLastWakeTime, xPeriod_10ms);
-		}
+	    xDialNumber(speed_dial_number, SPEED_DAIL_NUMBER_COUNT);
 	  }
 
 	  else if(cIoMsgBuf >= '0' && cIoMsgBuf <= '9')
@@ -96,32 +114,22 @@ void vIoRxTask( void *pvParameters )
 	    vTaskDelayUntil( &xLastWakeTime, xPeriod_10ms);*/
 	  }
 
+	  // Keys held together on the keypad, dialled in the order pressed
+	  else if(cIoMsgBuf == KEYPAD_CHORD_SYMBOL)
+	  {
+	    ulChordLength = KeypadChordGet(cChord);
+	    if( ulChordLength > 0 )
+	    {
+	      xDialNumber(cChord, ulChordLength);
+	    }
+	  }
+
 	  //button released
 	  else if(cIoMsgBuf == '\0')
 	  {
 		  xDacTxChar = cIoMsgBuf;
 		  xSend_Dac_Char(&xDacTxChar);
 	  }
-
-	  // Message from UART with 10 characters in message buffer.
-	  // When we receive this character, we know that NUMBER_COUNT
-	  else if(cIoMsgBuf == '+')
-	  {
-        for(int i=0; i<NUMBER_COUNT; i++)
-		{
-          xQueueReceive( xIoQueue, &cIoMsgBuf, 0 );
-
-          // Send one character
-          xDacTxChar = cIoMsgBuf;
-          xSend_Dac_Char(&xDacTxChar);
-          vTaskDelayUntil( &xLastWakeTime, xPeriod_200ms);
-
-          // Send null - keypad released.
-	      xDacTxChar = '\0';     // button released
-          xSend_Dac_Char(&xDacTxChar);
-          vTaskDelayUntil( &xLastWakeTime, xPeriod_10ms);
-        }
-      }
 	}
 	else
 	{
@@ -131,6 +139,74 @@ void vIoRxTask( void *pvParameters )
   }
 }
 
+//=============================================================================
+// vUartCommand() - Act on one command line from the UART
+//=============================================================================
+void vUartCommand( uart_command_t *pxCmd )
+{
+  const char *pcText = pxCmd->text;
+  uint32_t ulLength = pxCmd->length;
+#ifdef DTMF_BINARY_EVENTS
+  portBASE_TYPE xStatus = pdPASS;
+#endif
+
+  // Dial string, the '+' of the old fixed length messages is optional
+  if( ulLength > 0 && pcText[0] == '+' )
+  {
+    pcText++;
+    ulLength--;
+  }
+#ifdef DTMF_BINARY_EVENTS
+  if( ulLength > 0 )
+  {
+    xStatus = xDialNumber( pcText, ulLength );
+  }
+  event_send_ack( '+', ( xStatus == pdPASS ) ? 0 : 1 );
+#else
+  if( ulLength > 0 )
+  {
+    xDialNumber( pcText, ulLength );
+  }
+#endif
+
+  uart_command_release( pxCmd );
+}
+
+//=============================================================================
+// xDialNumber() - Play a number as a timed sequence of tones
+//=============================================================================
+portBASE_TYPE xDialNumber( const char *pcNumber, uint32_t ulCount )
+{
+#ifdef TONEGEN_USE_TONE_TABLES
+  if( ToneSequencePlay( pcNumber, ulCount, TONE_SEQ_ON_MS, TONE_SEQ_OFF_MS ) != pdPASS )
+  {
+    LOG_ERROR("Could not dial the number.\n");
+    return pdFAIL;
+  }
+  return pdPASS;
+#else
+  // No tables to sequence, press and release each key on a fixed schedule
+  char xDacTxChar;
+  TickType_t xLastWakeTime = xTaskGetTickCount();
+
+  for( uint32_t i = 0; i < ulCount; i++ )
+  {
+    if( pcNumber[i] == '\0' )
+    {
+      continue;
+    }
+    xDacTxChar = pcNumber[i];
+    xSend_Dac_Char(&xDacTxChar);
+    vTaskDelayUntil( &xLastWakeTime, TONE_SEQ_ON_MS / portTICK_RATE_MS );
+
+    xDacTxChar = '\0';     // button released
+    xSend_Dac_Char(&xDacTxChar);
+    vTaskDelayUntil( &xLastWakeTime, TONE_SEQ_OFF_MS / portTICK_RATE_MS );
+  }
+  return pdPASS;
+#endif
+}
+
 //=============================================================================
 // xSend_Dac_Char() - Send character to DAC
 //=============================================================================
@@ -144,11 +220,11 @@ portBASE_TYPE xSend_Dac_Char( const char *pcChar )
   xStatus = xQueueSendToBack( xQueueToneInput, pcChar, xTicksToWait );
   if( xStatus != pdPASS )
   {
-    vPrintString( "Could not send to the xQueueToneInput.\n" );
+    LOG_ERROR("Could not send to the xQueueToneInput.\n");
   }
 #endif
 
-  vPrintString( "xSend_Dac_Char " );
+  LOG_DEBUG("xSend_Dac_Char %c\n", *pcChar);
   //vPrintChar(pcChar);
 
   return xStatus;
@@ -11,9 +11,9 @@
 #include "main.h"
 #include "uart.h"
 
-#define NUMBER_COUNT 10
 #define SPEED_DAIL_NUMBER_COUNT 10
 #define IO_BUFFER_SIZE 16
+#define IO_EVENT_SET_SIZE (IO_BUFFER_SIZE + UART_CMD_BUFFERS)
 
 typedef char cIoMsg;   // IO message buffer
 
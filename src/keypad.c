@@ -6,6 +6,15 @@
  */
 
 #include "keypad.h"
+#include "log.h"
+#include "tonegen.h"
+#include "prompt.h"
+#include "cyclecount.h"
+#include <string.h>
+
+#if defined(KEYPAD_FAST_TONE) && defined(TONEGEN_USE_TONE_TABLES)
+#define KEYPAD_FAST_PATH
+#endif
 
 
 /*****************************************************************************
@@ -17,6 +26,7 @@
 #define OUTPUT_PIN_MAX (OUTPUT_PIN_MIN +3)
 #define INPUT_PIN_MIN (OUTPUT_PIN_MAX +1)
 #define INPUT_PIN_MAX (INPUT_PIN_MIN +3)
+#define INPUT_PIN_MASK (0xF << INPUT_PIN_MIN)
 #define FALSE 0
 #define TRUE 1
 
@@ -26,10 +36,10 @@
 #define LOW 0
 #define HIGH 1
 
-#define PRESSED_SUPPRESS 2
-#define PRESSED 1
-#define DEPRESSED 0
-#define DEBOUNCE_TIME 10
+#define KEYPAD_ROWS 4
+#define KEYPAD_COLS 4
+#define KEYPAD_NO_KEY 0xFF
+
 static LPC_GPIO_TypeDef (* const LPC_GPIO[5]) =
 {
 LPC_GPIO0,
@@ -44,20 +54,66 @@ static char symbolDef[4][4] =
  '1', '2', '3', 'A', '4', '5', '6', 'B', '7', '8', '9', 'C', '*', '0', '#', 'D'
 };
 
-static int buttonState[4][4] =
-{
-DEPRESSED, DEPRESSED, DEPRESSED, DEPRESSED,
-DEPRESSED, DEPRESSED, DEPRESSED, DEPRESSED,
-DEPRESSED, DEPRESSED, DEPRESSED, DEPRESSED,
-DEPRESSED, DEPRESSED, DEPRESSED, DEPRESSED
-};
+/*
+ * Scan state, owned by the TIMER1 and EINT3 interrupts
+ *
+ * keyCount is each key's integrating debounce counter: it counts up for
+ * every scan that sees the key closed and down for every scan that sees it
+ * open, between 0 and KEYPAD_DEBOUNCE_SAMPLES. The key is taken as down
+ * when the count reaches the top and as up when it gets back to 0, so a
+ * bouncing contact has to settle before either is reported.
+ */
+static uint8_t keyCount[KEYPAD_ROWS][KEYPAD_COLS];
+static uint16_t keyHeld = 0;               // debounced state, bit row * 4 + col
+static uint8_t scanRow = 0;
+static xQueueHandle *keypadQueue = NULL;
+
+volatile uint32_t keypadDropped = 0;
 
 /*
- * Declare a variable of type SemaphoreHandle_t. This is used
- * for interrupt gpioInterfaceTask task execution control.
+ * Event ring, written by the scan interrupt only. keypadEventHead counts
+ * every event ever written; the writer fills the slot before it moves the
+ * head on, so a reader knows the slot at cursor is whole while the head
+ * is less than a ring ahead of it.
  */
+static KEYPAD_EVENT keypadEvents[KEYPAD_EVENT_RING];
+static volatile uint32_t keypadEventHead = 0;
 
-static SemaphoreHandle_t xButtonChangeStateSemaphore;
+/* Key sounding now, if any, and whether the interrupt started it itself */
+static uint8_t soundKey = KEYPAD_NO_KEY;
+#ifdef KEYPAD_FAST_PATH
+static uint8_t soundFast = FALSE;
+#endif
+
+#if KEYPAD_POLICY == KEYPAD_POLICY_LAST_KEY
+static uint32_t pressCount = 0;
+static uint32_t pressOrder[KEYPAD_KEYS];   // pressCount at each key's last press
+#elif KEYPAD_POLICY == KEYPAD_POLICY_QUEUE
+#define QUEUE_IDLE 0
+#define QUEUE_TONE 1
+#define QUEUE_GAP 2
+static uint8_t queueState = QUEUE_IDLE;
+static uint32_t queueCursor = 0;           // next event to look for a press from
+static uint32_t queuePress;                // event of the press sounding
+static uint32_t queueSince;                // tick the tone or gap began
+#elif KEYPAD_POLICY == KEYPAD_POLICY_CHORD
+static uint8_t chordActive = FALSE;
+static uint8_t chordLength = 0;
+static char chordKeys[KEYPAD_KEYS];
+static volatile uint8_t chordReadyLength = 0;
+static char chordReady[KEYPAD_KEYS];
+#else
+#error Unknown KEYPAD_POLICY
+#endif
+
+#ifdef KEYPAD_LATENCY_STATS
+/* Cycle counter at the first closed sample of each key, and at the press
+ * of the last fast tone */
+static uint32_t keyFirstCycles[KEYPAD_KEYS];
+static volatile uint32_t fastFirstCycles;
+static volatile uint32_t fastPressCycles;
+#endif
+KEYPAD_LATENCY keypadLatency;
 
 /* GPIOSetValue - Set pin value */
 static void GPIOSetValue(uint32_t portNum, uint32_t bitPosi, uint32_t bitVal);
@@ -65,9 +121,6 @@ static void GPIOSetValue(uint32_t portNum, uint32_t bitPosi, uint32_t bitVal);
 /* GPIOSetDir - Set pin direction */
 static void GPIOSetDir(uint32_t portNum, uint32_t bitPosi, uint32_t dir);
 
-/* GPIOGetValue - Get pin value */
-static uint32_t GPIOGetValue(uint32_t portNum, uint32_t bitPosi);
-
 /* GPIOGetValue - Set all out pins */
 static void GPIOSetAllOutputPins(uint32_t dir, uint32_t setDir);
 
@@ -76,9 +129,9 @@ static void GPIOSetAllOutputPins(uint32_t dir, uint32_t setDir);
  *****************************************************************************/
 
 /*
- * The priority of the software interrupt. The interrupt
- * service routine uses  an (interrupt safe) FreeRTOS API
- * function, so the priority of the interrupt must be
+ * The priority of the keypad interrupts. The interrupt
+ * service routines use (interrupt safe) FreeRTOS API
+ * functions, so the priority of the interrupt must be
  * equal to or lower than the priority set by
  * configMAX_SYSCALL_INTERRUPT_PRIORITY - remembering that
  * on the Cortex-M3 high  numeric values represent low priority
@@ -87,26 +140,404 @@ static void GPIOSetAllOutputPins(uint32_t dir, uint32_t setDir);
  */
 
 #define EINT3_INTERRUPT_PRIORITY ( 30 )
+#define TIMER1_INTERRUPT_PRIORITY ( 30 )
 
-/* Int. Handler */
-void vSoftwareInterruptHandler(void);
-
-/* Int. Handler */
+/* Int. Handlers */
 void EINT3_IRQHandler(void);
+void TIMER1_IRQHandler(void);
+
+/*
+ * Starts scanning: every row high but the first, and the timer
+ * running. The edge interrupts stay off until the keypad is idle again.
+ */
+static void KeypadScanStart(void)
+{
+  LPC_GPIOINT->IO2IntEnF &= ~INPUT_PIN_MASK;
+  LPC_GPIOINT->IO2IntClr = INPUT_PIN_MASK;
+
+  GPIOSetAllOutputPins(HIGH, FALSE);
+  scanRow = 0;
+  GPIOSetValue(PORT_NUM_IO, OUTPUT_PIN_MIN, LOW);
+
+  LPC_TIM1->TCR = 2;                       // reset
+  LPC_TIM1->TCR = 1;                       // enable
+}
+
+/*
+ * Stops scanning once every key is up: all rows low, so any key pulls
+ * its column low, and a falling edge on a column starts the scan again.
+ * Returns FALSE, still scanning, if a key went down meanwhile.
+ */
+static int KeypadScanIdle(void)
+{
+  LPC_TIM1->TCR = 0;
+  LPC_TIM1->IR = 1;
+  GPIOSetAllOutputPins(LOW, FALSE);
+
+  LPC_GPIOINT->IO2IntClr = INPUT_PIN_MASK;
+  LPC_GPIOINT->IO2IntEnF |= INPUT_PIN_MASK;
+
+  // A key closed before the edge interrupt was armed has no edge to come
+  if ((LPC_GPIO[PORT_NUM_IO]->FIOPIN & INPUT_PIN_MASK) != INPUT_PIN_MASK)
+  {
+    KeypadScanStart();
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/*
+ * Sends a key's symbol, or 0, to the IO receiver
+ */
+static void KeypadSend(char value, portBASE_TYPE *woken)
+{
+  if (keypadQueue == NULL || xQueueSendToBackFromISR(*keypadQueue, &value, woken) != pdPASS)
+  {
+    keypadDropped++;
+  }
+}
 
+#ifdef KEYPAD_FAST_PATH
+/*
+ * Starts or stops a digit's tone from the interrupt and tells the tone
+ * generator it has been done. Returns FALSE, having done nothing, if the
+ * DAC request could not be queued.
+ */
+static uint32_t KeypadFastTone(uint8_t key, char value, portBASE_TYPE *woken)
+{
+  char request = (char)(value | TONE_REQ_STARTED);
 
+  if (PlayToneTableFromISR(value, woken) != pdPASS)
+  {
+    return FALSE;
+  }
+  PromptCancelFromISR();
+#ifdef KEYPAD_LATENCY_STATS
+  if (value != 0)
+  {
+    fastFirstCycles = keyFirstCycles[key];
+    fastPressCycles = CycleCounterGet();
+  }
+#endif
+  if (xQueueSendToBackFromISR(xQueueToneInput, &request, woken) != pdPASS)
+  {
+    keypadDropped++;
+  }
+  return TRUE;
+}
+#endif
+
+/*
+ * Sounds a key, in place of any key sounding. With KEYPAD_FAST_TONE a
+ * digit is started here, anything else goes to the IO receiver.
+ */
+static void KeypadToneOn(uint8_t key, portBASE_TYPE *woken)
+{
+  char value = symbolDef[key / KEYPAD_COLS][key % KEYPAD_COLS];
+
+  soundKey = key;
+#ifdef KEYPAD_FAST_PATH
+  soundFast = value >= '0' && value <= '9' && KeypadFastTone(key, value, woken);
+  if (soundFast)
+  {
+    return;
+  }
+#endif
+  KeypadSend(value, woken);
+}
+
+/*
+ * Stops the key sounding, if any
+ */
+static void KeypadToneOff(portBASE_TYPE *woken)
+{
+  if (soundKey == KEYPAD_NO_KEY)
+  {
+    return;
+  }
+#ifdef KEYPAD_FAST_PATH
+  if (soundFast)
+  {
+    soundFast = FALSE;
+    if (KeypadFastTone(soundKey, 0, woken))
+    {
+      soundKey = KEYPAD_NO_KEY;
+      return;
+    }
+  }
+#endif
+  soundKey = KEYPAD_NO_KEY;
+  KeypadSend(0, woken);
+}
+
+#if KEYPAD_POLICY == KEYPAD_POLICY_QUEUE
+/*
+ * Plays the backlog of presses, one at a time. Runs on every event and
+ * every scan tick, and returns TRUE while it has more to play.
+ */
+static uint32_t KeypadPolicyRun(uint32_t now, portBASE_TYPE *woken)
+{
+  KEYPAD_EVENT *press;
+  KEYPAD_EVENT *ev;
+  uint32_t hold;
+  uint32_t i;
+
+  for (;;)
+  {
+    switch (queueState)
+    {
+    case QUEUE_IDLE:
+      // Presses overwritten before their turn are lost
+      if (keypadEventHead - queueCursor > KEYPAD_EVENT_RING)
+      {
+        keypadDropped++;
+        queueCursor = keypadEventHead - KEYPAD_EVENT_RING;
+      }
+      while (queueCursor != keypadEventHead &&
+             !keypadEvents[queueCursor % KEYPAD_EVENT_RING].down)
+      {
+        queueCursor++;
+      }
+      if (queueCursor == keypadEventHead)
+      {
+        return FALSE;
+      }
+      queuePress = queueCursor++;
+      queueSince = now;
+      queueState = QUEUE_TONE;
+      KeypadToneOn(keypadEvents[queuePress % KEYPAD_EVENT_RING].key, woken);
+      return TRUE;
+
+    case QUEUE_TONE:
+      // Held as long as it was, once its release is in the ring
+      hold = KEYPAD_QUEUE_MIN_MS / portTICK_RATE_MS;
+      if (keypadEventHead - queuePress < KEYPAD_EVENT_RING)
+      {
+        press = &keypadEvents[queuePress % KEYPAD_EVENT_RING];
+        for (i = queuePress + 1; i != keypadEventHead; i++)
+        {
+          ev = &keypadEvents[i % KEYPAD_EVENT_RING];
+          if (ev->key == press->key && !ev->down)
+          {
+            break;
+          }
+        }
+        if (i == keypadEventHead)
+        {
+          return TRUE;
+        }
+        if (ev->tick - press->tick > hold)
+        {
+          hold = ev->tick - press->tick;
+        }
+      }
+      if (now - queueSince < hold)
+      {
+        return TRUE;
+      }
+      KeypadToneOff(woken);
+      queueSince = now;
+      queueState = QUEUE_GAP;
+      return TRUE;
+
+    case QUEUE_GAP:
+      if (now - queueSince < KEYPAD_QUEUE_GAP_MS / portTICK_RATE_MS)
+      {
+        return TRUE;
+      }
+      queueState = QUEUE_IDLE;
+      break;
+    }
+  }
+}
+#else
+static uint32_t KeypadPolicyRun(uint32_t now, portBASE_TYPE *woken)
+{
+  return FALSE;
+}
+#endif
+
+/*
+ * Records a debounced press or release in the event ring and lets the
+ * policy act on it
+ */
+static void KeypadEvent(uint32_t row, uint32_t col, uint32_t down, portBASE_TYPE *woken)
+{
+  uint8_t key = row * KEYPAD_COLS + col;
+  uint32_t now = xTaskGetTickCountFromISR();
+  KEYPAD_EVENT *ev = &keypadEvents[keypadEventHead % KEYPAD_EVENT_RING];
+#if KEYPAD_POLICY == KEYPAD_POLICY_LAST_KEY
+  uint32_t newest;
+  uint8_t next;
+  uint8_t k;
+#endif
+
+  if (down)
+  {
+    keyHeld |= 1 << key;
+  }
+  else
+  {
+    keyHeld &= ~(1 << key);
+  }
+
+  ev->tick = now;
+  ev->key = key;
+  ev->symbol = symbolDef[row][col];
+  ev->down = down;
+  __DMB();
+  keypadEventHead++;
+
+#if DEBUG_KEYPAD
+  LOG_DEBUG(down ? "Pressed %c @ key %lu\n" : "Depressed %c @ key %lu\n", symbolDef[row][col], key);
+#endif
+
+#if KEYPAD_POLICY == KEYPAD_POLICY_LAST_KEY
+  if (down)
+  {
+    pressOrder[key] = ++pressCount;
+    KeypadToneOn(key, woken);
+  }
+  else if (key == soundKey)
+  {
+    // Back to the newest key still held
+    next = KEYPAD_NO_KEY;
+    newest = 0;
+    for (k = 0; k < KEYPAD_KEYS; k++)
+    {
+      if ((keyHeld & (1 << k)) && pressCount - pressOrder[k] <= pressCount - newest)
+      {
+        newest = pressOrder[k];
+        next = k;
+      }
+    }
+    if (next != KEYPAD_NO_KEY)
+    {
+      KeypadToneOn(next, woken);
+    }
+    else
+    {
+      KeypadToneOff(woken);
+    }
+  }
+#elif KEYPAD_POLICY == KEYPAD_POLICY_QUEUE
+  KeypadPolicyRun(now, woken);
+#elif KEYPAD_POLICY == KEYPAD_POLICY_CHORD
+  if (down)
+  {
+    if (!chordActive && keyHeld == (1 << key))
+    {
+      // Alone, so far
+      chordLength = 0;
+      KeypadToneOn(key, woken);
+    }
+    else if (!chordActive)
+    {
+      chordActive = TRUE;
+      KeypadToneOff(woken);
+    }
+    if (chordLength < KEYPAD_KEYS)
+    {
+      chordKeys[chordLength++] = symbolDef[row][col];
+    }
+  }
+  else if (!chordActive)
+  {
+    KeypadToneOff(woken);
+  }
+  else if (keyHeld == 0)
+  {
+    // Chord complete, hand it over unless the last one is still waiting
+    chordActive = FALSE;
+    if (chordReadyLength == 0)
+    {
+      memcpy(chordReady, chordKeys, chordLength);
+      chordReadyLength = chordLength;
+      KeypadSend(KEYPAD_CHORD_SYMBOL, woken);
+    }
+    else
+    {
+      keypadDropped++;
+    }
+  }
+#endif
+}
+
+/*
+ * An edge on a column while idle - start scanning
+ */
 void EINT3_IRQHandler(void)
+{
+  KeypadScanStart();
+  NVIC_ClearPendingIRQ(EINT3_IRQn);
+}
+
+/*
+ * One row per tick: sample the columns of the row driven low since the
+ * last tick (so it has had a whole tick to settle), update their
+ * debounce counters, then drive the next row
+ */
+void TIMER1_IRQHandler(void)
 {
   portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
-  NVIC_DisableIRQ(EINT3_IRQn);
-  /* 'Give' the semaphore to unblock the task. */
-  xSemaphoreGiveFromISR(xButtonChangeStateSemaphore, &xHigherPriorityTaskWoken);
-
-  /* Giving the semaphore may have unblocked a task - if it did and the
-  unblocked task has a priority equal to or above the currently executing
-  task then xHigherPriorityTaskWoken will have been set to pdTRUE and
-  portEND_SWITCHING_ISR() will force a context switch to the newly
-  unblocked higher priority task.*/
+  uint32_t pins;
+  uint32_t col;
+  uint32_t busy;
+  uint32_t row;
+
+  LPC_TIM1->IR = 1;
+  pins = ~LPC_GPIO[PORT_NUM_IO]->FIOPIN >> INPUT_PIN_MIN;
+
+  for (col = 0; col < KEYPAD_COLS; col++)
+  {
+    uint8_t *count = &keyCount[scanRow][col];
+    uint32_t bit = scanRow * KEYPAD_COLS + col;
+
+    if (pins & (1 << col))
+    {
+#ifdef KEYPAD_LATENCY_STATS
+      if (*count == 0)
+      {
+        keyFirstCycles[bit] = CycleCounterGet();
+      }
+#endif
+      if (*count < KEYPAD_DEBOUNCE_SAMPLES && ++*count == KEYPAD_DEBOUNCE_SAMPLES &&
+          !(keyHeld & (1 << bit)))
+      {
+        KeypadEvent(scanRow, col, TRUE, &xHigherPriorityTaskWoken);
+      }
+    }
+    else if (*count > 0 && --*count == 0 && (keyHeld & (1 << bit)))
+    {
+      KeypadEvent(scanRow, col, FALSE, &xHigherPriorityTaskWoken);
+    }
+  }
+  busy = KeypadPolicyRun(xTaskGetTickCountFromISR(), &xHigherPriorityTaskWoken);
+
+  GPIOSetValue(PORT_NUM_IO, OUTPUT_PIN_MIN + scanRow, HIGH);
+  scanRow = (scanRow + 1) % KEYPAD_ROWS;
+
+  // After a whole pass with every counter at rest, and nothing left for
+  // the policy to play, go back to waiting for an edge
+  if (scanRow == 0)
+  {
+    for (row = 0; row < KEYPAD_ROWS; row++)
+    {
+      for (col = 0; col < KEYPAD_COLS; col++)
+      {
+        busy |= keyCount[row][col];
+      }
+    }
+    if (!busy && KeypadScanIdle())
+    {
+      NVIC_ClearPendingIRQ(TIMER1_IRQn);
+      portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+      return;
+    }
+  }
+  GPIOSetValue(PORT_NUM_IO, OUTPUT_PIN_MIN + scanRow, LOW);
+
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);
   portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
 
@@ -137,19 +568,6 @@ static void GPIOSetDir(uint32_t portNum, uint32_t bitPosi, uint32_t dir)
     LPC_GPIO[portNum]->FIODIR &= ~(1 << bitPosi);
 }
 
-/* GPIOGetValue - Get pin value */
-static uint32_t GPIOGetValue(uint32_t portNum, uint32_t bitPosi)
-{
-  uint32_t val;
-
-  LPC_GPIO[portNum]->FIOMASK = ~(1 << bitPosi);
-  val = LPC_GPIO[portNum]->FIOPIN;
-
-  val = val >> bitPosi;
-  LPC_GPIO[portNum]->FIOMASK = 0x00000000;
-  return val;
-}
-
 /* GPIOGetValue - Set all out pins */
 static void GPIOSetAllOutputPins(uint32_t dir, uint32_t setDir)
 {
@@ -163,172 +581,143 @@ static void GPIOSetAllOutputPins(uint32_t dir, uint32_t setDir)
 }
 
 /*
- * GPIOGetValue - Task - process keypad key press/release upon
- * external interrupt.  Send key value pressed, or 0 for release.
- *
+ * KeypadEventRead - copy the event at *cursor, skipping ahead if the
+ * writer has lapped the reader. The copy is checked after it is taken,
+ * as the interrupt may have reused the slot meanwhile.
  */
-
-void gpioInterfaceTask(void *pvParameters)
+portBASE_TYPE KeypadEventRead(uint32_t *cursor, KEYPAD_EVENT *event)
 {
+  uint32_t head;
+
+  for (;;)
+  {
+    head = keypadEventHead;
+    if (*cursor == head)
+    {
+      return pdFAIL;
+    }
+    if (head - *cursor >= KEYPAD_EVENT_RING)
+    {
+      *cursor = head - KEYPAD_EVENT_RING + 1;
+    }
+    __DMB();
+    *event = keypadEvents[*cursor % KEYPAD_EVENT_RING];
+    __DMB();
+    if (keypadEventHead - *cursor < KEYPAD_EVENT_RING)
+    {
+      (*cursor)++;
+      return pdPASS;
+    }
+  }
+}
 
-  xData xSendStructure;
+/*
+ * KeypadEventHead - cursor of the next event to be written
+ */
+uint32_t KeypadEventHead(void)
+{
+  return keypadEventHead;
+}
 
-  xSendStructure.ucSource = KEYPAD_TASK;
-  xSendStructure.ucValue = 0;
-#if DEBUG_KEYPAD
-  static int intCounter = 0;
+/*
+ * KeypadChordGet - take the chord waiting, if any
+ */
+uint32_t KeypadChordGet(char *symbols)
+{
+#if KEYPAD_POLICY == KEYPAD_POLICY_CHORD
+  uint32_t length = chordReadyLength;
+
+  memcpy(symbols, chordReady, length);
+  chordReadyLength = 0;
+  return length;
+#else
+  return 0;
 #endif
-  portBASE_TYPE xStatus;
+}
 
-  TickType_t xSleepTime = 0;
-  xSleepTime = 100 / portTICK_RATE_MS;
-  TickType_t xDebounceTime = DEBOUNCE_TIME / portTICK_RATE_MS;
+/*
+ * KeypadLatencyReport - time from the last fast press to the DAC start.
+ * The DAC handler runs above the tone generator, so by the time the
+ * generator calls this the transfer has been started and stamped.
+ */
+void KeypadLatencyReport(void)
+{
+#ifdef KEYPAD_LATENCY_STATS
+  uint32_t press = fastPressCycles;
+  uint32_t first = fastFirstCycles;
+  uint32_t start = dacStartCycles;
+  uint32_t us;
+
+  // A DAC start from before the press is not this tone's
+  if (start - press > CycleCounterGet() - press)
+  {
+    return;
+  }
+  us = (start - first) / CYCLES_PER_USEC;
 
-  uint32_t var;
-  uint32_t outputpin, outputpin2, inputpin, inputpin2;
-  char string[256];
-  int buttonXPressedIndex = 0xFF;
-  int buttonYPressedIndex = 0xFF;
+  if (keypadLatency.count == 0 || us < keypadLatency.minUs)
+  {
+    keypadLatency.minUs = us;
+  }
+  if (us > keypadLatency.maxUs)
+  {
+    keypadLatency.maxUs = us;
+  }
+  keypadLatency.sumUs += us;
+  keypadLatency.count++;
 
-  xQueueHandle * xKeypadQueue = (xQueueHandle*) pvParameters;
+  LOG_INFO("Key to DAC us %lu, after debounce %lu\n", us, (start - press) / CYCLES_PER_USEC);
+  LOG_INFO("Key to DAC us min %lu max %lu\n", keypadLatency.minUs, keypadLatency.maxUs);
+#endif
+}
 
-  vSemaphoreCreateBinary(xButtonChangeStateSemaphore);
+/*
+ * KeypadScanInit - set up the pins, TIMER1 and the edge interrupt.
+ * Key presses and releases are sent to *queue from the interrupts.
+ */
+void KeypadScanInit(xQueueHandle *queue)
+{
+  uint32_t inputpin;
 
-  xSemaphoreTake(xButtonChangeStateSemaphore, portMAX_DELAY);
+  keypadQueue = queue;
+#ifdef KEYPAD_LATENCY_STATS
+  CycleCounterInit();
+#endif
 
-  /* Disable the interrupt while we configure input pins. */
+  /* Disable the interrupts while we configure the pins and timer. */
   NVIC_DisableIRQ(EINT3_IRQn);
+  NVIC_DisableIRQ(TIMER1_IRQn);
   GPIOSetAllOutputPins(LOW,TRUE);
 
   for (inputpin = INPUT_PIN_MIN; inputpin <= INPUT_PIN_MAX; inputpin++)
   {
     GPIOSetDir(PORT_NUM_IO, inputpin, INPUT);
-    // Enable P2.X interrupts for input pins rising and falling edge
-    // Also clear interrupts which were set previously
-    LPC_GPIOINT->IO2IntClr |= (1 << inputpin);
-    LPC_GPIOINT->IO2IntEnF |= (1 << inputpin);
-    LPC_GPIOINT->IO2IntEnR &= ~(1 << inputpin);
   }
-
-  /* The interrupt service routine uses an (interrupt safe) FreeRTOS API
+  LPC_GPIOINT->IO2IntEnR &= ~INPUT_PIN_MASK;
+
+  /* TIMER1 at the core clock, interrupt and restart every row period */
+  LPC_SC->PCONP |= (1 << 2);
+  LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 & ~(3 << 4)) | (1 << 4);
+  LPC_TIM1->TCR = 2;
+  LPC_TIM1->CTCR = 0;
+  LPC_TIM1->PR = 0;
+  LPC_TIM1->MR0 = (configCPU_CLOCK_HZ / 1000) * KEYPAD_ROW_MS - 1;
+  LPC_TIM1->MCR = 3;
+  LPC_TIM1->CCR = 0;
+  LPC_TIM1->EMR = 0;
+
+  /* The interrupt service routines use an (interrupt safe) FreeRTOS API
   function so the interrupt priority must be at or below the priority
   defined by configSYSCALL_INTERRUPT_PRIORITY. */
   NVIC_SetPriority(EINT3_IRQn, EINT3_INTERRUPT_PRIORITY);
+  NVIC_SetPriority(TIMER1_IRQn, TIMER1_INTERRUPT_PRIORITY);
+  NVIC_ClearPendingIRQ(EINT3_IRQn);
+  NVIC_ClearPendingIRQ(TIMER1_IRQn);
 
-  /* Enable the interrupt. */
-  NVIC_EnableIRQ(EINT3_IRQn);
+  /* Wait for the first key, or scan if one is already held */
+  KeypadScanIdle();
 
-  while (1)
-  {
-    xSemaphoreTake(xButtonChangeStateSemaphore, portMAX_DELAY);
-    GPIOSetAllOutputPins(HIGH, FALSE);
-#if DEBUG_KEYPAD
-    intCounter++;
-#endif
-    for (outputpin = OUTPUT_PIN_MIN; outputpin <= OUTPUT_PIN_MAX; outputpin++)
-    {
-      GPIOSetValue(PORT_NUM_IO, outputpin, LOW);
-      // Debounce wait to ensure the input pin stays at the same level
-      vTaskDelay(xDebounceTime);
-      for (inputpin = INPUT_PIN_MIN; inputpin <= INPUT_PIN_MAX; inputpin++)
-      {
-        LPC_GPIOINT->IO2IntClr |= (1 << inputpin);
-
-        var = GPIOGetValue(PORT_NUM_IO, inputpin); // read the button value
-
-        if ((var == 0) && (GPIOGetValue(PORT_NUM_IO, inputpin) == 0))
-        // the button is pushed
-        {
-          if ((buttonXPressedIndex == 0xFF) && (buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] == DEPRESSED))
-          {
-            xSendStructure.ucValue = symbolDef[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN];
-
-#if DEBUG_KEYPAD
-            sprintf(string,"Pressed %c @ column %d , row =%d, intCounter= %d \n", symbolDef[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN],(inputpin - INPUT_PIN_MIN), (outputpin - OUTPUT_PIN_MIN), intCounter);
-            vPrintString(string);
-#endif
-            xStatus = xQueueSendToBack(*xKeypadQueue, (char*)&xSendStructure.ucValue, xSleepTime);
-            buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] = PRESSED;
-            buttonXPressedIndex = outputpin - OUTPUT_PIN_MIN;
-            buttonYPressedIndex = inputpin - INPUT_PIN_MIN;
-            // Disable falling edge & enable rising edge
-            // interrupt for this input pin
-            LPC_GPIOINT->IO2IntEnF &= ~(1 << inputpin);
-            LPC_GPIOINT->IO2IntEnR |= (1 << inputpin);
-          }
-        }
-        else if (((outputpin - OUTPUT_PIN_MIN) == buttonXPressedIndex) && ((inputpin - INPUT_PIN_MIN) == buttonYPressedIndex) &&
-                  ((buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] == PRESSED)))
-        {
-          // if another pin is pressed in the same column then drive all
-          // output pins low to ensure that no other button in the same column
-          // is pressed.
-          int suppressedButtons = FALSE;
-          GPIOSetAllOutputPins(LOW, FALSE);
-          vTaskDelay(xDebounceTime);
-          if(GPIOGetValue(PORT_NUM_IO, inputpin) == 1)
-          {
-#if DEBUG_KEYPAD
-            sprintf(string,"Depressed %c @ column %d , row =%d, intCounter= %d\n", symbolDef[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN], (inputpin - INPUT_PIN_MIN), (outputpin - OUTPUT_PIN_MIN), intCounter);
-            vPrintString(string);
-#endif
-            if(buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] == PRESSED)
-            {
-              // Now check if any other pin is pressed
-              GPIOSetAllOutputPins(HIGH, FALSE);
-              for (outputpin2 = OUTPUT_PIN_MIN; outputpin2 <= OUTPUT_PIN_MAX; outputpin2++)
-              {
-                GPIOSetValue(PORT_NUM_IO, outputpin2, LOW);
-                for (inputpin2 = INPUT_PIN_MIN; inputpin2 <= INPUT_PIN_MAX; inputpin2++)
-                {
-                  if (GPIOGetValue(PORT_NUM_IO, inputpin2) == 0)
-                  {
-                    // the button is pushed
-#if DEBUG_KEYPAD
-                    sprintf(string,"Suppress Pressed %c @ column %d , row =%d\n", symbolDef[outputpin2 - OUTPUT_PIN_MIN][inputpin2 - INPUT_PIN_MIN],(inputpin2 - INPUT_PIN_MIN), (outputpin2 - OUTPUT_PIN_MIN));
-                    vPrintString(string);
-#endif
-                    buttonState[outputpin2 - OUTPUT_PIN_MIN][inputpin2 - INPUT_PIN_MIN] = PRESSED_SUPPRESS;
-                    suppressedButtons = TRUE;
-                  }
-                }
-              }
-              // No other button is pressed
-              if(suppressedButtons == FALSE)
-              {
-                buttonXPressedIndex = 0xFF;
-                buttonYPressedIndex = 0xFF;
-                buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] = DEPRESSED;
-                xSendStructure.ucValue = 0;
-                xStatus = xQueueSendToBack(*xKeypadQueue, (char*)&xSendStructure.ucValue, xSleepTime);
-                // Re-enable falling edge disable rising edge interrupt for this pin
-                LPC_GPIOINT->IO2IntEnF |= (1 << inputpin);
-                LPC_GPIOINT->IO2IntEnR &= ~(1 << inputpin);
-              }
-            }
-
-          }
-          GPIOSetAllOutputPins(HIGH, FALSE);
-        }
-        else if (buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] == PRESSED_SUPPRESS)
-        {
-          // button is no longer pressed suppressed
-          buttonState[outputpin - OUTPUT_PIN_MIN][inputpin - INPUT_PIN_MIN] = DEPRESSED;
-        }
-      }
-      GPIOSetValue(PORT_NUM_IO, outputpin, HIGH);
-    }
-
-    GPIOSetAllOutputPins(LOW, FALSE);
-    for (inputpin = INPUT_PIN_MIN; inputpin <= INPUT_PIN_MAX; inputpin++)
-    {
-      // Also clear interrupts which were set previously
-      LPC_GPIOINT->IO2IntClr |= (1 << inputpin);
-    }
-    NVIC_ClearPendingIRQ( EINT3_IRQn);
-    // Reenable IRQ
-    NVIC_EnableIRQ(EINT3_IRQn);
-	taskYIELD();
-  }
+  /* Enable the interrupts. */
+  NVIC_EnableIRQ(EINT3_IRQn);
+  NVIC_EnableIRQ(TIMER1_IRQn);
 }
-
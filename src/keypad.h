@@ -38,10 +38,120 @@ typedef struct
 } xQueueType;
 
 /*
- * GPIOGetValue - Task - process keypad key press/release upon
- * external interrupt.  Send key value pressed, or 0 for release.
+ * Keypad scanning
  *
+ * The 4x4 matrix is scanned by the TIMER1 interrupt, one row every
+ * KEYPAD_ROW_MS, with an integrating debounce counter per key. A key is
+ * reported once it has been seen closed on KEYPAD_DEBOUNCE_SAMPLES scans
+ * more than open, so a press reaches the queue within
+ * KEYPAD_DEBOUNCE_SAMPLES * 4 * KEYPAD_ROW_MS ms (12 ms by default) and no
+ * task runs for it. While every key is up the timer is stopped and a
+ * falling edge on a column (EINT3) starts the scan again.
+ *
+ * Every key is debounced on its own, so any number of keys can be down
+ * at once (n-key rollover). Each press and release is written, with the
+ * tick it was debounced at, to a ring of KEYPAD_EVENT_RING events. The
+ * scan interrupt is the only writer and never waits for a reader; any
+ * number of tasks can follow the ring, each with its own cursor, through
+ * KeypadEventRead(). A reader that falls a whole ring behind skips ahead
+ * to the oldest event still held.
+ *
+ * KEYPAD_POLICY picks which of the events reach tone generation:
+ *
+ * KEYPAD_POLICY_LAST_KEY - the newest key down sounds; when it is released
+ *   the newest key still held sounds again, or the tone stops.
+ * KEYPAD_POLICY_QUEUE - every press sounds in turn, for as long as it was
+ *   held but at least KEYPAD_QUEUE_MIN_MS, with KEYPAD_QUEUE_GAP_MS of
+ *   silence before the next, so overlapping presses are all dialled. The
+ *   timing comes from the event timestamps; the scan keeps running until
+ *   the backlog has played.
+ * KEYPAD_POLICY_CHORD - a key pressed alone sounds as usual. Keys held
+ *   together stop it and are collected; once all are up the IO receiver
+ *   is sent KEYPAD_CHORD_SYMBOL and dials them, in press order, from
+ *   KeypadChordGet().
+ *
+ * A key sounds by sending its symbol to the queue, or 0 to stop it, as
+ * the IO receiver expects. Sends that do not fit in the queue, and
+ * presses or chords the policy had to drop, are counted in keypadDropped.
+ */
+#define KEYPAD_ROW_MS 1                //CONFIGURABLE - Time each row is driven before it is sampled
+#define KEYPAD_DEBOUNCE_SAMPLES 3      //CONFIGURABLE - Scans a key must hold a new level for
+#define KEYPAD_EVENT_RING 32           //CONFIGURABLE - Key events kept, a power of 2
+
+#define KEYPAD_POLICY_LAST_KEY 0
+#define KEYPAD_POLICY_QUEUE 1
+#define KEYPAD_POLICY_CHORD 2
+#define KEYPAD_POLICY KEYPAD_POLICY_QUEUE   //CONFIGURABLE - What overlapping presses do
+#define KEYPAD_QUEUE_MIN_MS 60         //CONFIGURABLE - Shortest tone of a queued press
+#define KEYPAD_QUEUE_GAP_MS 40         //CONFIGURABLE - Silence between queued presses
+#define KEYPAD_CHORD_SYMBOL '\x01'     // Sent to the IO receiver when a chord is ready
+
+#define KEYPAD_KEYS 16
+
+typedef struct
+{
+  uint32_t tick;           // tick count the new level was debounced at
+  uint8_t key;             // row * 4 + column
+  char symbol;
+  uint8_t down;            // TRUE for a press
+} KEYPAD_EVENT;
+
+/*
+ * Fast tone path
+ *
+ * With KEYPAD_FAST_TONE (and TONEGEN_USE_TONE_TABLES) a digit key starts
+ * its tone from the scan interrupt: its precomputed table is queued to
+ * the DAC handler directly, and the key is passed to the tone generator
+ * marked TONE_REQ_STARTED so the task only ends any prompt and keeps its
+ * state. Its release stops the tone the same way. No task sits between
+ * the debounce and the DMA start. The other keys, the speed dials among
+ * them, still go to the IO receiver. A digit whose request cannot be
+ * queued from the interrupt falls back to the IO receiver too.
+ *
+ * With KEYPAD_LATENCY_STATS (main.h) the cycle counter is stamped at the
+ * first closed sample of a key and at its debounced press, and for every
+ * fast tone the time from each to the DAC start (dacStartCycles) is
+ * logged, with the running minimum and maximum.
+ */
+#define KEYPAD_FAST_TONE               //CONFIGURABLE - Digits start their tone from the scan interrupt
+
+typedef struct
+{
+  uint32_t count;          // fast tones measured
+  uint32_t minUs;          // press to DAC start
+  uint32_t maxUs;
+  uint32_t sumUs;
+} KEYPAD_LATENCY;
+
+extern volatile uint32_t keypadDropped;
+extern KEYPAD_LATENCY keypadLatency;
+
+/*
+ * KeypadScanInit - configure the keypad and start watching it.
+ * Send key value pressed, or 0 for release, to *queue.
+ *
+ */
+void KeypadScanInit(xQueueHandle *queue);
+
+/*
+ * KeypadEventRead - copy the event at *cursor and advance it.
+ * Returns pdFAIL when the reader is up to date. A cursor of 0 starts at
+ * the oldest event held, KeypadEventHead() at the next one to come.
+ */
+portBASE_TYPE KeypadEventRead(uint32_t *cursor, KEYPAD_EVENT *event);
+uint32_t KeypadEventHead(void);
+
+/*
+ * KeypadChordGet - copy the symbols of the last chord, in press order, to
+ * symbols (KEYPAD_KEYS at most) and free it for the next. Returns the
+ * count, 0 if there is none.
+ */
+uint32_t KeypadChordGet(char *symbols);
+
+/*
+ * KeypadLatencyReport - log the latency of the last fast tone, called by
+ * the tone generator once the DAC handler has started it.
  */
-void gpioInterfaceTask(void *pvParameters);
+void KeypadLatencyReport(void);
 
 #endif /* KEYPAD_H_ */
@@ -0,0 +1,102 @@
+#include "log.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "LPC17xx.h"
+#include "consoleprint.h"
+#include <stdio.h>
+
+#if LOG_RING_SIZE & (LOG_RING_SIZE - 1)
+#error LOG_RING_SIZE must be a power of two
+#endif
+
+/*
+ * A record is claimed by moving logHead with LDREX/STREX, then filled in
+ * and committed by writing its sequence word last (the claim count plus
+ * one). The log task only prints a record once its sequence matches, so a
+ * writer that was interrupted half way holds up the printing, never the
+ * other writers.
+ */
+typedef struct
+{
+  const char *fmt;
+  uint32_t time;
+  uint32_t arg[LOG_MAX_ARGS];
+  volatile uint32_t seq;
+} LOG_RECORD;
+
+static LOG_RECORD logRing[LOG_RING_SIZE];
+static volatile uint32_t logHead = 0;    // claimed by writers
+static volatile uint32_t logTail = 0;    // printed by the log task
+static char logLine[LOG_LINE_LENGTH];
+
+volatile uint32_t logDropped = 0;
+
+//=============================================================================
+// LogWrite() - queue one record, from a task or an interrupt
+//=============================================================================
+void LogWrite(const char *fmt, uint32_t arg0, uint32_t arg1)
+{
+  LOG_RECORD *rec;
+  uint32_t head;
+  uint32_t dropped;
+
+  do
+  {
+    head = __LDREXW((uint32_t *)&logHead);
+    if(head - logTail >= LOG_RING_SIZE)
+    {
+      __CLREX();
+      // Interrupts drop records too, so count with an exclusive access
+      do
+      {
+        dropped = __LDREXW((uint32_t *)&logDropped) + 1;
+      } while(__STREXW(dropped, (uint32_t *)&logDropped));
+      return;
+    }
+  } while(__STREXW(head + 1, (uint32_t *)&logHead));
+
+  rec = &logRing[head & (LOG_RING_SIZE - 1)];
+  rec->fmt = fmt;
+  rec->time = xTaskGetTickCountFromISR();
+  rec->arg[0] = arg0;
+  rec->arg[1] = arg1;
+  __DMB();
+  rec->seq = head + 1;
+}
+
+//=============================================================================
+// vLogTask() - print the records as they are committed
+//=============================================================================
+void vLogTask( void *pvParameters )
+{
+  LOG_RECORD *rec;
+  uint32_t dropped = 0;
+  int len;
+
+  for( ;; )
+  {
+    while(logTail != logHead)
+    {
+      rec = &logRing[logTail & (LOG_RING_SIZE - 1)];
+      if(rec->seq != logTail + 1)
+      {
+        // Claimed but not written yet
+        break;
+      }
+
+      len = snprintf(logLine, sizeof(logLine), "%6lu ", rec->time * portTICK_RATE_MS);
+      snprintf(logLine + len, sizeof(logLine) - len, rec->fmt, rec->arg[0], rec->arg[1]);
+      logTail++;
+      consoleprint(logLine);
+    }
+
+    if(logDropped != dropped)
+    {
+      dropped = logDropped;
+      snprintf(logLine, sizeof(logLine), "Log dropped %lu\n", dropped);
+      consoleprint(logLine);
+    }
+
+    vTaskDelay(LOG_POLL_MS / portTICK_RATE_MS);
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef LOG_H
+#define LOG_H
+
+/*
+ * log.h
+ * Deferred logging
+ *
+ * A call site such as
+ *
+ *   LOG_ERROR("Unable to free buffer %lu\n", index);
+ *
+ * does not format anything. It stores the format string's address, the
+ * tick count and up to LOG_MAX_ARGS 32 bit arguments as one record in a
+ * lock free ring, which takes a few dozen cycles, never blocks, does not
+ * touch the scheduler and is safe from interrupts. vLogTask() runs at the
+ * lowest priority, formats the records and prints them to the semihosting
+ * console, so the cost of sprintf and of the debugger link is paid only
+ * when nothing else wants the CPU.
+ *
+ * Arguments are passed as uint32_t, so formats take %lu, %lx, %ld or %c.
+ * A %s argument must be a string that lives for ever, such as a literal.
+ *
+ * Sites above LOG_LEVEL compile to nothing, arguments included. When the
+ * ring is full a record is dropped and counted in logDropped.
+ *
+ * Resources used:
+ * LOG_RING_SIZE * 20 bytes of RAM
+ * One task, vLogTask()
+ */
+
+#include <stdint.h>
+
+#define LOG_LEVEL_NONE   0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+#define LOG_LEVEL        LOG_LEVEL_INFO  //CONFIGURABLE - Most verbose level built in
+#define LOG_RING_SIZE    64              //CONFIGURABLE - Records waiting to be printed, a power of two
+#define LOG_LINE_LENGTH  80              // Longest printed line
+#define LOG_POLL_MS      20              // How often the log task looks for records
+#define LOG_MAX_ARGS     2
+
+/* Pads the argument list out to LOG_MAX_ARGS */
+#define LOG_ARGS_(fmt, a, b, ...)  (fmt), (uint32_t)(a), (uint32_t)(b)
+#define LOG_RECORD_(...)           LogWrite(LOG_ARGS_(__VA_ARGS__, 0, 0))
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...)   LOG_RECORD_(__VA_ARGS__)
+#else
+#define LOG_ERROR(...)   do { } while(0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...)    LOG_RECORD_(__VA_ARGS__)
+#else
+#define LOG_WARN(...)    do { } while(0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...)    LOG_RECORD_(__VA_ARGS__)
+#else
+#define LOG_INFO(...)    do { } while(0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...)   LOG_RECORD_(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...)   do { } while(0)
+#endif
+
+extern volatile uint32_t logDropped;
+
+void LogWrite(const char *fmt, uint32_t arg0, uint32_t arg1);
+
+/* Log Task, formats and prints the records */
+void vLogTask( void *pvParameters );
+
+#endif
@@ -0,0 +1,155 @@
+#include "loopback.h"
+#include "dac.h"
+#include "dtmf_data.h"
+#include "cyclecount.h"
+#include "uart.h"
+
+#ifdef LOOPBACK_BENCHMARK
+
+static const char loopbackDigits[] = "123A456B789C*0#D";
+#define LOOPBACK_NUM_DIGITS  (sizeof(loopbackDigits) - 1)
+
+static LOOPBACK_DIGIT_STATS loopbackStats[LOOPBACK_NUM_DIGITS];
+static uint32_t loopbackHistogram[LOOPBACK_BINS + 1];
+static char loopbackLine[UART_SEND_LENGTH];
+
+//=============================================================================
+// LoopbackPress() - press one key, returns the latency in us, 0 if missed
+//=============================================================================
+static uint32_t LoopbackPress(QueueHandle_t resultQ, char digit, LOOPBACK_DIGIT_STATS *stats)
+{
+  struct DTMFResult_t result;
+  TickType_t start = xTaskGetTickCount();
+  TickType_t timeout = LOOPBACK_TIMEOUT_MS / portTICK_RATE_MS;
+  TickType_t elapsed;
+  uint32_t sent;
+  uint32_t latencyUs = 0;
+  char key;
+
+  // Forget frames from before the press
+  xQueueReset(resultQ);
+  sent = CycleCounterGet();
+
+  key = digit;
+  xQueueSendToBack(xQueueToneInput, &key, portMAX_DELAY);
+
+  while((elapsed = xTaskGetTickCount() - start) < timeout)
+  {
+    if(xQueueReceive(resultQ, &result, timeout - elapsed) != pdPASS)
+    {
+      break;
+    }
+
+    // Only frames decoded after this tone's DMA started count
+    if(dacStartCycles - sent > result.cycles - sent)
+    {
+      continue;
+    }
+    if(result.code == digit)
+    {
+      latencyUs = (result.cycles - dacStartCycles) / CYCLES_PER_USEC;
+      break;
+    }
+    if(result.code != ' ')
+    {
+      stats->wrong++;
+    }
+  }
+
+  key = 0;
+  xQueueSendToBack(xQueueToneInput, &key, portMAX_DELAY);
+  return latencyUs;
+}
+
+//=============================================================================
+// LoopbackReport() - print the per digit table and the histogram
+//=============================================================================
+static void LoopbackReport(void)
+{
+  LOOPBACK_DIGIT_STATS *st;
+  uint32_t i;
+  int len;
+
+  len = snprintf(loopbackLine, sizeof(loopbackLine), "Loopback key hit/miss/wrong min/avg/max us\r\n");
+  uart_send_block(loopbackLine, len);
+  for(i = 0; i < LOOPBACK_NUM_DIGITS; i++)
+  {
+    st = &loopbackStats[i];
+    len = snprintf(loopbackLine, sizeof(loopbackLine), "%c %lu/%lu/%lu %lu/%lu/%lu\r\n",
+                   loopbackDigits[i], st->hits, st->misses, st->wrong,
+                   st->hits ? st->minUs : 0, st->hits ? st->sumUs / st->hits : 0, st->maxUs);
+    uart_send_block(loopbackLine, len);
+  }
+
+  for(i = 0; i <= LOOPBACK_BINS; i++)
+  {
+    if(i < LOOPBACK_BINS)
+    {
+      len = snprintf(loopbackLine, sizeof(loopbackLine), "%3lu-%3lu ms %lu\r\n",
+                     i * LOOPBACK_BIN_MS, (i + 1) * LOOPBACK_BIN_MS, loopbackHistogram[i]);
+    }
+    else
+    {
+      len = snprintf(loopbackLine, sizeof(loopbackLine), "%3lu+    ms %lu\r\n",
+                     i * LOOPBACK_BIN_MS, loopbackHistogram[i]);
+    }
+    uart_send_block(loopbackLine, len);
+  }
+}
+
+//=============================================================================
+// vLoopbackBenchTask() - press every key LOOPBACK_ROUNDS times and report
+//=============================================================================
+void vLoopbackBenchTask( void *pvParameters )
+{
+  QueueHandle_t resultQ = (QueueHandle_t)pvParameters;
+  LOOPBACK_DIGIT_STATS *st;
+  uint32_t latencyUs;
+  uint32_t bin;
+  uint32_t round;
+  uint32_t i;
+
+  CycleCounterInit();
+  CycleCounterReset();
+
+  for( ;; )
+  {
+    memset(loopbackStats, 0, sizeof(loopbackStats));
+    memset(loopbackHistogram, 0, sizeof(loopbackHistogram));
+
+    for(round = 0; round < LOOPBACK_ROUNDS; round++)
+    {
+      for(i = 0; i < LOOPBACK_NUM_DIGITS; i++)
+      {
+        st = &loopbackStats[i];
+        latencyUs = LoopbackPress(resultQ, loopbackDigits[i], st);
+
+        if(latencyUs == 0)
+        {
+          st->misses++;
+        }
+        else
+        {
+          if(st->hits == 0 || latencyUs < st->minUs)
+          {
+            st->minUs = latencyUs;
+          }
+          if(latencyUs > st->maxUs)
+          {
+            st->maxUs = latencyUs;
+          }
+          st->sumUs += latencyUs;
+          st->hits++;
+
+          bin = latencyUs / (LOOPBACK_BIN_MS * 1000);
+          loopbackHistogram[(bin < LOOPBACK_BINS) ? bin : LOOPBACK_BINS]++;
+        }
+
+        vTaskDelay(LOOPBACK_GAP_MS / portTICK_RATE_MS);
+      }
+    }
+
+    LoopbackReport();
+  }
+}
+#endif
@@ -0,0 +1,48 @@
+#ifndef LOOPBACK_H
+#define LOOPBACK_H
+
+/*
+ * loopback.h
+ * Closed loop DAC to ADC self test and latency benchmark
+ *
+ * With LOOPBACK_BENCHMARK (main.h) a task presses every DTMF key in turn
+ * through the real path (xQueueToneInput -> tone generator -> DAC_Handler ->
+ * GPDMA -> DAC), with the DAC output wired back to the ADC input, and waits
+ * for the detector to report it. For each press it records whether the right
+ * digit was detected within LOOPBACK_TIMEOUT_MS, any wrong digits seen, and
+ * the latency from the DMA start (dacStartCycles) to the decoded frame
+ * (DTMFResult_t.cycles). After LOOPBACK_ROUNDS rounds a per digit table and
+ * a latency histogram are printed over the UART.
+ *
+ * LOOPBACK_DIGITAL replaces the analog path with stand-ins: the ADC task
+ * samples the DAC register instead of the pin, so the harness and the
+ * detector can be run on a bare board with nothing wired.
+ *
+ * tools/loopback_host runs the same tone tables and detector on the host,
+ * with the DAC and ADC simulated in the LOOPBACK_DIGITAL format.
+ *
+ * The benchmark owns the cycle counter: it restarts it when it starts.
+ */
+
+#include "main.h"
+
+#define LOOPBACK_ROUNDS       4       //CONFIGURABLE - Presses of each key per report
+#define LOOPBACK_TIMEOUT_MS   500     //CONFIGURABLE - Time allowed for a detection
+#define LOOPBACK_GAP_MS       150     //CONFIGURABLE - Silence between presses
+#define LOOPBACK_BIN_MS       8       //CONFIGURABLE - Width of a histogram bin
+#define LOOPBACK_BINS         16      // Histogram bins, plus one for anything later
+
+typedef struct
+{
+  uint32_t hits;           // presses detected as the right digit
+  uint32_t misses;         // presses not detected in time
+  uint32_t wrong;          // frames decoded as another digit during a press
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t sumUs;
+} LOOPBACK_DIGIT_STATS;
+
+/* Benchmark Task, parameter is the detector's result queue */
+void vLoopbackBenchTask( void *pvParameters );
+
+#endif
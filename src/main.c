@@ -13,6 +13,9 @@
 //#include "dma.h"
 #include "dac.h"
 #include "tonegen.h"
+#include "callprogress.h"
+#include "prompt.h"
+#include "loopback.h"
 #include "testbench_task.h"
 #include "dtmf_detect_task.h"
 #include "dtmf_data.h"
@@ -39,9 +42,62 @@ xQueueHandle xQueueToneInput;
 xQueueHandle xQueueDMARequest;
 xQueueHandle dacResponseHandle;
 xQueueHandle xIoQueue;
+xQueueHandle xUartCmdQueue;
+QueueSetHandle_t xToneEventSet;
+QueueSetHandle_t xIoEventSet;
 
 void vProcessTask( void *pvParameters );
 
+/*-----------------------------------------------------------*/
+/* Static storage of every task, queue and queue set (configSUPPORT_STATIC_ALLOCATION),
+so the RAM they take is fixed at link time and nothing is allocated at boot */
+
+#define STATIC_TASK( name, depth )		static StackType_t name##Stack[ depth ]; static StaticTask_t name##Task
+#define STATIC_TASK_ARGS( name )		( sizeof( name##Stack ) / sizeof( StackType_t ) )
+#define STATIC_QUEUE( name, length, size )	static uint8_t name##Storage[ ( length ) * ( size ) ]; static StaticQueue_t name##Queue
+
+STATIC_QUEUE( xQueueToneInput, DTMF_REQ_QUEUE_SIZE, sizeof( char ) );
+STATIC_QUEUE( xQueueDMARequest, DMA_REQ_QUEUE_SIZE, sizeof( DAC_Setup_Message ) );
+STATIC_QUEUE( xIoQueue, IO_BUFFER_SIZE, sizeof( char ) );
+STATIC_QUEUE( xUartCmdQueue, UART_CMD_BUFFERS, MSG_QUEUE_ITEM_SIZE );
+STATIC_QUEUE( dacResponseHandle, DMA_COMP_QUEUE_SIZE, sizeof( DAC_Complete_Message ) );
+STATIC_QUEUE( sampQ, 1, sizeof( DTMFSampleType * ) );
+STATIC_QUEUE( resultQ, 1, sizeof( struct DTMFResult_t ) );
+STATIC_QUEUE( xIoInputQueue, 2, sizeof( xData ) );
+STATIC_QUEUE( xToneEventSet, TONE_EVENT_SET_SIZE, sizeof( void * ) );
+STATIC_QUEUE( xIoEventSet, IO_EVENT_SET_SIZE, sizeof( void * ) );
+
+STATIC_TASK( xIdle, configMINIMAL_STACK_SIZE );
+STATIC_TASK( xToneGenerator, 240 );
+#ifdef TONEGEN_INPUT_UNIT_TEST
+STATIC_TASK( xToneRequestTest, 240 );
+#endif
+#ifdef TONEGEN_BENCHMARK
+STATIC_TASK( xToneBench, 240 );
+#endif
+#ifdef CALLPROGRESS_UNIT_TEST
+STATIC_TASK( xCallProgressTest, 240 );
+#endif
+#ifdef PROMPT_UNIT_TEST
+STATIC_TASK( xPromptTest, 240 );
+#endif
+#ifdef TONEGEN_DMA_UNIT_TEST
+STATIC_TASK( xDMAHandlerTest, 240 );
+#else
+STATIC_TASK( xDAC, 240 );
+#endif
+STATIC_TASK( xAdc, 240 );
+#ifdef __DTMF_PERF__
+STATIC_TASK( xTestBench, 500 );
+#endif
+#ifdef LOOPBACK_BENCHMARK
+STATIC_TASK( xLoopback, 240 );
+#endif
+STATIC_TASK( xDetect, 500 );
+STATIC_TASK( xUartRx, 500 );
+STATIC_TASK( xLog, 300 );
+STATIC_TASK( xIoRx, 240 );
+
 int main( void )
 {
 	// Init the semi-hosting.
@@ -51,101 +107,150 @@ int main( void )
 	NVIC_DisableIRQ( DMA_IRQn);
 	InitializeDAC();
 	InitializeDMA();
+	PromptPlayerInit();
 
 	/* Instantiate queue and semaphores */
-	xQueueToneInput = xQueueCreate( DTMF_REQ_QUEUE_SIZE, sizeof( char ) );
-	xQueueDMARequest = xQueueCreate( DMA_REQ_QUEUE_SIZE, sizeof( DAC_Setup_Message ));
-	xIoQueue = xQueueCreate(16,sizeof(char));
-	dacResponseHandle = xQueueCreate( DMA_COMP_QUEUE_SIZE, sizeof( DAC_Complete_Message ) );
-	sampQ = xQueueCreate( 1, sizeof(DTMFSampleType *) );
-	resultQ = xQueueCreate( 1, sizeof(struct DTMFResult_t) );
-	lQueues.xIoInputQueue = xQueueCreate( 2, sizeof(xData) );
+	xQueueToneInput = xQueueCreateStatic( DTMF_REQ_QUEUE_SIZE, sizeof( char ), xQueueToneInputStorage, &xQueueToneInputQueue );
+	xQueueDMARequest = xQueueCreateStatic( DMA_REQ_QUEUE_SIZE, sizeof( DAC_Setup_Message ), xQueueDMARequestStorage, &xQueueDMARequestQueue );
+	xIoQueue = xQueueCreateStatic( IO_BUFFER_SIZE, sizeof( char ), xIoQueueStorage, &xIoQueueQueue );
+	xUartCmdQueue = xQueueCreateStatic( UART_CMD_BUFFERS, MSG_QUEUE_ITEM_SIZE, xUartCmdQueueStorage, &xUartCmdQueueQueue );
+	dacResponseHandle = xQueueCreateStatic( DMA_COMP_QUEUE_SIZE, sizeof( DAC_Complete_Message ), dacResponseHandleStorage, &dacResponseHandleQueue );
+	sampQ = xQueueCreateStatic( 1, sizeof( DTMFSampleType * ), sampQStorage, &sampQQueue );
+	resultQ = xQueueCreateStatic( 1, sizeof( struct DTMFResult_t ), resultQStorage, &resultQQueue );
+	lQueues.xIoInputQueue = xQueueCreateStatic( 2, sizeof( xData ), xIoInputQueueStorage, &xIoInputQueueQueue );
 	lQueues.xDACQueue =     xQueueToneInput;
 
+	/* The tone generator waits on key requests and DAC completions together */
+	xToneEventSet = xQueueCreateSetStatic( TONE_EVENT_SET_SIZE, xToneEventSetStorage, &xToneEventSetQueue );
+	if( xToneEventSet != NULL && xQueueToneInput != NULL && dacResponseHandle != NULL ) {
+		xQueueAddToSet( xQueueToneInput, xToneEventSet );
+		xQueueAddToSet( dacResponseHandle, xToneEventSet );
+	}
+
+	/* The IO receiver waits on keys and UART command lines together */
+	xIoEventSet = xQueueCreateSetStatic( IO_EVENT_SET_SIZE, xIoEventSetStorage, &xIoEventSetQueue );
+	if( xIoEventSet != NULL && xIoQueue != NULL && xUartCmdQueue != NULL ) {
+		xQueueAddToSet( xIoQueue, xIoEventSet );
+		xQueueAddToSet( xUartCmdQueue, xIoEventSet );
+	}
+
 
 	if( sampQ != NULL &&
 		resultQ != NULL &&
 		xQueueToneInput != NULL &&
 		xQueueDMARequest != NULL &&
 		dacResponseHandle != NULL &&
+		xToneEventSet != NULL &&
+		xIoEventSet != NULL &&
 		lQueues.xIoInputQueue != NULL &&
 		lQueues.xDACQueue != NULL) {
 
-	  xTaskCreate(  vTaskToneGenerator, /* Pointer to the function that implements the task. */
+	  xTaskCreateStatic(  vTaskToneGenerator, /* Pointer to the function that implements the task. */
 					  "ToneGenerator",          /* Text name for the task.  This is to facilitate debugging only. */
-					  240,                      /* Stack depth in words. */
+					  STATIC_TASK_ARGS( xToneGenerator ), /* Stack depth in words. */
 					  NULL,                     /* No input data */
 					  configMAX_PRIORITIES-2,                        /* This task will run at priority 1. */
-					  NULL );                   /* We are not using the task handle. */
+					  xToneGeneratorStack, &xToneGeneratorTask ); /* Stack and TCB. */
 
 	  #ifdef TONEGEN_INPUT_UNIT_TEST
-	    xTaskCreate( vTaskToneRequestTest, "ToneRequestTest", 240, NULL, configMAX_PRIORITIES-2/*4*/, NULL );
+	    xTaskCreateStatic( vTaskToneRequestTest, "ToneRequestTest", STATIC_TASK_ARGS( xToneRequestTest ), NULL, configMAX_PRIORITIES-2/*4*/, xToneRequestTestStack, &xToneRequestTestTask );
+	  #endif
+
+	  #ifdef TONEGEN_BENCHMARK
+	    xTaskCreateStatic( vTaskToneGenBenchmark, "ToneBench", STATIC_TASK_ARGS( xToneBench ), NULL, 1, xToneBenchStack, &xToneBenchTask );
+	  #endif
+
+	  #ifdef CALLPROGRESS_UNIT_TEST
+	    xTaskCreateStatic( vTaskCallProgressTest, "CPTest", STATIC_TASK_ARGS( xCallProgressTest ), NULL, 1, xCallProgressTestStack, &xCallProgressTestTask );
+	  #endif
+
+	  #ifdef PROMPT_UNIT_TEST
+	    xTaskCreateStatic( vTaskPromptTest, "PromptTest", STATIC_TASK_ARGS( xPromptTest ), NULL, 1, xPromptTestStack, &xPromptTestTask );
 	  #endif
 
 	  #ifdef  TONEGEN_DMA_UNIT_TEST
-	    xTaskCreate( vTaskDMAHandlerTest, "DMAHandlerTest", 240, NULL, 2, NULL );
+	    xTaskCreateStatic( vTaskDMAHandlerTest, "DMAHandlerTest", STATIC_TASK_ARGS( xDMAHandlerTest ), NULL, 2, xDMAHandlerTestStack, &xDMAHandlerTestTask );
 	  #else
 	    //============================================================================
 	    // Create DAC and DMA Tasks
 	    //============================================================================
-	    xTaskCreate(  DAC_Handler,/* Pointer to the function that implements the task. */
+	    xTaskCreateStatic(  DAC_Handler,/* Pointer to the function that implements the task. */
 						"DAC",            /* Text name for the task.  This is to facilitate debugging only. */
-						240,              /* Stack depth in words. */
+						STATIC_TASK_ARGS( xDAC ), /* Stack depth in words. */
 						(void*)xQueueDMARequest, /* Pass the text to be printed in as the task parameter. */
 						configMAX_PRIORITIES-1,           /* This task will run at highest priority. */
-						NULL );           /* We are not using the task handle. */
+						xDACStack, &xDACTask ); /* Stack and TCB. */
 
 	    #endif
 
-		xTaskCreate(	vAdcTask,
+		xTaskCreateStatic(	vAdcTask,
 						"tADC",
-						240,
+						STATIC_TASK_ARGS( xAdc ),
 						(void *)sampQ,
 						2,
-						NULL );
+						xAdcStack, &xAdcTask );
 
 #ifdef __DTMF_PERF__
 		TestBenchTaskParam.sampQ = sampQ;
 		TestBenchTaskParam.resultQ = resultQ;
-		xTaskCreate(	vTestBenchTask,
+		xTaskCreateStatic(	vTestBenchTask,
 						"tTB",
-						500,
+						STATIC_TASK_ARGS( xTestBench ),
 						(void *)&TestBenchTaskParam,
 						3,
-						NULL );
+						xTestBenchStack, &xTestBenchTask );
+#endif
+
+#ifdef LOOPBACK_BENCHMARK
+		xTaskCreateStatic(	vLoopbackBenchTask,
+						"tLoop",
+						STATIC_TASK_ARGS( xLoopback ),
+						(void *)resultQ,
+						configMAX_PRIORITIES-3,
+						xLoopbackStack, &xLoopbackTask );
 #endif
 
 		DTMFDetectTaskParam.sampQ = sampQ;
 		DTMFDetectTaskParam.resultQ = resultQ;
-		xTaskCreate(	vDTMFDetectTask,
+		xTaskCreateStatic(	vDTMFDetectTask,
 						"tDetect",
-						500,
+						STATIC_TASK_ARGS( xDetect ),
 						(void *)&DTMFDetectTaskParam,
 						configMAX_PRIORITIES-3,
-						NULL );
+						xDetectStack, &xDetectTask );
 
-		xTaskCreate( uart_tx_handler, "Tx Task", 500, NULL, 2, NULL );
-		xTaskCreate( uart_rx_handler, "Rx Task", 500, NULL, 2, NULL );
+		xTaskCreateStatic( uart_rx_handler, "Rx Task", STATIC_TASK_ARGS( xUartRx ), NULL, 2, xUartRxStack, &xUartRxTask );
 		uart_configure();
 
 
 
-		/* Create four instances of the task that will write to the queue */
-		xTaskCreate( gpioInterfaceTask, "Keypad_Task", 240, &xIoQueue, configMAX_PRIORITIES-1, NULL);
-		xTaskCreate( vIoRxTask, "IO_Receiver", 240, NULL, configMAX_PRIORITIES-1, NULL );
+		/* Deferred log output, whenever nothing else is running */
+		xTaskCreateStatic( vLogTask, "Log", STATIC_TASK_ARGS( xLog ), NULL, tskIDLE_PRIORITY + 1, xLogStack, &xLogTask );
+
+		/* The keypad interrupts and the IO receiver that takes their keys */
+		KeypadScanInit( &xIoQueue );
+		xTaskCreateStatic( vIoRxTask, "IO_Receiver", STATIC_TASK_ARGS( xIoRx ), NULL, configMAX_PRIORITIES-1, xIoRxStack, &xIoRxTask );
 
 		/* Start the scheduler so our tasks start executing. */
 		vTaskStartScheduler();
 	}
 
 	/* If all is well we will never reach here as the scheduler will now be
-	running.  If we do reach here then it is likely that there was insufficient
-	heap available for the idle task to be created. */
+	running. */
 	for( ;; );
 	return 0;
 }
 /*-----------------------------------------------------------*/
 
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize )
+{
+	/* The idle task the scheduler creates, statically like the rest */
+	*ppxIdleTaskTCBBuffer = &xIdleTask;
+	*ppxIdleTaskStackBuffer = xIdleStack;
+	*pulIdleTaskStackSize = STATIC_TASK_ARGS( xIdle );
+}
+/*-----------------------------------------------------------*/
+
 void vApplicationMallocFailedHook( void )
 {
 	/* This function will only be called if an API call to create a task, queue
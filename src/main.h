@@ -5,16 +5,30 @@
 #include "task.h"
 #include "queue.h"
 #include "basic_io.h"
+#include "log.h"
 #include <stdint.h>
 
 
 /* Debug Tasks */
 //#define TONEGEN_INPUT_UNIT_TEST    //CONFIGURABLE - Build in Tone Input Unit Test Tasks
 //#define TONEGEN_DMA_UNIT_TEST      //CONFIGURABLE - Build in Tone DMA Unit Test Tasks
+//#define TONEGEN_BENCHMARK          //CONFIGURABLE - Build in Tone Generator Benchmark Task
+//#define CALLPROGRESS_UNIT_TEST     //CONFIGURABLE - Build in Call Progress Tone Cycling Task
+//#define PROMPT_UNIT_TEST           //CONFIGURABLE - Build in Prompt Replay Task
+//#define LOOPBACK_BENCHMARK         //CONFIGURABLE - Build in DAC to ADC Loopback Benchmark Task (loopback.h)
+//#define LOOPBACK_DIGITAL           //CONFIGURABLE - ADC samples the DAC register instead of the pin
+
+/* Detection */
+//#define DTMF_ECHO_CANCEL           //CONFIGURABLE - Cancel our own DAC output from the ADC input (echo_cancel.h)
+//#define DTMF_BINARY_EVENTS         //CONFIGURABLE - Report detections as binary frames, not text (event_proto.h)
 
 /* Debug Prints */
 //#define DEBUG_TONE_SCHED           //CONFIGURABLE - Turn on Tone Scheduler Debug Prints
 //#define DEBUG_TONE_SAMPLE            //CONFIGURABLE - Turn on print of first Tone Sample
+//#define TONEGEN_CPU_STATS          //CONFIGURABLE - Report Tone Generator cycles per tone
+//#define KEYPAD_LATENCY_STATS       //CONFIGURABLE - Report keypress to DAC start latency (keypad.h)
+//#define ADC_WAKEUP_STATS           //CONFIGURABLE - Report TIMER3 to ADC task wakeup cycles (adc_task.h)
+//#define ADC_WAKE_SEMAPHORE         //CONFIGURABLE - Wake the ADC task with a semaphore, to compare against notifications
 
 /* Queue Into ToneGenerator Task */
 extern xQueueHandle xQueueToneInput;
@@ -23,5 +37,8 @@ extern xQueueHandle xQueueToneInput;
 extern xQueueHandle xQueueDMARequest;
 extern xQueueHandle dacResponseHandle;
 
+/* Queue Set the ToneGenerator Task blocks on (tone input + DAC responses) */
+extern QueueSetHandle_t xToneEventSet;
+
 #endif
 
@@ -0,0 +1,153 @@
+#include "msgpool.h"
+#include "task.h"
+#include "LPC17xx.h"
+
+//=============================================================================
+// MsgCountAdd() - add to a counter shared with interrupts, returns the result
+//=============================================================================
+static uint32_t MsgCountAdd(volatile uint32_t *count, int32_t delta)
+{
+  uint32_t value;
+
+  do
+  {
+    value = __LDREXW((uint32_t *)count) + delta;
+  } while(__STREXW(value, (uint32_t *)count));
+
+  return value;
+}
+
+//=============================================================================
+// MsgPoolInit() - link every block into the free list
+//=============================================================================
+void MsgPoolInit(MSG_POOL *pool)
+{
+  MSG_HEADER *hdr;
+  uint32_t i;
+
+  pool->freeList = NULL;
+  for(i = pool->numBlocks; i > 0; i--)
+  {
+    hdr = (MSG_HEADER *)(pool->blocks + (i - 1) * pool->blockSize);
+    hdr->pool = pool;
+    hdr->state = MSG_STATE_FREE;
+    hdr->next = pool->freeList;
+    pool->freeList = hdr;
+  }
+  pool->freeCount = pool->numBlocks;
+  pool->minFree = pool->numBlocks;
+  pool->exhausted = 0;
+}
+
+//=============================================================================
+// MsgAlloc() - take a block from the pool, NULL if it is empty
+//=============================================================================
+void *MsgAlloc(MSG_POOL *pool)
+{
+  MSG_HEADER *hdr;
+  uint32_t left;
+
+  do
+  {
+    hdr = (MSG_HEADER *)__LDREXW((uint32_t *)&pool->freeList);
+    if(hdr == NULL)
+    {
+      __CLREX();
+      MsgCountAdd(&pool->exhausted, 1);
+      return NULL;
+    }
+  } while(__STREXW((uint32_t)hdr->next, (uint32_t *)&pool->freeList));
+
+  configASSERT(hdr->state == MSG_STATE_FREE);
+  hdr->state = MSG_STATE_OWNED;
+
+  // A lower minimum may be lost to a race, the count itself is exact
+  left = MsgCountAdd(&pool->freeCount, -1);
+  if(left < pool->minFree)
+  {
+    pool->minFree = left;
+  }
+  return hdr + 1;
+}
+
+//=============================================================================
+// MsgFree() - give a block back to its pool, by its owner only
+//=============================================================================
+void MsgFree(void *msg)
+{
+  MSG_HEADER *hdr;
+  MSG_POOL *pool;
+
+  if(msg == NULL)
+  {
+    return;
+  }
+
+  hdr = (MSG_HEADER *)msg - 1;
+  configASSERT(hdr->state == MSG_STATE_OWNED);
+  hdr->state = MSG_STATE_FREE;
+  pool = hdr->pool;
+
+  do
+  {
+    hdr->next = (MSG_HEADER *)__LDREXW((uint32_t *)&pool->freeList);
+  } while(__STREXW((uint32_t)hdr, (uint32_t *)&pool->freeList));
+
+  MsgCountAdd(&pool->freeCount, 1);
+}
+
+//=============================================================================
+// MsgSend() - pass a message on, it is the queue's once this returns pdPASS
+//=============================================================================
+portBASE_TYPE MsgSend(QueueHandle_t queue, void *msg, TickType_t ticks)
+{
+  MSG_HEADER *hdr = (MSG_HEADER *)msg - 1;
+
+  // Queued before the send, the receiver may run before it returns
+  configASSERT(hdr->state == MSG_STATE_OWNED);
+  hdr->state = MSG_STATE_QUEUED;
+
+  if(xQueueSendToBack(queue, &msg, ticks) != pdPASS)
+  {
+    hdr->state = MSG_STATE_OWNED;
+    return pdFAIL;
+  }
+  return pdPASS;
+}
+
+//=============================================================================
+// MsgSendFromISR() - MsgSend() for interrupts
+//=============================================================================
+portBASE_TYPE MsgSendFromISR(QueueHandle_t queue, void *msg, portBASE_TYPE *woken)
+{
+  MSG_HEADER *hdr = (MSG_HEADER *)msg - 1;
+
+  configASSERT(hdr->state == MSG_STATE_OWNED);
+  hdr->state = MSG_STATE_QUEUED;
+
+  if(xQueueSendToBackFromISR(queue, &msg, woken) != pdPASS)
+  {
+    hdr->state = MSG_STATE_OWNED;
+    return pdFAIL;
+  }
+  return pdPASS;
+}
+
+//=============================================================================
+// MsgReceive() - take ownership of the next message in a queue
+//=============================================================================
+void *MsgReceive(QueueHandle_t queue, TickType_t ticks)
+{
+  MSG_HEADER *hdr;
+  void *msg;
+
+  if(xQueueReceive(queue, &msg, ticks) != pdPASS)
+  {
+    return NULL;
+  }
+
+  hdr = (MSG_HEADER *)msg - 1;
+  configASSERT(hdr->state == MSG_STATE_QUEUED);
+  hdr->state = MSG_STATE_OWNED;
+  return msg;
+}
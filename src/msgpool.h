@@ -0,0 +1,123 @@
+#ifndef MSGPOOL_H
+#define MSGPOOL_H
+
+/*
+ * msgpool.h
+ * Fixed size message pools, for passing records between tasks by reference
+ *
+ * A queue copies each item in and out, so a record sent by value is copied
+ * twice per hop. A record larger than a pointer is better allocated from a
+ * pool, filled in where it is and sent as its address through a queue of
+ * pointers (items of MSG_QUEUE_ITEM_SIZE):
+ *
+ *   DTMF_EVENT *ev = EventPoolAlloc();      // NULL when the pool is empty
+ *   ev->code = code;
+ *   if(MsgSend(xEventQueue, ev, 0) != pdPASS)
+ *     MsgFree(ev);                          // still ours, nobody took it
+ *
+ *   ev = EventPoolReceive(xEventQueue, portMAX_DELAY);
+ *   ...
+ *   MsgFree(ev);
+ *
+ * Every message has exactly one owner. MsgAlloc() makes the caller the
+ * owner. A successful MsgSend() or MsgSendFromISR() gives the message up:
+ * from then on it belongs to the queue, and the sender must not touch it.
+ * If the send fails, the sender still owns it. MsgReceive() makes the
+ * receiver the owner, and MsgFree() gives the message back to its pool;
+ * only the owner may call it, and it needs no pool argument. Each block
+ * records its state, and a free, send or receive from the wrong state
+ * (a double free, a message freed while queued, a message not from a
+ * pool) trips configASSERT().
+ *
+ * MsgAlloc() and MsgFree() are lock free, with the pool's free list head
+ * moved by LDREX/STREX, so they are safe from tasks and interrupts and
+ * never block. An exception taken between the LDREX and the STREX clears
+ * the exclusive monitor, so the STREX fails and the operation is retried.
+ * That also rules out the ABA problem of compare and swap stacks. An
+ * allocation that finds the pool empty returns NULL and is counted in
+ * exhausted.
+ *
+ * A pool is defined once, in a .c file, with
+ *   MSG_POOL_DEFINE(EventPool, DTMF_EVENT, 8);
+ * declared in a header with
+ *   MSG_POOL_DECLARE(EventPool, DTMF_EVENT);
+ * which also gives the typed EventPoolAlloc() and EventPoolReceive(), and
+ * set up with MsgPoolInit(&EventPool) before it is first used.
+ *
+ * Resources used:
+ * count * (MSG_HEADER_SIZE + sizeof(type)) bytes of RAM a pool
+ */
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include <stdint.h>
+
+/* Block states */
+#define MSG_STATE_FREE     0x4D534746UL   // "MSGF", in the pool
+#define MSG_STATE_OWNED    0x4D53474FUL   // "MSGO", held by one task or ISR
+#define MSG_STATE_QUEUED   0x4D534751UL   // "MSGQ", in a queue
+
+/* Queues carrying messages hold their addresses */
+#define MSG_QUEUE_ITEM_SIZE  sizeof(void *)
+
+struct MSG_POOL;
+
+/*
+ * Precedes every message. Padded to 8 bytes, so the message after it is
+ * aligned for any type and found from the message by subtracting the
+ * header.
+ */
+typedef struct MSG_HEADER
+{
+  struct MSG_HEADER *next;        // free list link, while free
+  volatile uint32_t state;        // MSG_STATE_*
+  struct MSG_POOL *pool;          // pool the block came from
+} __attribute__ ((aligned(8))) MSG_HEADER;
+
+#define MSG_HEADER_SIZE  sizeof(MSG_HEADER)
+
+typedef struct MSG_POOL
+{
+  MSG_HEADER * volatile freeList;
+  uint8_t *blocks;
+  uint16_t blockSize;             // header and message
+  uint16_t numBlocks;
+  volatile uint32_t freeCount;    // blocks in the pool now
+  volatile uint32_t minFree;      // fewest blocks there have been in the pool
+  volatile uint32_t exhausted;    // allocations that found the pool empty
+  const char *name;
+} MSG_POOL;
+
+/* Storage and pool of count messages of type */
+#define MSG_POOL_DEFINE(pool, type, count)                                   \
+  static struct { MSG_HEADER hdr; type msg; } pool##Blocks[count];           \
+  MSG_POOL pool = { NULL, (uint8_t *)pool##Blocks, sizeof(pool##Blocks[0]),  \
+                    (count), 0, 0, 0, #pool }
+
+/* The pool, and typed allocation and receive for its messages */
+#define MSG_POOL_DECLARE(pool, type)                                         \
+  extern MSG_POOL pool;                                                      \
+  static inline type *pool##Alloc(void)                                      \
+  {                                                                          \
+    return (type *)MsgAlloc(&pool);                                          \
+  }                                                                          \
+  static inline type *pool##Receive(QueueHandle_t queue, TickType_t ticks)   \
+  {                                                                          \
+    return (type *)MsgReceive(queue, ticks);                                 \
+  }
+
+/* Links every block into the free list, before the pool is first used */
+void MsgPoolInit(MSG_POOL *pool);
+
+/* From tasks and interrupts, never block */
+void *MsgAlloc(MSG_POOL *pool);
+void MsgFree(void *msg);
+
+/* Hand a message on through a queue of MSG_QUEUE_ITEM_SIZE items */
+portBASE_TYPE MsgSend(QueueHandle_t queue, void *msg, TickType_t ticks);
+portBASE_TYPE MsgSendFromISR(QueueHandle_t queue, void *msg, portBASE_TYPE *woken);
+
+/* Take the next message from a queue, NULL if none came in time */
+void *MsgReceive(QueueHandle_t queue, TickType_t ticks);
+
+#endif
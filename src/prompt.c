@@ -0,0 +1,424 @@
+#include "prompt.h"
+#include "tonegen.h"
+#include "semphr.h"
+
+#if PROMPT_RING_BUFFERS > DMA_COMP_QUEUE_SIZE
+  #error Every prompt ring completion must fit the DAC response queue
+#endif
+#if PROMPT_RING_BUFFERS > 16 || PROMPT_BLOCK_SAMPLES % 2
+  #error PROMPT_RING_BUFFERS or PROMPT_BLOCK_SAMPLES out of range
+#endif
+
+/*-----------------------------------------------------------
+ * Prompt decoding
+ *
+ * Each refill fills one ring buffer of PROMPT_BLOCK_SAMPLES.  The
+ * stored samples (half as many for 8 kHz prompts) are decoded as
+ * 32 bit PCM into the end of the buffer, then expanded in place
+ * towards the front into DACR words.  Past the end of the prompt
+ * the buffer is padded with midscale.
+ */
+
+/* G.711 expansion, 16 bit linear PCM for each code */
+static const int16_t ulawTable[256] =
+{
+  -32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+  -23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+  -15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+  -11900, -11388, -10876, -10364,  -9852,  -9340,  -8828,  -8316,
+   -7932,  -7676,  -7420,  -7164,  -6908,  -6652,  -6396,  -6140,
+   -5884,  -5628,  -5372,  -5116,  -4860,  -4604,  -4348,  -4092,
+   -3900,  -3772,  -3644,  -3516,  -3388,  -3260,  -3132,  -3004,
+   -2876,  -2748,  -2620,  -2492,  -2364,  -2236,  -2108,  -1980,
+   -1884,  -1820,  -1756,  -1692,  -1628,  -1564,  -1500,  -1436,
+   -1372,  -1308,  -1244,  -1180,  -1116,  -1052,   -988,   -924,
+    -876,   -844,   -812,   -780,   -748,   -716,   -684,   -652,
+    -620,   -588,   -556,   -524,   -492,   -460,   -428,   -396,
+    -372,   -356,   -340,   -324,   -308,   -292,   -276,   -260,
+    -244,   -228,   -212,   -196,   -180,   -164,   -148,   -132,
+    -120,   -112,   -104,    -96,    -88,    -80,    -72,    -64,
+     -56,    -48,    -40,    -32,    -24,    -16,     -8,      0,
+   32124,  31100,  30076,  29052,  28028,  27004,  25980,  24956,
+   23932,  22908,  21884,  20860,  19836,  18812,  17788,  16764,
+   15996,  15484,  14972,  14460,  13948,  13436,  12924,  12412,
+   11900,  11388,  10876,  10364,   9852,   9340,   8828,   8316,
+    7932,   7676,   7420,   7164,   6908,   6652,   6396,   6140,
+    5884,   5628,   5372,   5116,   4860,   4604,   4348,   4092,
+    3900,   3772,   3644,   3516,   3388,   3260,   3132,   3004,
+    2876,   2748,   2620,   2492,   2364,   2236,   2108,   1980,
+    1884,   1820,   1756,   1692,   1628,   1564,   1500,   1436,
+    1372,   1308,   1244,   1180,   1116,   1052,    988,    924,
+     876,    844,    812,    780,    748,    716,    684,    652,
+     620,    588,    556,    524,    492,    460,    428,    396,
+     372,    356,    340,    324,    308,    292,    276,    260,
+     244,    228,    212,    196,    180,    164,    148,    132,
+     120,    112,    104,     96,     88,     80,     72,     64,
+      56,     48,     40,     32,     24,     16,      8,      0,
+};
+
+static const int16_t alawTable[256] =
+{
+   -5504,  -5248,  -6016,  -5760,  -4480,  -4224,  -4992,  -4736,
+   -7552,  -7296,  -8064,  -7808,  -6528,  -6272,  -7040,  -6784,
+   -2752,  -2624,  -3008,  -2880,  -2240,  -2112,  -2496,  -2368,
+   -3776,  -3648,  -4032,  -3904,  -3264,  -3136,  -3520,  -3392,
+  -22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+  -30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+  -11008, -10496, -12032, -11520,  -8960,  -8448,  -9984,  -9472,
+  -15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+    -344,   -328,   -376,   -360,   -280,   -264,   -312,   -296,
+    -472,   -456,   -504,   -488,   -408,   -392,   -440,   -424,
+     -88,    -72,   -120,   -104,    -24,     -8,    -56,    -40,
+    -216,   -200,   -248,   -232,   -152,   -136,   -184,   -168,
+   -1376,  -1312,  -1504,  -1440,  -1120,  -1056,  -1248,  -1184,
+   -1888,  -1824,  -2016,  -1952,  -1632,  -1568,  -1760,  -1696,
+    -688,   -656,   -752,   -720,   -560,   -528,   -624,   -592,
+    -944,   -912,  -1008,   -976,   -816,   -784,   -880,   -848,
+    5504,   5248,   6016,   5760,   4480,   4224,   4992,   4736,
+    7552,   7296,   8064,   7808,   6528,   6272,   7040,   6784,
+    2752,   2624,   3008,   2880,   2240,   2112,   2496,   2368,
+    3776,   3648,   4032,   3904,   3264,   3136,   3520,   3392,
+   22016,  20992,  24064,  23040,  17920,  16896,  19968,  18944,
+   30208,  29184,  32256,  31232,  26112,  25088,  28160,  27136,
+   11008,  10496,  12032,  11520,   8960,   8448,   9984,   9472,
+   15104,  14592,  16128,  15616,  13056,  12544,  14080,  13568,
+     344,    328,    376,    360,    280,    264,    312,    296,
+     472,    456,    504,    488,    408,    392,    440,    424,
+      88,     72,    120,    104,     24,      8,     56,     40,
+     216,    200,    248,    232,    152,    136,    184,    168,
+    1376,   1312,   1504,   1440,   1120,   1056,   1248,   1184,
+    1888,   1824,   2016,   1952,   1632,   1568,   1760,   1696,
+     688,    656,    752,    720,    560,    528,    624,    592,
+     944,    912,   1008,    976,    816,    784,    880,    848,
+};
+
+/* IMA ADPCM quantizer steps and step index adjustment per code */
+static const int16_t imaStepTable[89] =
+{
+      7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+     19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+     50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+   2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+   5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t imaIndexTable[16] =
+{
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+typedef struct
+{
+  const PROMPT *prompt;
+  uint32_t decoded;        // stored samples decoded so far
+  uint32_t byte;           // next byte of prompt data
+  uint32_t blockPos;       // ADPCM sample within the block, 0 at a header
+  int32_t  predictor;      // ADPCM decoder state
+  int32_t  stepIndex;
+  int32_t  last;           // last DAC value, for interpolation
+  int32_t  lastAudio;      // ring buffer holding the end, -1 while audio remains
+  uint32_t generation;
+  volatile uint8_t active; // also cleared by PromptCancelFromISR()
+} PROMPT_STATE;
+
+/* Ring Buffers and Player State */
+static DAC_Sample promptRing[PROMPT_RING_BUFFERS][PROMPT_BLOCK_SAMPLES] DAC_DMA_BUFFER;
+static PROMPT_STATE promptState;
+static SemaphoreHandle_t promptMutex = NULL;
+static StaticSemaphore_t promptMutexBuffer;
+
+//=============================================================================
+// PromptDecode() - decode up to count stored samples as PCM, returns how many
+//=============================================================================
+static uint32_t PromptDecode(PROMPT_STATE *st, int32_t *pcm, uint32_t count)
+{
+  const uint8_t *data = st->prompt->data;
+  uint32_t left = st->prompt->numSamples - st->decoded;
+  uint32_t b = st->byte;
+  uint32_t i;
+
+  if(count > left)
+  {
+    count = left;
+  }
+
+  switch(st->prompt->format)
+  {
+    case PROMPT_FORMAT_ULAW:
+      for(i = 0; i < count; i++)
+      {
+        pcm[i] = ulawTable[data[b++]];
+      }
+      break;
+
+    case PROMPT_FORMAT_ALAW:
+      for(i = 0; i < count; i++)
+      {
+        pcm[i] = alawTable[data[b++]];
+      }
+      break;
+
+    case PROMPT_FORMAT_IMA_ADPCM:
+    {
+      uint32_t perBlock = 1 + 2 * (st->prompt->blockBytes - 4);
+      int32_t pred = st->predictor;
+      int32_t index = st->stepIndex;
+
+      for(i = 0; i < count; i++)
+      {
+        uint32_t pos = st->blockPos;
+        int32_t code;
+        int32_t step;
+        int32_t diff;
+
+        if(++st->blockPos == perBlock)
+        {
+          st->blockPos = 0;
+        }
+
+        // Block header: first sample verbatim and the step index
+        if(pos == 0)
+        {
+          pred = (int16_t)(data[b] | (data[b + 1] << 8));
+          index = (data[b + 2] > 88) ? 88 : data[b + 2];
+          b += 4;
+          pcm[i] = pred;
+          continue;
+        }
+
+        // Low nibble first
+        if(pos & 1)
+        {
+          code = data[b] & 0xF;
+        }
+        else
+        {
+          code = data[b++] >> 4;
+        }
+
+        step = imaStepTable[index];
+        diff = step >> 3;
+        if(code & 4) diff += step;
+        if(code & 2) diff += step >> 1;
+        if(code & 1) diff += step >> 2;
+        pred += (code & 8) ? -diff : diff;
+        if(pred > 32767) pred = 32767;
+        if(pred < -32768) pred = -32768;
+
+        index += imaIndexTable[code];
+        if(index < 0) index = 0;
+        if(index > 88) index = 88;
+        pcm[i] = pred;
+      }
+      st->predictor = pred;
+      st->stepIndex = index;
+      break;
+    }
+
+    default:
+      count = 0;
+      break;
+  }
+
+  st->byte = b;
+  st->decoded += count;
+  return count;
+}
+
+//=============================================================================
+// PromptFill() - decode the next block of the prompt into a ring buffer
+//=============================================================================
+static void PromptFill(PROMPT_STATE *st, uint32_t ring)
+{
+  DAC_Sample *dst = promptRing[ring];
+  int32_t *pcm;
+  uint32_t stored;
+  uint32_t got;
+  uint32_t i;
+  int32_t v;
+
+  if(st->prompt->sampleRate == DAC_SAMPLE_PER_SECOND)
+  {
+    stored = PROMPT_BLOCK_SAMPLES;
+    pcm = (int32_t *)dst;
+    got = PromptDecode(st, pcm, stored);
+    for(i = 0; i < stored; i++)
+    {
+      v = (i < got) ? ((pcm[i] + 32768) >> 6) : DAC_MIDSCALE;
+      dst[i] = DAC_SAMPLE(v);
+    }
+  }
+  else
+  {
+    // Decode into the back half, each stored sample becomes two outputs
+    // written at or before the one being read
+    stored = PROMPT_BLOCK_SAMPLES / 2;
+    pcm = (int32_t *)&dst[stored];
+    got = PromptDecode(st, pcm, stored);
+    for(i = 0; i < stored; i++)
+    {
+      v = (i < got) ? ((pcm[i] + 32768) >> 6) : DAC_MIDSCALE;
+      dst[2 * i] = DAC_SAMPLE((st->last + v) >> 1);
+      dst[2 * i + 1] = DAC_SAMPLE(v);
+      st->last = v;
+    }
+  }
+
+  if(st->lastAudio < 0 && st->decoded >= st->prompt->numSamples)
+  {
+    st->lastAudio = ring;
+  }
+}
+
+//=============================================================================
+// PromptPlayerInit() - create the player's resources, call before use
+//=============================================================================
+void PromptPlayerInit(void)
+{
+  promptMutex = xSemaphoreCreateMutexStatic(&promptMutexBuffer);
+  configASSERT(promptMutex);
+}
+
+//=============================================================================
+// PromptPlay() - start a prompt, replacing any prompt still playing
+//=============================================================================
+portBASE_TYPE PromptPlay(const PROMPT *prompt)
+{
+  PROMPT_STATE *st = &promptState;
+  DAC_Setup_Message dmaReq;
+  portBASE_TYPE xStatus;
+  uint32_t ring;
+
+  if(prompt->sampleRate != 8000 && prompt->sampleRate != DAC_SAMPLE_PER_SECOND)
+  {
+    LOG_ERROR("Unsupported prompt sample rate\n");
+    return pdFAIL;
+  }
+  if(prompt->format == PROMPT_FORMAT_IMA_ADPCM && prompt->blockBytes <= 4)
+  {
+    return pdFAIL;
+  }
+
+  xSemaphoreTake(promptMutex, portMAX_DELAY);
+
+  st->prompt = prompt;
+  st->decoded = 0;
+  st->byte = 0;
+  st->blockPos = 0;
+  st->predictor = 0;
+  st->stepIndex = 0;
+  st->last = DAC_MIDSCALE;
+  st->lastAudio = -1;
+  st->generation = (st->generation + 1) & 0xF;
+  st->active = 1;
+
+  for(ring = 0; ring < PROMPT_RING_BUFFERS; ring++)
+  {
+    PromptFill(st, ring);
+  }
+
+  dmaReq.firstSample = &promptRing[0][0];
+  dmaReq.numberSamples = PROMPT_BLOCK_SAMPLES;
+  dmaReq.flags = DAC_FLAG_STREAM;
+  dmaReq.ringCount = PROMPT_RING_BUFFERS;
+  dmaReq.index = PROMPT_INDEX_BASE | (st->generation << 4);
+  dmaReq.chain = NULL;
+
+  xStatus = xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 );
+  if(xStatus != pdPASS)
+  {
+    LOG_ERROR("Failed to send DMA request\n");
+    st->active = 0;
+  }
+
+  xSemaphoreGive(promptMutex);
+  return xStatus;
+}
+
+//=============================================================================
+// PromptRefill() - handle the completion of a prompt ring buffer
+//=============================================================================
+/* Called by the task receiving DAC completions for every index that
+ * PROMPT_IS_COMPLETION().  Once the buffer holding the end of the
+ * prompt has played, the stream is stopped.
+ */
+void PromptRefill(uint32_t index)
+{
+  PROMPT_STATE *st = &promptState;
+  DAC_Setup_Message dmaReq;
+  portBASE_TYPE xStatus;
+  uint32_t ring = index & 0xF;
+
+  xSemaphoreTake(promptMutex, portMAX_DELAY);
+
+  if(st->active && ((index >> 4) & 0xF) == st->generation && ring < PROMPT_RING_BUFFERS)
+  {
+    if(st->lastAudio == (int32_t)ring)
+    {
+      dmaReq.firstSample = NULL;
+      dmaReq.numberSamples = 0;
+      dmaReq.flags = 0;
+      dmaReq.ringCount = 0;
+      dmaReq.index = DAC_INDEX_NONE;
+      dmaReq.chain = NULL;
+      //A key may have taken the DAC over from its interrupt meanwhile
+      taskENTER_CRITICAL();
+      xStatus = st->active ? xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 ) : pdPASS;
+      st->active = 0;
+      taskEXIT_CRITICAL();
+      if(xStatus != pdPASS)
+      {
+        LOG_ERROR("Failed to send DMA request\n");
+      }
+    }
+    else
+    {
+      PromptFill(st, ring);
+    }
+  }
+
+  xSemaphoreGive(promptMutex);
+}
+
+//=============================================================================
+// PromptCancel() - forget the prompt playing, the DAC has been given other work
+//=============================================================================
+void PromptCancel(void)
+{
+  xSemaphoreTake(promptMutex, portMAX_DELAY);
+  promptState.active = 0;
+  xSemaphoreGive(promptMutex);
+}
+
+//=============================================================================
+// PromptCancelFromISR() - PromptCancel() for an interrupt that has queued
+// other work to the DAC
+//=============================================================================
+/* Takes no mutex: clearing the flag is a single store, and PromptRefill()
+ * checks it again inside a critical section before stopping the DAC.
+ */
+void PromptCancelFromISR(void)
+{
+  promptState.active = 0;
+}
+
+#ifdef PROMPT_UNIT_TEST
+/* Unit Test Task Replaying The Built In Prompt */
+void vTaskPromptTest( void *pvParameters )
+{
+  for( ;; )
+  {
+    if(PromptPlay(&promptBeep) != pdPASS)
+    {
+      LOG_ERROR("Prompt failed\n");
+    }
+    LOG_INFO("DAC stream drops %lu\n", dacStreamDropped);
+    vTaskDelay(3000 / portTICK_RATE_MS);
+  }
+}
+#endif
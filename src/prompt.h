@@ -0,0 +1,72 @@
+#ifndef PROMPT_H
+#define PROMPT_H
+
+/*
+ * prompt.h
+ * Playback of recorded announcement prompts stored in flash
+ *
+ * Prompts are kept compressed in flash, as G.711 (mu-law or A-law, 8 bits a
+ * sample) or IMA ADPCM (4 bits a sample, WAV style blocks), at 8 or 16 kHz.
+ * At 8 kHz ADPCM a minute of audio takes 240 KB, so a few minutes fit the
+ * 512 KB part next to the code. tools/prompt2c.py converts a WAV file into a
+ * PROMPT definition.
+ *
+ * PromptPlay() decodes the start of a prompt into a ring of
+ * PROMPT_RING_BUFFERS DAC buffers and hands the ring to the DAC as a
+ * DAC_FLAG_STREAM transfer. Each time a buffer drains its completion reaches
+ * the tone generator task, which calls PromptRefill() to decode the next
+ * block into it, just ahead of the DMA. Every refill decodes a fixed number
+ * of samples, so the CPU spent per block is bounded whatever the format.
+ * 8 kHz prompts are brought up to the DAC rate by linear interpolation.
+ *
+ * Resources used:
+ * PROMPT_RING_BUFFERS * PROMPT_BLOCK_SAMPLES * 4 bytes of AHB SRAM
+ * One mutex, statically allocated and created by PromptPlayerInit()
+ * 1 KB of flash for the G.711 expansion tables
+ *
+ * Any other message to the DAC (a key press) ends a prompt early.
+ */
+
+#include "main.h"
+#include "dac.h"
+
+/* Stored formats */
+#define PROMPT_FORMAT_ULAW       0
+#define PROMPT_FORMAT_ALAW       1
+#define PROMPT_FORMAT_IMA_ADPCM  2
+
+/* Ring of DAC buffers being refilled */
+#define PROMPT_RING_BUFFERS      3        // Must fit the DAC response queue
+#define PROMPT_BLOCK_SAMPLES     256      //CONFIGURABLE - DAC samples decoded per refill (16 ms)
+
+/*
+ * Stream completions for prompts carry PROMPT_INDEX_BASE, a generation
+ * number and the ring index, so completions from an earlier prompt that
+ * are still queued can be told apart and ignored
+ */
+#define PROMPT_INDEX_BASE        0x100
+#define PROMPT_INDEX_MASK        (~0xFFUL)
+#define PROMPT_IS_COMPLETION(i)  (((i) & PROMPT_INDEX_MASK) == PROMPT_INDEX_BASE)
+
+typedef struct
+{
+  uint8_t  format;         // PROMPT_FORMAT_*
+  uint16_t sampleRate;     // 8000 or DAC_SAMPLE_PER_SECOND
+  uint16_t blockBytes;     // IMA ADPCM block size, 4 byte header included
+  uint32_t numSamples;     // decoded length
+  const uint8_t *data;
+} PROMPT;
+
+/* Prompts built into the image (prompt_data.c) */
+extern const PROMPT promptBeep;
+
+void PromptPlayerInit(void);
+portBASE_TYPE PromptPlay(const PROMPT *prompt);
+void PromptRefill(uint32_t index);
+void PromptCancel(void);
+void PromptCancelFromISR(void);
+
+/* Unit Test Task */
+void vTaskPromptTest( void *pvParameters );
+
+#endif
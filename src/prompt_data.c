@@ -0,0 +1,88 @@
+/* Generated by tools/prompt2c.py from beep.wav, do not edit */
+#include "prompt.h"
+
+static const uint8_t promptBeepData[1218] =
+{
+  0x00, 0x00, 0x00, 0x00, 0x77, 0xD7, 0xAF, 0x60, 0x24, 0xD9, 0xAC, 0x51, 0x14, 0xC9, 0x9C, 0x41,
+  0x14, 0xC9, 0xAB, 0x51, 0x14, 0xC9, 0x9B, 0x41, 0x14, 0xC9, 0xAB, 0x52, 0x23, 0xDA, 0xAB, 0x52,
+  0x23, 0xDA, 0x9B, 0x51, 0x13, 0xD9, 0x9B, 0x51, 0x13, 0xCA, 0x9B, 0x51, 0x13, 0xD9, 0x9B, 0x51,
+  0x13, 0xD9, 0xAA, 0x42, 0x13, 0xD9, 0x9B, 0x41, 0x14, 0xC9, 0x9B, 0x51, 0x22, 0xCA, 0x9B, 0x51,
+  0x13, 0xC9, 0x9C, 0x41, 0x13, 0xD9, 0x9A, 0x31, 0x15, 0xC9, 0x9B, 0x41, 0x14, 0xC9, 0x8B, 0x31,
+  0x15, 0xC9, 0x9B, 0x41, 0x14, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x51, 0x12, 0xB9, 0x9D, 0x41,
+  0x13, 0xC9, 0x8C, 0x40, 0x12, 0xB9, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41,
+  0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41,
+  0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41,
+  0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xC9, 0xAB, 0x42, 0x23, 0xCA, 0x9C, 0x41,
+  0x13, 0xD9, 0x9A, 0x31, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32,
+  0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32,
+  0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32,
+  0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32,
+  0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32,
+  0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x41, 0x23, 0xCA, 0xAB, 0x42,
+  0x25, 0x21, 0x49, 0x00, 0x91, 0xBD, 0x19, 0x44, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x19, 0x34, 0xA2, 0xBC, 0x2A, 0x44, 0x91, 0xBC, 0x19, 0x25,
+  0x91, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34,
+  0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34,
+  0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34,
+  0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34,
+  0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34,
+  0xA1, 0xDB, 0x19, 0x34, 0x91, 0xBC, 0x2A, 0x34, 0xA2, 0xCC, 0x19, 0x34, 0x91, 0xAD, 0x19, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53,
+  0xE0, 0x2E, 0x4C, 0x00, 0xB9, 0xAB, 0x52, 0x13, 0xD9, 0x8B, 0x31, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x41, 0x23,
+  0xCA, 0xAB, 0x42, 0x14, 0xC9, 0x9B, 0x51, 0x12, 0xB9, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13,
+  0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13,
+  0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13,
+  0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13,
+  0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13,
+  0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xC9, 0xAB, 0x42, 0x23,
+  0xCA, 0x9C, 0x41, 0x13, 0xD9, 0x9A, 0x31, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15,
+  0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x32, 0x15, 0xC9, 0x9B, 0x41, 0x23, 0xCA, 0xAB, 0x42, 0x14,
+  0x25, 0x21, 0x4A, 0x00, 0xCB, 0x19, 0x34, 0x91, 0xBD, 0x18, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x19, 0x34, 0xA2, 0xBC, 0x2A, 0x44, 0x91, 0xBC, 0x19, 0x25, 0x91,
+  0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1,
+  0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1,
+  0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1,
+  0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1,
+  0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0xA1,
+  0xDB, 0x19, 0x34, 0xA1, 0xDB, 0x19, 0x34, 0x91, 0xBC, 0x2A, 0x34, 0xA2, 0xCC, 0x19, 0x34, 0x91,
+  0xAD, 0x19, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91, 0xBC, 0x29, 0x53, 0x91,
+  0x00, 0x00, 0x4A, 0x00, 0xAB, 0x42, 0x14, 0xC9, 0x9B, 0x51, 0x12, 0xB9, 0x9D, 0x41, 0x13, 0xBA,
+  0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA,
+  0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA,
+  0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA,
+  0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xBA,
+  0x9D, 0x41, 0x13, 0xBA, 0x9D, 0x41, 0x13, 0xC9, 0xAB, 0x42, 0x23, 0xCA, 0x9C, 0x41, 0x13, 0xD9,
+  0x9A, 0x31, 0x05, 0xC8, 0x9A, 0x31, 0x14, 0xC9, 0x9B, 0x51, 0x12, 0xB9, 0x9C, 0x41, 0x13, 0xD9,
+  0x9A, 0x31, 0x14, 0xC9, 0x9B, 0x51, 0x12, 0xB9, 0x9D, 0x41, 0x12, 0xB9, 0x9C, 0x41, 0x13, 0xC9,
+  0x8C, 0x40, 0x12, 0xB9, 0x9C, 0x41, 0x13, 0xC9, 0x8C, 0x31, 0x13, 0xD9, 0x9B, 0x41, 0x23, 0xCA,
+  0xAB, 0x42, 0x14, 0xC9, 0x8B, 0x31, 0x14, 0xC9, 0x9B, 0x41, 0x04, 0xB9, 0x9B, 0x51, 0x13, 0xBA,
+  0x9C, 0x41, 0x13, 0xC9, 0xAB, 0x42, 0x13, 0xC9, 0x8C, 0x31, 0x13, 0xD9, 0x8B, 0x31, 0x14, 0xC9,
+  0x8B, 0x31, 0x14, 0xC9, 0x9A, 0x31, 0x13, 0xC9, 0x9B, 0x32, 0x13, 0xC9, 0x8B, 0x31, 0x12, 0xAA,
+  0x89, 0x01,
+};
+
+const PROMPT promptBeep =
+{
+  2, 8000, 256, 2400, promptBeepData
+};
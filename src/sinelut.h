@@ -7,4 +7,7 @@
 
 float sin_aft(float amp, float freq, uint16_t t);
 
+/* One cycle of sine in Q15, with a guard entry at [LUT_SIZE] */
+extern const int16_t sine_lut_q15[LUT_SIZE + 1];
+
 #endif
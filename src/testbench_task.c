@@ -10,6 +10,7 @@
 
 /* Demo includes. */
 #include "basic_io.h"
+#include "log.h"
 
 #include "testbench_task.h"
 #include "dtmf_data.h"
@@ -65,7 +66,7 @@ void vTestBenchTask( void *pvParameters ) {
 	int tone_index = 0;
 	struct TestBenchTaskParam_t* params = (struct TestBenchTaskParam_t *)pvParameters;
 
-	vPrintString( "Testbench started\n" );
+	LOG_INFO("Testbench started\n");
 
 	for( ;; )
 	{
@@ -1,383 +1,781 @@
 #include "tonegen.h"
 #include "sinelut.h"
+#include "cyclecount.h"
+#include "prompt.h"
+#include "keypad.h"
+
+#if LUT_SIZE != 256
+  #error ToneGenBlock() indexes sine_lut_q15[] with the top 8 bits of the phase
+#endif
 
 /*-----------------------------------------------------------
  * vTaskToneGenerator
  *
- * Description:  This task runs in an infinite loop and fills a
- * buffer with samples for the tone currently being played.  Tone
- * type (i.e. 0, 1, #, etc.) and whether the tone should be on or off comes in through
- * the xQueueToneInput message queue.  The tasks fills the buffer
- * in steps, and checks for a new request before going on to the
- * next step.  This minimizes latency of filling an entire buffer
- * before receiving the next request.  The step size for filling the buffer is configurable
- * (TONE_BUFFER_SAMPLE_SET).  The buffer size is also configurable
- * (TONE_BUFFER_SIZE).  TONE_BUFFER_SIZE should be a multiple of
- * TONE_BUFFER_SAMPLE_SET or the buffer will be overrun.
+ * Description:  This task is an event driven state machine.  It
+ * blocks on xToneEventSet, a queue set holding xQueueToneInput (key
+ * on/off requests) and dacResponseHandle (DAC completions, i.e. a
+ * tone buffer coming free), and does no work between events.
  *
- * When a buffer is full, a DMA request is sent to the xQueueDMARequest
- * message queue and a new buffer is used while the previous buffer
- * contents are sent to the DAC via DMA.  Upon DMA completion, a message
- * is received from the xQueueDMAComplete queue and the buffer is made
- * available for use.
+ * Completions of prompt ring buffers (prompt.h) are passed to
+ * PromptRefill(), which decodes the next block of the prompt.
+ *
+ * A key on request selects the tone and, in the buffered mode, fills
+ * every free tone buffer and queues each one to the DAC.  Each
+ * completion releases its buffer back to the pool by index and, while
+ * the tone is still on, refills it and queues it again.  A key off
+ * request just stops the refilling; buffers in flight play out.
  *
  * Inputs:  xQueueToneInput   Message Queue for New Tone Requests
- *          xQueueDMAComplete Message Queue for DMA Complete
+ *          dacResponseHandle Message Queue for DMA Complete
  *                             (free tone buffer)
  * Outputs: xQueueDMARequest  Message Queue for DMA Requests
  *
+ * With TONEGEN_USE_TONE_TABLES the buffers are not used for DTMF.  A
+ * table holding a whole number of periods of each tone pair is built
+ * once at startup, and a key press hands that table to the DAC as a
+ * continuous transfer.  The DMA engine loops it until the key is
+ * released, so the task sleeps for the whole tone.
+ *
+ * With KEYPAD_FAST_TONE the keypad interrupt queues the table itself
+ * and passes the key on marked TONE_REQ_STARTED; the task then only
+ * ends any prompt and keeps its state, it does not start the tone again.
+ *
+ * With TONEGEN_CPU_STATS the cycles spent handling events are counted
+ * and, at each key off, reported against the cycles the tone lasted.
+ *
  */
 
 /* Shared Memory Tone Buffer and Tone Buffer Management Constructs */
 DAC_Sample sampleBuf[NUM_TONE_BUFFERS][TONE_BUFFER_SIZE];
-uint8_t bufInUse[NUM_TONE_BUFFERS];
-const uint32_t INVALID_BUFFER = 0xFF;
-uint32_t t;
+TONE_BUFFER_POOL toneBufferPool;
+
+#ifdef TONEGEN_USE_TONE_TABLES
+/* Period-Aligned Tone Tables */
+DAC_Sample toneTable[TONE_TABLE_SAMPLES] DAC_DMA_BUFFER;
+DAC_Sample *toneTableStart[NUM_DTMF_TONES];
+
+/* The lengths were searched (64 to TONE_BUFFER_SIZE samples) for the
+ * smallest error once both tones are rounded to whole cycles, so a
+ * table loops without a phase step.  Worst case is 0.41% ('8'), well
+ * inside the 1.5% DTMF acceptance band.
+ */
+const TONE_TABLE_INFO toneTableInfo[NUM_DTMF_TONES] =
+{
+  { '1', 252, 11, 19 },   //  697/1209 Hz ->  698.4/1206.3 Hz
+  { '2', 252, 11, 21 },   //  697/1336 Hz ->  698.4/1333.3 Hz
+  { '3', 184,  8, 17 },   //  697/1477 Hz ->  695.7/1478.3 Hz
+  { 'A', 206,  9, 21 },   //  697/1633 Hz ->  699.0/1631.1 Hz
+  { '4', 146,  7, 11 },   //  770/1209 Hz ->  767.1/1205.5 Hz
+  { '5', 228, 11, 19 },   //  770/1336 Hz ->  771.9/1333.3 Hz
+  { '6', 249, 12, 23 },   //  770/1477 Hz ->  771.1/1477.9 Hz
+  { 'B', 166,  8, 17 },   //  770/1633 Hz ->  771.1/1638.6 Hz
+  { '7', 225, 12, 17 },   //  852/1209 Hz ->  853.3/1208.9 Hz
+  { '8', 132,  7, 11 },   //  852/1336 Hz ->  848.5/1333.3 Hz
+  { '9', 206, 11, 19 },   //  852/1477 Hz ->  854.4/1475.7 Hz
+  { 'C', 225, 12, 23 },   //  852/1633 Hz ->  853.3/1635.6 Hz
+  { '*', 119,  7,  9 },   //  941/1209 Hz ->  941.2/1210.1 Hz
+  { '0', 204, 12, 17 },   //  941/1336 Hz ->  941.2/1333.3 Hz
+  { '#', 119,  7, 11 },   //  941/1477 Hz ->  941.2/1479.0 Hz
+  { 'D', 255, 15, 26 },   //  941/1633 Hz ->  941.2/1631.4 Hz
+};
+#endif
 
 void vTaskToneGenerator( void *pvParameters )
 {
   char dtfmReq;
-  portBASE_TYPE xStatus;
+  DAC_Complete_Message completeMessage;
+  QueueSetMemberHandle_t xActivated;
+  char tone = 0;
+#if defined(TONEGEN_CPU_STATS) || defined(KEYPAD_LATENCY_STATS) || !defined(TONEGEN_USE_TONE_TABLES)
   TONE_ON_OFF_TYPE tone_in_progress = TONE_OFF;
-  uint8_t activeBuffer  = INVALID_BUFFER;
+#endif
+#ifdef TONEGEN_USE_TONE_TABLES
+  char started;
+#endif
   uint8_t i = 0;
-  t = 0;
+#ifdef TONEGEN_CPU_STATS
+  uint32_t eventStart;
+  uint32_t toneStart = 0;
+  uint32_t busyCycles = 0;
+#endif
 
   for(i = 0; i < NUM_TONE_BUFFERS; i++)
   {
-	  vPrintStringAndNumber("sampleBuf[i] = ", (uint32_t) sampleBuf[i]);
-	  bufInUse[i] = 0;
+	  LOG_DEBUG("sampleBuf[i] = %lx\n", sampleBuf[i]);
   }
+  ToneBufferPoolInit(&toneBufferPool, &sampleBuf[0][0], NUM_TONE_BUFFERS, TONE_BUFFER_SIZE);
+
+#ifdef TONEGEN_USE_TONE_TABLES
+  ToneTableInit();
+#endif
+#ifdef TONEGEN_CPU_STATS
+  CycleCounterInit();
+#endif
 
   /* As per most tasks, this task is implemented in an infinite loop. */
   for( ;; )
   {
-    /* Check for new input from the queue, don't wait if there is
-     * not any new input
-     */
-    xStatus = xQueueReceive( xQueueToneInput, &dtfmReq, 0 );
-
-    //If something was received from the queue, there is a new command
-    //to process
-    if( xStatus == pdPASS )
-    {
-      if(dtfmReq != 0) //Tone On request
-      {
-        #ifdef DEBUG_TONE_SCHED
-          vPrintStringAndNumber("Received new ON request.  Tone =", dtfmReq.tone_type);
-        #endif
-        //Set tone in progress flag
-        tone_in_progress = TONE_ON;
-
-        //Fill buffer with some samples
-        FillBuffer(dtfmReq, &activeBuffer);
-        #ifdef DEBUG_TONE_SCHED
-          vPrintString("   New request.  Samples Added.\n");
-        #endif
+    /* Sleep until a key request or a buffer completion arrives */
+    xActivated = xQueueSelectFromSet( xToneEventSet, portMAX_DELAY );
+#ifdef TONEGEN_CPU_STATS
+    eventStart = CycleCounterGet();
+#endif
 
-        SendSamplesToDMA(&activeBuffer);
-      }
-      else // dtfmReq.on_off == TONE_OFF
+    if( xActivated == xQueueToneInput )
+    {
+      if( xQueueReceive( xQueueToneInput, &dtfmReq, 0 ) == pdPASS )
       {
         #ifdef DEBUG_TONE_SCHED
-          vPrintString("  Tone off\n");
+          LOG_INFO("Received new request.  Tone = %lu\n", dtfmReq);
         #endif
-
-          //Clear tone in progress flag
-        tone_in_progress = TONE_OFF;
+#ifdef TONEGEN_CPU_STATS
+        if( dtfmReq != 0 && tone_in_progress == TONE_OFF )
+        {
+          toneStart = eventStart;
+          busyCycles = 0;
+        }
+#endif
+#ifdef TONEGEN_USE_TONE_TABLES
+        started = (dtfmReq & TONE_REQ_STARTED) != 0;
+#endif
+        dtfmReq &= ~TONE_REQ_STARTED;
+        tone = dtfmReq;
+#if defined(TONEGEN_CPU_STATS) || defined(KEYPAD_LATENCY_STATS) || !defined(TONEGEN_USE_TONE_TABLES)
+        tone_in_progress = (dtfmReq != 0) ? TONE_ON : TONE_OFF;
+#endif
+        //The key takes the DAC over from any prompt
+        PromptCancel();
+#ifdef TONEGEN_USE_TONE_TABLES
+        if( !started )
+        {
+          PlayToneTable(tone);
+        }
+#ifdef KEYPAD_LATENCY_STATS
+        else if( tone_in_progress == TONE_ON )
+        {
+          //The DAC handler outranks this task, so the tone has started
+          KeypadLatencyReport();
+        }
+#endif
+#else
+        if( tone_in_progress == TONE_ON )
+        {
+          //Fill every free buffer, the rest follow as completions arrive
+          FillAndSendFreeBuffers(tone);
+        }
+#endif
       }
     }
-    //Else nothing was received from the queue, continue previous
-    //request
-    else
+    else if( xActivated == dacResponseHandle )
     {
-      if(tone_in_progress == TONE_ON)
+      if( xQueueReceive( dacResponseHandle, &completeMessage, 0 ) == pdPASS )
       {
-        FillBuffer(dtfmReq, &activeBuffer);
-        #ifdef DEBUG_TONE_SCHED
-          vPrintString("   No new request.  Samples Added.\n");
-        #endif
-
-        SendSamplesToDMA(&activeBuffer);
+        if( PROMPT_IS_COMPLETION(completeMessage.index) )
+        {
+          //Prompt ring buffer drained, decode the next block into it
+          PromptRefill(completeMessage.index);
+        }
+#ifndef TONEGEN_USE_TONE_TABLES
+        else if( completeMessage.index != DAC_INDEX_NONE )
+        {
+          #ifdef DEBUG_TONE_SCHED
+            LOG_INFO("  Buf rel %lu\n", completeMessage.index);
+          #endif
+          //DMA request completed, release buffer and refill it while the tone is on
+          ReleaseBuffer(completeMessage.index);
+          if( tone_in_progress == TONE_ON )
+          {
+            FillAndSendFreeBuffers(tone);
+          }
+        }
+#endif
+        //Tables are never handed to anyone else, nothing to release
       }
-      //else no active tone ... nothing to play
     }
+
+#ifdef TONEGEN_CPU_STATS
+    busyCycles += CycleCounterGet() - eventStart;
+    if( xActivated == xQueueToneInput && tone_in_progress == TONE_OFF && toneStart != 0 )
+    {
+      //Busy share of the tone in hundredths of a percent
+      LOG_INFO("ToneGen busy cycles %lu\n", busyCycles);
+      LOG_INFO("ToneGen busy 0.01%% %lu\n", ((uint64_t)busyCycles * 10000 / (CycleCounterGet() - toneStart)));
+      toneStart = 0;
+    }
+#endif
   }
 }
 
-void FillBuffer(char btn, uint8_t *activeBuffer)
+#ifdef TONEGEN_USE_TONE_TABLES
+//=============================================================================
+// ToneTableInit() - build the period-aligned table of every key
+//=============================================================================
+void ToneTableInit(void)
 {
-  circular_buffer cb;
-  uint8_t newBufNeeded = 0;
+  uint32_t i;
+  uint32_t start = 0;
+  TONE_OSC osc[2];
 
-  //Obtain valid buffer
-  if(*activeBuffer == INVALID_BUFFER)
+  for(i = 0; i < NUM_DTMF_TONES; i++)
   {
-    GetNextAvailableBuffer(activeBuffer);
-    newBufNeeded = 1;
+    configASSERT( start + toneTableInfo[i].length <= TONE_TABLE_SAMPLES );
+
+    // Tone frequencies that fit a whole number of cycles in the table
+    ToneOscInit(&osc[0], (float)toneTableInfo[i].cyclesRow * DAC_SAMPLE_PER_SECOND / toneTableInfo[i].length, DTMF_AMPLITUDE);
+    ToneOscInit(&osc[1], (float)toneTableInfo[i].cyclesCol * DAC_SAMPLE_PER_SECOND / toneTableInfo[i].length, DTMF_AMPLITUDE);
+
+    toneTableStart[i] = &toneTable[start];
+    ToneGenBlock(osc, 2, DAC_MIDSCALE, toneTableStart[i], toneTableInfo[i].length);
+    start += toneTableInfo[i].length;
   }
+}
+
+//=============================================================================
+// ToneTableIndex() - table index of a keypad symbol, -1 if unknown
+//=============================================================================
+int ToneTableIndex(char btn)
+{
+  int i;
 
-  //Add samples to buffer
-  if(*activeBuffer != INVALID_BUFFER)
+  for(i = 0; i < NUM_DTMF_TONES; i++)
   {
-      cb_init(&cb, &sampleBuf[*activeBuffer][0], TONE_BUFFER_SIZE);
-      dtmfGen(btn, &cb);
+    if(toneTableInfo[i].btn == btn)
+    {
+      return i;
+    }
   }
-  else
+  return -1;
+}
+
+//=============================================================================
+// ToneTableMessage() - DAC request looping the table of a key, 0 stops
+//=============================================================================
+static portBASE_TYPE ToneTableMessage(char btn, DAC_Setup_Message *dmaReq)
+{
+  int idx;
+
+  //A message with no samples stops the tone currently looping
+  dmaReq->firstSample = NULL;
+  dmaReq->numberSamples = 0;
+  dmaReq->flags = 0;
+  dmaReq->ringCount = 0;
+  dmaReq->index = 0;
+  dmaReq->chain = NULL;
+
+  if(btn != 0)
   {
-    vPrintString("ERROR:  Buffer invalid\n");
+    idx = ToneTableIndex(btn);
+    if(idx < 0 || toneTableStart[idx] == NULL)
+    {
+      return pdFAIL;
+    }
+    dmaReq->firstSample = toneTableStart[idx];
+    dmaReq->numberSamples = toneTableInfo[idx].length;
+    dmaReq->flags = DAC_FLAG_CONTINUOUS;
   }
+  return pdPASS;
 }
 
-
-void SendSamplesToDMA(uint8_t *activeBuffer)
+//=============================================================================
+// PlayToneTable() - loop the table of a key on the DAC, or stop on '\0'
+//=============================================================================
+void PlayToneTable(char btn)
 {
   portBASE_TYPE xStatus;
   DAC_Setup_Message dmaReq;
 
-  if(*activeBuffer != INVALID_BUFFER)
+  if(ToneTableMessage(btn, &dmaReq) != pdPASS)
   {
-	  dmaReq.firstSample = &sampleBuf[*activeBuffer][0];
-	  dmaReq.numberSamples = TONE_BUFFER_SIZE;
-	  xStatus = xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 );
-
-	  if(xStatus != pdPASS)
-	  {
-		vPrintString("Failed to send DMA request");
-	  }
-
-	  //Clear offset and obtain next buffer
-	  *activeBuffer = INVALID_BUFFER;
-	  GetNextAvailableBuffer(activeBuffer);
+    LOG_ERROR("Unknown tone request\n");
   }
-  else
+
+  xStatus = xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 );
+  if(xStatus != pdPASS)
   {
-	  vPrintString("Unable to send DMA request - buffer invalid.\n");
+    LOG_ERROR("Failed to send DMA request\n");
   }
 }
 
-void GetNextAvailableBuffer(uint8_t *activeBuffer)
+//=============================================================================
+// PlayToneTableFromISR() - PlayToneTable() for interrupts, pdFAIL if not sent
+//=============================================================================
+/* Queues the request straight to the DAC handler, which runs at the
+ * highest task priority, so the tone starts as soon as the interrupt
+ * returns.  Fails, sending nothing, for an unknown key, before
+ * ToneTableInit() has run or when the DAC queue is full.
+ */
+portBASE_TYPE PlayToneTableFromISR(char btn, portBASE_TYPE *woken)
 {
-  uint8_t buf = 0;
-  *activeBuffer = INVALID_BUFFER;
-  uint8_t done = 0;
-  portBASE_TYPE xStatus;
-  DAC_Complete_Message completeMessage;
+  DAC_Setup_Message dmaReq;
 
-  while(done == 0)
+  if(ToneTableMessage(btn, &dmaReq) != pdPASS)
   {
-	  //Loop over all buffers
-	  for(buf = 0; buf < NUM_TONE_BUFFERS; buf++)
-	  {
-		//Check for an available buffer
-		if(bufInUse[buf] == 0)
-		{
-		  //available buffer found!
-		  bufInUse[buf] = 1;
-		  *activeBuffer = buf;
-		  #ifdef DEBUG_TONE_SCHED
-			vPrintStringAndNumber("  NewBuf ", buf);
-		  #endif
-
-		  //Set done flag, buffer is found
-		  done = 1;
-		  break;
-		}
-	  }
-
-	  if(!done)
-	  {
-		  //At this point, no buffer is available
-		  //Block / wait until a buffer is available before
-		  //the task proceeds
-
-		  xStatus = xQueueReceive( dacResponseHandle, &completeMessage, portMAX_DELAY);
-
-		  if( xStatus == pdPASS )
-		  {
-			#ifdef DEBUG_TONE_SCHED
-			  vPrintStringAndNumber("  Buf rel addr ", (uint32_t) completeMessage.firstSample);
-			#endif
-			//DMA request completed, release buffer
-			ReleaseBuffer(completeMessage.firstSample);
-		  }
-		}
+    return pdFAIL;
   }
+  return xQueueSendToBackFromISR( xQueueDMARequest, &dmaReq, woken );
 }
 
-void ReleaseBuffer(DAC_Sample *buf_ptr)
+//=============================================================================
+// ToneSequencePlay() - play a dial string as a series of timed DMA programs
+//=============================================================================
+/* Each digit becomes its tone table looped for onMs followed by offMs of
+ * midscale, linked into descriptor chains handed to the DAC with
+ * DAC_FLAG_CHAIN.  The DAC sample clock paces every segment, so the
+ * timing is exact to the sample and nothing runs between digits; only
+ * the end of each chain interrupts.  Unknown symbols are skipped.
+ *
+ * A digit takes 14 to 28 descriptors, so a long string does not fit the
+ * LLI pool at once.  It is queued TONE_SEQ_SEGMENT digits at a time, or
+ * fewer when the pool runs short, and the DAC plays each program straight
+ * after the one before.  When no descriptor is left the caller sleeps and
+ * tries again as the programs already played hand theirs back, so this
+ * returns once the last segment is queued.
+ *
+ * Returns pdFAIL if a digit still gets no descriptors after every earlier
+ * segment has played, or the DAC queue stays full.  The digits queued
+ * before it still play.
+ */
+portBASE_TYPE ToneSequencePlay(const char *digits, uint32_t count, uint32_t onMs, uint32_t offMs)
 {
-  uint8_t buf = 0;
-  BUF_AVAIL_TYPE buf_found = BUF_NOT_AVAIL;
-
-  for(buf = 0; buf < NUM_TONE_BUFFERS; buf++)
+  static DAC_Sample silence = DAC_SAMPLE(DAC_MIDSCALE);
+  DAC_Setup_Message dmaReq;
+  DMA_LinkedList *head;
+  DMA_LinkedList *tail;
+  DMA_LinkedList *last;
+  uint32_t onSamples = onMs * (DAC_SAMPLE_PER_SECOND / 1000);
+  uint32_t offSamples = offMs * (DAC_SAMPLE_PER_SECOND / 1000);
+  TickType_t digitTicks = (onMs + offMs) / portTICK_RATE_MS + 1;
+  TickType_t playingUntil = xTaskGetTickCount();
+  TickType_t now;
+  uint32_t segment;
+  uint32_t i = 0;
+  int idx;
+
+  while(i < count)
   {
-    if(sampleBuf[buf] == buf_ptr)
+    head = NULL;
+    tail = NULL;
+    segment = 0;
+    while(i < count && segment < TONE_SEQ_SEGMENT)
+    {
+      idx = ToneTableIndex(digits[i]);
+      if(idx < 0)
+      {
+        i++;
+        continue;
+      }
+
+      last = tail;
+      tail = DAC_ChainAppend(&head, last, toneTableStart[idx], toneTableInfo[idx].length, 1, onSamples);
+      if(tail != NULL)
+      {
+        tail = DAC_ChainAppend(&head, tail, &silence, 0, 0, offSamples);
+      }
+      if(tail == NULL)
+      {
+        //Pool ran short, hand this digit back and play what fits
+        if(last == NULL)
+        {
+          DMA_ReleaseChain(head);
+          head = NULL;
+        }
+        else
+        {
+          DMA_ReleaseChain((DMA_LinkedList *)last->NextLinkedList);
+          last->NextLinkedList = 0;
+        }
+        tail = last;
+        break;
+      }
+      segment++;
+      i++;
+    }
+
+    if(head == NULL)
+    {
+      if(i >= count)
+      {
+        break;
+      }
+      //Nothing fits until an earlier segment has played, a segment still
+      //queued keeps the DAC busy while this sleeps
+      if((int32_t)(xTaskGetTickCount() - playingUntil) > (int32_t)digitTicks)
+      {
+        LOG_ERROR("Dial sequence out of LLIs at %lu of %lu\n", i, count);
+        return pdFAIL;
+      }
+      vTaskDelay(digitTicks / 4 + 1);
+      continue;
+    }
+
+    //Only the end of the program interrupts
+    tail->control |= (1UL << 31);
+
+    dmaReq.firstSample = NULL;
+    dmaReq.numberSamples = 0;
+    dmaReq.flags = DAC_FLAG_CHAIN;
+    dmaReq.ringCount = 0;
+    dmaReq.index = DAC_INDEX_NONE;
+    dmaReq.chain = head;
+
+    if(xQueueSendToBack( xQueueDMARequest, &dmaReq, digitTicks * TONE_SEQ_SEGMENT ) != pdPASS)
+    {
+      LOG_ERROR("Failed to send DMA request\n");
+      DMA_ReleaseChain(head);
+      return pdFAIL;
+    }
+
+    //The DAC takes the segments in turn
+    now = xTaskGetTickCount();
+    if((int32_t)(playingUntil - now) < 0)
     {
-      bufInUse[buf] = 0;
-      buf_found = BUF_AVAIL;
+      playingUntil = now;
     }
+    playingUntil += segment * digitTicks;
+  }
+  return pdPASS;
+}
+#endif
+
+void FillAndSendFreeBuffers(char btn)
+{
+  int buf;
+
+  while( (buf = ToneBufferAcquire(&toneBufferPool)) >= 0 )
+  {
+    #ifdef DEBUG_TONE_SCHED
+      LOG_INFO("  NewBuf %lu\n", buf);
+    #endif
+    FillBuffer(btn, (uint8_t)buf);
+    SendSamplesToDMA((uint8_t)buf);
+  }
+}
+
+void FillBuffer(char btn, uint8_t buf)
+{
+  dtmfGen(btn, ToneBufferGet(&toneBufferPool, buf), toneBufferPool.size);
+}
+
+
+void SendSamplesToDMA(uint8_t buf)
+{
+  portBASE_TYPE xStatus;
+  DAC_Setup_Message dmaReq;
+
+  dmaReq.firstSample = ToneBufferGet(&toneBufferPool, buf);
+  dmaReq.numberSamples = toneBufferPool.size;
+  dmaReq.flags = 0;
+  dmaReq.ringCount = 0;
+  dmaReq.index = buf;
+  dmaReq.chain = NULL;
+  xStatus = xQueueSendToBack( xQueueDMARequest, &dmaReq, 0 );
+
+  if(xStatus != pdPASS)
+  {
+    LOG_ERROR("Failed to send DMA request\n");
+    ReleaseBuffer(buf);
   }
+}
 
-  if(buf_found == BUF_NOT_AVAIL)
+void ReleaseBuffer(uint32_t index)
+{
+  if(index >= toneBufferPool.count)
   {
-    vPrintStringAndNumber( "Unable to free buffer at address ", (uint32_t) buf_ptr);
+    LOG_ERROR("Unable to free buffer %lu\n", index);
+    return;
   }
+  ToneBufferRelease(&toneBufferPool, (uint8_t)index);
 }
 
-void cb_init(circular_buffer *cb, DAC_Sample *bfr, uint32_t capacity)
+//=============================================================================
+// Tone buffer pool
+//
+// The free buffers are kept as a stack of indices, so acquire and
+// release are a single push or pop.  The pool is only touched by the
+// tone generator task and needs no locking.
+//=============================================================================
+void ToneBufferPoolInit(TONE_BUFFER_POOL *pool, DAC_Sample *base, uint8_t count, uint32_t size)
 {
-  cb->buffer_start = &bfr[0];
-  cb->buffer_end = &bfr[capacity];
-  cb->head = &bfr[0];
-  cb->tail = &bfr[0];
-  cb->count = 0;
-  cb->capacity = capacity;
+  uint8_t i;
+
+  configASSERT( count <= TONE_POOL_MAX_BUFFERS );
+  pool->base = base;
+  pool->size = size;
+  pool->count = count;
+  pool->freeCount = count;
+  pool->minFree = count;
+  for(i = 0; i < count; i++)
+  {
+    pool->freeList[i] = count - 1 - i;
+  }
 }
 
-void cb_push_back(DAC_Sample *item, circular_buffer *cb)
+int ToneBufferAcquire(TONE_BUFFER_POOL *pool)
 {
-  // wait for room in buffer to add more values
-  while( cb->count >= cb->capacity )
+  if(pool->freeCount == 0)
+  {
+    return -1;
+  }
+  pool->freeCount--;
+  if(pool->freeCount < pool->minFree)
   {
-    // vTaskSuspend(NULL);
-  };
-  // place value in buffer
-  *cb->head = *item;
-  // bump pointer
-  cb->head++;
-  // wrap check
-  if (cb->head == cb->buffer_end) cb->head = cb->buffer_start;
-  cb->count++;
+    pool->minFree = pool->freeCount;
+  }
+  return pool->freeList[pool->freeCount];
+}
+
+void ToneBufferRelease(TONE_BUFFER_POOL *pool, uint8_t index)
+{
+  configASSERT( pool->freeCount < pool->count );
+  pool->freeList[pool->freeCount++] = index;
+}
+
+//=============================================================================
+// ToneOscInit() - set up an oscillator at freq Hz, starting at phase 0
+//=============================================================================
+void ToneOscInit(TONE_OSC *osc, float freq, int32_t amplitude)
+{
+  osc->phase = 0;
+  osc->step = (uint32_t)(freq * (4294967296.0f / DAC_SAMPLE_PER_SECOND));
+  osc->amplitude = amplitude;
 }
 
-void cb_pop_front(circular_buffer *cb, DAC_Sample *item)
+//=============================================================================
+// ToneGenBlock() - write the sum of the oscillators as DAC register words
+//
+// Each pass is a straight loop with no branches and no per-sample
+// bookkeeping.  The sums are built in place in dst and turned into
+// DACR words by a last pass.  The caller keeps offset plus the sum
+// of the amplitudes within 0..MAX_AMPLITUDE.
+//=============================================================================
+void ToneGenBlock(TONE_OSC *osc, uint32_t numOsc, int32_t offset, DAC_Sample *dst, uint32_t count)
 {
-  *item = *cb->head;
-  cb->tail++;
-  if (cb->tail == cb->buffer_end) cb->tail = cb->buffer_start;
-  cb->count--;
+  int32_t *acc = (int32_t *)dst;
+  uint32_t i;
+  uint32_t k;
+
+  for(i = 0; i < count; i++)
+  {
+    acc[i] = offset;
+  }
+
+  for(k = 0; k < numOsc; k++)
+  {
+    uint32_t phase = osc[k].phase;
+    uint32_t step = osc[k].step;
+    int32_t amp = osc[k].amplitude;
+
+    // Top 8 bits of the phase index the table, next 8 interpolate
+    for(i = 0; i < count; i++)
+    {
+      uint32_t idx = phase >> 24;
+      int32_t frac = (phase >> 16) & 0xFF;
+      int32_t s0 = sine_lut_q15[idx];
+      int32_t s = s0 + (((sine_lut_q15[idx + 1] - s0) * frac) >> 8);
+      acc[i] += (s * amp) >> 15;
+      phase += step;
+    }
+    osc[k].phase = phase;
+  }
+
+  for(i = 0; i < count; i++)
+  {
+    dst[i] = (DAC_Sample)acc[i] << DAC_VALUE_SHIFT;
+  }
 }
 
 //=============================================================================
 // dtmfGen() function
 //=============================================================================
-void dtmfGen(char btn, circular_buffer *cb)
+void dtmfGen(char btn, DAC_Sample *dst, uint32_t count)
+{
+  static TONE_OSC osc[2];
+  static char oscBtn = 0;
+  float freqA = 0;
+  float freqB = 0;
+
+  // Oscillators restart only on a new key, so a held key stays phase
+  // continuous from one buffer to the next
+  if(btn != oscBtn)
+  {
+    switch (btn)
+    {
+      case '1':
+        freqA = ROW_0_FREQ;
+        freqB = COL_0_FREQ;
+        break;
+
+      case '2':
+        freqA = ROW_0_FREQ;
+        freqB = COL_1_FREQ;
+        break;
+
+      case '3':
+        freqA = ROW_0_FREQ;
+        freqB = COL_2_FREQ;
+        break;
+
+      case 'A':
+        freqA = ROW_0_FREQ;
+        freqB = COL_3_FREQ;
+        break;
+
+      case '4':
+        freqA = ROW_1_FREQ;
+        freqB = COL_0_FREQ;
+        break;
+
+      case '5':
+        freqA = ROW_1_FREQ;
+        freqB = COL_1_FREQ;
+        break;
+
+      case '6':
+        freqA = ROW_1_FREQ;
+        freqB = COL_2_FREQ;
+        break;
+
+      case 'B':
+        freqA = ROW_1_FREQ;
+        freqB = COL_3_FREQ;
+        break;
+
+      case '7':
+        freqA = ROW_2_FREQ;
+        freqB = COL_0_FREQ;
+        break;
+
+      case '8':
+        freqA = ROW_2_FREQ;
+        freqB = COL_1_FREQ;
+        break;
+
+      case '9':
+        freqA = ROW_2_FREQ;
+        freqB = COL_2_FREQ;
+        break;
+
+      case 'C':
+        freqA = ROW_2_FREQ;
+        freqB = COL_3_FREQ;
+        break;
+
+      case '*':
+        freqA = ROW_3_FREQ;
+        freqB = COL_0_FREQ;
+        break;
+
+      case '0':
+        freqA = ROW_3_FREQ;
+        freqB = COL_1_FREQ;
+        break;
+
+      case '#':
+        freqA = ROW_3_FREQ;
+        freqB = COL_2_FREQ;
+        break;
+
+      case 'D':
+        freqA = ROW_3_FREQ;
+        freqB = COL_3_FREQ;
+        break;
+
+      default:
+        break;
+    }
+
+    ToneOscInit(&osc[0], freqA, DTMF_AMPLITUDE);
+    ToneOscInit(&osc[1], freqB, DTMF_AMPLITUDE);
+    oscBtn = btn;
+  }
+
+  ToneGenBlock(osc, 2, DAC_MIDSCALE, dst, count);
+#ifdef DEBUG_TONE_SAMPLE
+  {
+      LOG_INFO("  New sample val: %lu\n", DAC_SAMPLE_VALUE(dst[0]));
+  }
+#endif
+}
+
+#ifdef TONEGEN_BENCHMARK
+/* Copy of the previous generator, kept to benchmark against: float
+ * sin_aft() per tone and per sample, stored as a bitfield sample and
+ * pushed through circular buffer bookkeeping one element at a time.
+ */
+typedef struct
 {
-  float freqA;
-  float freqB;
-  unsigned int num_back_fill;
+  uint32_t RESERVED_SET_ZERO:6;
+  uint32_t Value:10;
+  uint32_t Bias:1;
+  uint32_t RESERVED_SET_ZERO_2:15;
+} BENCH_SAMPLE;
+
+static void BenchReferenceGen(float freqA, float freqB, BENCH_SAMPLE *bfr, uint32_t capacity, uint32_t *t)
+{
+  BENCH_SAMPLE sample = { 0, 0, 0, 0 };
+  BENCH_SAMPLE *head = bfr;
+  uint32_t count = 0;
   uint32_t i;
-  uint16_t value;
-  DAC_Sample sample;
-  sample.Bias = 0;
-  sample.RESERVED_SET_ZERO = 0;
-  sample.RESERVED_SET_ZERO_2 = 0;
   float amp = MAX_AMPLITUDE/4;
   float offset = MAX_AMPLITUDE/2+1;
 
-  switch (btn)
+  for(i=0; i<capacity; i++)
   {
-    case '1':
-      freqA = ROW_0_FREQ;
-      freqB = COL_0_FREQ;
-      break;
-
-    case '2':
-      freqA = ROW_0_FREQ;
-      freqB = COL_1_FREQ;
-      break;
-
-    case '3':
-      freqA = ROW_0_FREQ;
-      freqB = COL_2_FREQ;
-      break;
-
-    case 'A':
-      freqA = ROW_0_FREQ;
-      freqB = COL_3_FREQ;
-      break;
-
-    case '4':
-      freqA = ROW_1_FREQ;
-      freqB = COL_0_FREQ;
-      break;
-
-    case '5':
-      freqA = ROW_1_FREQ;
-      freqB = COL_1_FREQ;
-      break;
-
-    case '6':
-      freqA = ROW_1_FREQ;
-      freqB = COL_2_FREQ;
-      break;
-
-    case 'B':
-      freqA = ROW_1_FREQ;
-      freqB = COL_3_FREQ;
-      break;
-
-    case '7':
-      freqA = ROW_2_FREQ;
-      freqB = COL_0_FREQ;
-      break;
-
-    case '8':
-      freqA = ROW_2_FREQ;
-      freqB = COL_1_FREQ;
-      break;
-
-    case '9':
-      freqA = ROW_2_FREQ;
-      freqB = COL_2_FREQ;
-      break;
-
-    case 'C':
-      freqA = ROW_2_FREQ;
-      freqB = COL_3_FREQ;
-      break;
-
-    case '*':
-      freqA = ROW_3_FREQ;
-      freqB = COL_0_FREQ;
-      break;
-
-    case '0':
-      freqA = ROW_3_FREQ;
-      freqB = COL_1_FREQ;
-      break;
-
-    case '#':
-      freqA = ROW_3_FREQ;
-      freqB = COL_2_FREQ;
-      break;
-
-    case 'D':
-      freqA = ROW_3_FREQ;
-      freqB = COL_3_FREQ;
-      break;
-
-    default:
-      break;
+    sample.Value = (uint16_t)(offset + sin_aft(amp, freqA, *t)+ sin_aft(amp, freqB, *t));
+    while( count >= capacity )
+    {
+    }
+    *head = sample;
+    head++;
+    if (head == bfr + capacity) head = bfr;
+    count++;
+    (*t)++;
+    if (*t>DAC_SAMPLE_PER_SECOND) *t = 0;
   }
+}
+
+/* Benchmark Task Comparing the Reference and Block Tone Generators.
+ * Uses sampleBuf[0] as scratch, so run it with the keypad idle.
+ */
+void vTaskToneGenBenchmark( void *pvParameters )
+{
+  const uint32_t samples = TONE_BENCH_BLOCKS * TONE_BUFFER_SIZE;
+  uint32_t t = 0;
+  uint32_t block;
+  uint32_t start;
+  uint32_t refCycles;
+  uint32_t newCycles;
+  TONE_OSC osc[2];
+
+  CycleCounterInit();
 
-  // keep filling buffer until end
-  for(i=0; i<cb->capacity; i++)
+  for( ;; )
   {
-    //value = (uint16_t)(offset + sin_aft(amp, 100, t));
-    value = (uint16_t)(offset + sin_aft(amp, freqA, t)+ sin_aft(amp, freqB, t));
-    sample.Value = value;
-    cb_push_back(&sample, cb);
-    t++;
-    if (t>DAC_SAMPLE_PER_SECOND) t = 0;
-#ifdef DEBUG_TONE_SAMPLE
+    start = CycleCounterGet();
+    for(block = 0; block < TONE_BENCH_BLOCKS; block++)
     {
-        vPrintStringAndNumber("  New sample val:  ", value);
+      BenchReferenceGen(ROW_0_FREQ, COL_0_FREQ, (BENCH_SAMPLE *)sampleBuf[0], TONE_BUFFER_SIZE, &t);
     }
-#endif
+    refCycles = CycleCounterGet() - start;
+
+    ToneOscInit(&osc[0], ROW_0_FREQ, DTMF_AMPLITUDE);
+    ToneOscInit(&osc[1], COL_0_FREQ, DTMF_AMPLITUDE);
+    start = CycleCounterGet();
+    for(block = 0; block < TONE_BENCH_BLOCKS; block++)
+    {
+      ToneGenBlock(osc, 2, DAC_MIDSCALE, sampleBuf[0], TONE_BUFFER_SIZE);
+    }
+    newCycles = CycleCounterGet() - start;
+
+    LOG_INFO("Tone bench reference cycles/sample %lu\n", refCycles / samples);
+    LOG_INFO("Tone bench reference samples/ms %lu\n", ((uint64_t)samples * configCPU_CLOCK_HZ / 1000 / refCycles));
+    LOG_INFO("Tone bench block cycles/sample %lu\n", newCycles / samples);
+    LOG_INFO("Tone bench block samples/ms %lu\n", ((uint64_t)samples * configCPU_CLOCK_HZ / 1000 / newCycles));
+
+    vTaskDelay(2000 / portTICK_RATE_MS);
   }
 }
+#endif
 
 #ifdef TONEGEN_DMA_UNIT_TEST
 /* Unit Test Task Simulating DMA Request and DMA Transfer */
@@ -385,18 +783,30 @@ void vTaskDMAHandlerTest( void *pvParameters )
 {
   portBASE_TYPE xStatus;
   DAC_Setup_Message dmaReq;
+  DAC_Complete_Message completeMessage;
 
   for( ;; )
   {
     xStatus = xQueueReceive( xQueueDMARequest, &dmaReq, portMAX_DELAY  );
+    if(xStatus != pdPASS)
+    {
+      continue;
+    }
 
-    vPrintStringAndNumber("  DMA Transfer Starting addr ", (uint32_t) dmaReq.firstSample);
+    LOG_INFO("  DMA Transfer Starting addr %lx\n", dmaReq.firstSample);
 
     vTaskDelay(DMA_TIME_MS/portTICK_RATE_MS);
 
-    vPrintStringAndNumber("  DMA Transfer Complete addr ", (uint32_t) dmaReq.firstSample);
+    LOG_INFO("  DMA Transfer Complete addr %lx\n", dmaReq.firstSample);
 
-    xStatus = xQueueSendToBack( dacResponseHandle, &dmaReq.firstSample, 0 );
+    completeMessage.firstSample = dmaReq.firstSample;
+    completeMessage.numberSamples = dmaReq.numberSamples;
+    completeMessage.index = dmaReq.index;
+    xStatus = xQueueSendToBack( dacResponseHandle, &completeMessage, 0 );
+    if(xStatus != pdPASS)
+    {
+      LOG_ERROR("Failed to send DMA completion\n");
+    }
   }
 }
 #endif
@@ -421,13 +831,13 @@ void vTaskToneRequestTest( void *pvParameters )
       {
     	toneToSend = (on_off == TONE_OFF) ? 0 : tone;
 
-        vPrintStringAndNumber("New request Type", toneToSend);
+        LOG_INFO("New request Type %lu\n", toneToSend);
 
         xStatus = xQueueSendToBack( xQueueToneInput, &toneToSend, 0 );
 
         if( xStatus != pdPASS )
         {
-          vPrintString( "vTaskToneRequestTest:  Could not send to the queue.\r\n" );
+          LOG_ERROR("vTaskToneRequestTest:  Could not send to the queue.\n");
         }
         vTaskDelay(TONE_TIME_MS/portTICK_RATE_MS);
       }
@@ -6,17 +6,38 @@
 #include "dac.h"
 
 #define MAX_AMPLITUDE       1023    //
+#define DTMF_AMPLITUDE      (MAX_AMPLITUDE/4)   // peak of each tone of a pair
+#define DAC_MIDSCALE        (MAX_AMPLITUDE/2+1) // level the tones swing around
 #define SILENCE_LENGTH      (.1*DAC_SAMPLE_PER_SECOND) // silence gen after each tone in samples
 #define TWO_PI (3.14159 * 2)
 
+/* Tone Playback */
+#define TONEGEN_USE_TONE_TABLES      //CONFIGURABLE - Loop precomputed tables via DMA instead of refilling buffers
+
+/* Tone Table Definitions */
+#define NUM_DTMF_TONES      16
+#define TONE_TABLE_SAMPLES  3168     // Sum of the lengths in toneTableInfo[]
+
+/* Set in a tone request whose DAC transfer the keypad interrupt has
+ * already queued (keypad.h, KEYPAD_FAST_TONE); the task only keeps its
+ * state for it */
+#define TONE_REQ_STARTED    0x80
+
+/* Dial Sequencer (ToneSequencePlay) */
+#define TONE_SEQ_ON_MS      200      //CONFIGURABLE - Tone time of each dialed digit
+#define TONE_SEQ_OFF_MS     10       //CONFIGURABLE - Silence after each dialed digit
+#define TONE_SEQ_SEGMENT    4        //CONFIGURABLE - Most digits per DMA program, two should fit the LLI pool
+
 /* Buffer Definitions */
 #define NUM_TONE_BUFFERS 3           //CONFIGURABLE - Number of Tone Buffer Sizes
 #define TONE_BUFFER_SIZE 0x100       //CONFIGURABLE - Tone Buffer Size
+#define TONE_POOL_MAX_BUFFERS 16     //Largest buffer count a TONE_BUFFER_POOL can manage
 
 /* Queue Sizes */
 #define DTMF_REQ_QUEUE_SIZE     10
 #define DMA_REQ_QUEUE_SIZE      NUM_TONE_BUFFERS
 #define DMA_COMP_QUEUE_SIZE     NUM_TONE_BUFFERS
+#define TONE_EVENT_SET_SIZE     (DTMF_REQ_QUEUE_SIZE + DMA_COMP_QUEUE_SIZE)
 
 /* Sample Timing Parameters */
 #define SEC_TO_MSEC             1000
@@ -28,6 +49,9 @@
 #define TONE_TIME_MS            SEC_TO_MSEC * TONE_PERIODS * TONE_BUFFER_SIZE / DAC_SAMPLE_PER_SECOND
 #define TONE_PERIODS            500  //CONFIGURABLE - Number of Times Tone Buffer is filled before sending new tone
 
+/* Benchmark Parameters */
+#define TONE_BENCH_BLOCKS       64   //CONFIGURABLE - Buffers generated per timed run
+
 /////////////////////////////////////////////////
 // Tone Table
 // 	      1209 Hz 	1336 Hz 	1477 Hz 	1633 Hz
@@ -47,11 +71,17 @@
 #define COL_2_FREQ  1477
 #define COL_3_FREQ  1633
 
-typedef enum
+typedef struct
 {
-	BUF_NOT_AVAIL,
-	BUF_AVAIL
-} BUF_AVAIL_TYPE;
+  DAC_Sample *base;                           // count buffers of size samples, back to back
+  uint32_t size;                              // samples per buffer
+  uint8_t  count;                             // buffers in the pool
+  uint8_t  freeCount;                         // entries in freeList
+  uint8_t  minFree;                           // lowest freeCount seen, for sizing NUM_TONE_BUFFERS
+  uint8_t  freeList[TONE_POOL_MAX_BUFFERS];   // indices of the free buffers
+} TONE_BUFFER_POOL;
+
+#define ToneBufferGet(pool, index)  ((pool)->base + (uint32_t)(index) * (pool)->size)
 
 typedef enum
 {
@@ -62,28 +92,49 @@ typedef enum
 
 typedef struct
 {
-  DAC_Sample *buffer_start; // start of data buffer
-  DAC_Sample *buffer_end;   // end of data buffer
-  DAC_Sample *head;         // pointer to head
-  DAC_Sample *tail;         // pointer to tail
-  uint32_t capacity;      // maximum number of items in the buffer
-  uint32_t count;         // number of items in the buffer
-} circular_buffer;
-
-void dtmfGen(char btn, circular_buffer *cb);
-void cb_init(circular_buffer *cb, DAC_Sample *bfr, uint32_t capacity);
-void cb_free(circular_buffer *cb);
-void cb_push_back(DAC_Sample *item, circular_buffer *cb);
-void cb_pop_front(circular_buffer *cb, DAC_Sample *item);
-void FillBuffer(char btn, uint8_t *activeBuffer);
-void SendSamplesToDMA(uint8_t *activeBuffer);
-void GetNextAvailableBuffer(uint8_t *activeBuffer);
-void ReleaseBuffer(DAC_Sample *buf_ptr);
+  char     btn;            // keypad symbol
+  uint16_t length;         // samples in the table, at most TONE_BUFFER_SIZE
+  uint8_t  cyclesRow;      // whole cycles of the row tone in the table
+  uint8_t  cyclesCol;      // whole cycles of the column tone in the table
+} TONE_TABLE_INFO;
+
+typedef struct
+{
+  uint32_t phase;          // current phase, 2^32 is one cycle
+  uint32_t step;           // phase advance per sample
+  int32_t  amplitude;      // peak in DAC counts
+} TONE_OSC;
+
+void ToneTableInit(void);
+int ToneTableIndex(char btn);
+void PlayToneTable(char btn);
+portBASE_TYPE PlayToneTableFromISR(char btn, portBASE_TYPE *woken);
+portBASE_TYPE ToneSequencePlay(const char *digits, uint32_t count, uint32_t onMs, uint32_t offMs);
+void ToneOscInit(TONE_OSC *osc, float freq, int32_t amplitude);
+void ToneGenBlock(TONE_OSC *osc, uint32_t numOsc, int32_t offset, DAC_Sample *dst, uint32_t count);
+void dtmfGen(char btn, DAC_Sample *dst, uint32_t count);
+void FillAndSendFreeBuffers(char btn);
+void FillBuffer(char btn, uint8_t buf);
+void SendSamplesToDMA(uint8_t buf);
+void ReleaseBuffer(uint32_t index);
+void ToneBufferPoolInit(TONE_BUFFER_POOL *pool, DAC_Sample *base, uint8_t count, uint32_t size);
+int ToneBufferAcquire(TONE_BUFFER_POOL *pool);
+void ToneBufferRelease(TONE_BUFFER_POOL *pool, uint8_t index);
+
+/* Tone Buffer Pool (minFree reports the worst case seen) */
+extern TONE_BUFFER_POOL toneBufferPool;
+
+#ifdef TONEGEN_USE_TONE_TABLES
+/* Tone tables of every key, built by ToneTableInit() */
+extern const TONE_TABLE_INFO toneTableInfo[NUM_DTMF_TONES];
+extern DAC_Sample *toneTableStart[NUM_DTMF_TONES];
+#endif
 /* Tone Generator Tasks */
 void vTaskToneGenerator( void *pvParameters );
 /* Unit Test Tasks */
 void vTaskToneRequestTest( void *pvParameters );
 void vTaskDMAHandlerTest( void *pvParameters );
+void vTaskToneGenBenchmark( void *pvParameters );
 
 #endif
 
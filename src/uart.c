@@ -5,20 +5,109 @@
  *      Author: Chris
  */
 #include "uart.h"
+#include "task.h"
+#include "stream_buffer.h"
+#if UART_TX_DMA
+#include "dma.h"
+#endif
+#if UART_CPU_STATS
+#include "cyclecount.h"
+#endif
+
+#if (UART_TX_RING_SIZE & (UART_TX_RING_SIZE - 1))
+#error UART_TX_RING_SIZE must be a power of two
+#endif
+#if UART_TX_RING_SIZE > 0x800000
+#error UART_TX_RING_SIZE must fit the 24 bit TX positions
+#endif
+#if UART_TX_DMA && (UART_TX_DMA_SEGMENTS & (UART_TX_DMA_SEGMENTS - 1))
+#error UART_TX_DMA_SEGMENTS must be a power of two
+#endif
 
 //uart variables - global to the file
-static char send_buffer[UART_SEND_LENGTH];
-static char recv_buffer[UART_RECV_LENGTH];
-static int send_buffer_index = 0;
-static int recv_buffer_index = 0;
-static int send_buffer_length = 0;
-static int recv_buffer_length = 0;
-static SemaphoreHandle_t rxHandleSem;
-static SemaphoreHandle_t txHandleSem;
+//
+//Received bytes go through a kernel stream buffer, which has the one
+//writer (the ISR) and one reader (the rx handler) it needs to do without
+//locks, and copies them in and out in blocks.
+//
+//The TX ring uses free running head/tail counts, masked on access, and
+//takes messages from any number of producers without a lock, which a
+//stream buffer's single writer would not allow. A producer reserves
+//space by moving tx_reserve with LDREX/STREX; that word packs the
+//reserve position (low 24 bits) with the number of producers still
+//copying into their space (top 8 bits), so whichever producer finishes
+//last publishes everybody's bytes to the transmitter by advancing
+//tx_head. TX positions are taken modulo 2^24.
+#if UART_TX_DMA
+static uint8_t tx_ring[UART_TX_RING_SIZE] DMA_BUFFER;
+#else
+static uint8_t tx_ring[UART_TX_RING_SIZE];
+#endif
+static volatile uint32_t tx_reserve = 0;    //reserved by senders, and writers
+static volatile uint32_t tx_head = 0;       //published by senders
+static volatile uint32_t tx_tail = 0;       //written by the ISR
+static volatile uint8_t tx_idle = 1;        //FIFO empty, nothing pending
+static volatile uint8_t tx_waiting = 0;     //a sender waits for space
+
+#define UART_TX_POS_MASK 0x00FFFFFFUL
+#define UART_TX_WRITER   0x01000000UL
+#define UART_TX_COUNT(to,from) (((to) - (from)) & UART_TX_POS_MASK)
+#define UART_TX_FREE() (UART_TX_RING_SIZE - UART_TX_COUNT(tx_reserve, tx_tail))
+
+#if UART_TX_DMA
+//DMA segment queue, free running counts like the rings:
+//seg_head - oldest segment not yet done (the DMA ISR)
+//seg_linked - end of the segments the channel will reach on its own
+//seg_tail - next free slot (senders, with the DMA interrupt masked)
+//Segments between seg_linked and seg_tail were linked on after the
+//channel had already loaded the last item; the ISR restarts it there.
+static DMA_LinkedList tx_seg_lli[UART_TX_DMA_SEGMENTS] DMA_BUFFER __attribute__ ((aligned(4)));
+static uart_dma_done_t tx_seg_done[UART_TX_DMA_SEGMENTS];
+static void* tx_seg_arg[UART_TX_DMA_SEGMENTS];
+static volatile uint32_t tx_seg_head = 0;
+static volatile uint32_t tx_seg_linked = 0;
+static volatile uint32_t tx_seg_tail = 0;
+volatile uint32_t uart_dma_errors = 0;
+
+#define UART_DMA_CH ((LPC_GPDMACH_TypeDef *)(LPC_GPDMACH0_BASE + UART_TX_DMA_CHANNEL * 0x20))
+#define UART_DMA_BIT (1UL << UART_TX_DMA_CHANNEL)
+#define UART_DMA_SLOT(n) ((n) & (UART_TX_DMA_SEGMENTS - 1))
+
+//enable, destination UART2 Tx (request 12), memory to peripheral,
+//error and terminal count interrupts unmasked
+#define UART_DMA_CONFIG (1UL | (12UL << 6) | (1UL << 11) | (1UL << 14) | (1UL << 15))
+//byte wide, single transfers, source increment, terminal count interrupt
+#define UART_DMA_CONTROL(len) ((uint32_t)(len) | (1UL << 26) | (1UL << 31))
+
+static void uart_dma_init(void);
+static void uart_ring_kick(void);
+#endif
+
+static uint8_t rx_storage[UART_RX_RING_SIZE + 1];
+static StaticStreamBuffer_t rx_stream_buffer;
+static StreamBufferHandle_t rx_stream;
+
+//command lines are assembled in place in buffers from a message pool
+//and passed to the consumer by reference (msgpool.h)
+MSG_POOL_DEFINE(uart_cmd_pool, uart_command_t, UART_CMD_BUFFERS);
+static QueueHandle_t cmd_queue = NULL;
+
+//the rx handler task, woken by direct notification; NULL until it runs
+static TaskHandle_t rx_task = NULL;
+
+static SemaphoreHandle_t txSpaceSem;
 static SemaphoreHandle_t transmit_mutex;
-static SemaphoreHandle_t receive_mutex;
-static QueueHandle_t* recv_queue = NULL;
-static char autodial_char = '+';
+static StaticSemaphore_t txSpaceSemBuffer;
+static StaticSemaphore_t transmit_mutex_buffer;
+
+volatile uint32_t uart_rx_overruns = 0;
+volatile uint32_t uart_cmd_rejected = 0;
+volatile uint32_t uart_tx_dropped = 0;
+volatile uint32_t uart_tx_high_water = 0;
+#if UART_CPU_STATS
+volatile uint32_t uart_isr_cycles = 0;
+volatile uint32_t uart_isr_bytes = 0;
+#endif
 
 //current baud rate is 12195
 
@@ -27,7 +116,6 @@ void uart_configure()
 	//disable interrupt while configuring
 	NVIC_DisableIRQ(UART2_IRQn);
 
-	//set up FIFO - enable fifo, clean fifos, no DMA, trigger on 1 char
     LPC_SC->PCONP |= (1 << 24);
     LPC_SC->PCLKSEL1 |= 0x10000;
 
@@ -45,7 +133,14 @@ void uart_configure()
 	//disable brg register r/w (enable ier register r/w)
 	LPC_UART2->LCR &= ~0x80;
 
-    LPC_UART2->FCR = 0x07;
+	//set up FIFO - enable fifo, clean fifos, interrupt at UART_RX_TRIGGER
+	//characters (a character timeout interrupt picks up any fewer), DMA
+	//requests when the transmitter is fed by the GPDMA
+#if UART_TX_DMA
+    LPC_UART2->FCR = 0x0f | (UART_RX_TRIGGER << 6);
+#else
+    LPC_UART2->FCR = 0x07 | (UART_RX_TRIGGER << 6);
+#endif
 
 	//set pins to UART2
 	//TX = P2.8
@@ -54,13 +149,25 @@ void uart_configure()
 	LPC_PINCON->PINMODE4 |= 0xa0000;
 
 	//create semaphores for task handoff
-	rxHandleSem = xSemaphoreCreateBinary();
-	txHandleSem = xSemaphoreCreateBinary();
-	receive_mutex = xSemaphoreCreateMutex();
-	transmit_mutex = xSemaphoreCreateMutex();
+	txSpaceSem = xSemaphoreCreateBinaryStatic(&txSpaceSemBuffer);
+	transmit_mutex = xSemaphoreCreateMutexStatic(&transmit_mutex_buffer);
+
+	//every command buffer starts out free
+	MsgPoolInit(&uart_cmd_pool);
+
+	//the parser is woken once UART_RX_WAKE_LEVEL bytes are waiting,
+	//or by the ISR at the end of a line
+	rx_stream = xStreamBufferCreateStatic(UART_RX_RING_SIZE,UART_RX_WAKE_LEVEL,rx_storage,&rx_stream_buffer);
+
+#if UART_TX_DMA
+	uart_dma_init();
 
+	//enable rx interrupts, the DMA interrupt drives tx
+	LPC_UART2->IER = 0x01;
+#else
 	//enable rx and tx interrupts
 	LPC_UART2->IER = 0x03;
+#endif
 
 	NVIC_SetPriority(UART2_IRQn,10);
 	NVIC_EnableIRQ(UART2_IRQn);
@@ -68,203 +175,506 @@ void uart_configure()
 	NVIC_ClearPendingIRQ(UART2_IRQn);
 }
 
-//attempts to take mutex, waits until that happens
-void uart_send_block(char* buf, int length)
+#if UART_TX_DMA
+//Claims the channel and routes its interrupt here
+static void uart_dma_isr(portBASE_TYPE* woken);
+
+static void uart_dma_init(void)
 {
-	xSemaphoreTake(transmit_mutex,portMAX_DELAY);
-	_uart_send(buf,length);
+	DMA_Initialize();
+	UART_DMA_CH->DMACCConfig = 0;
+	LPC_GPDMA->DMACIntTCClear = UART_DMA_BIT;
+	LPC_GPDMA->DMACIntErrClr = UART_DMA_BIT;
+
+	//request line 12 is UART2 Tx rather than a timer match
+	LPC_SC->DMAREQSEL &= ~(1UL << 4);
+	DMA_RegisterHandler(UART_TX_DMA_CHANNEL, uart_dma_isr);
 }
 
-//attempts to take mutex, returns immediately if send fails
-int uart_send_noblock(char* buf, int length)
+//Loads the channel with a segment and everything linked after it,
+//with the DMA interrupt masked
+static void uart_dma_start(uint32_t slot)
 {
-	if( pdPASS == xSemaphoreTake(transmit_mutex,0))
+	DMA_LinkedList* lli = &tx_seg_lli[slot];
+
+	UART_DMA_CH->DMACCSrcAddr = lli->Src;
+	UART_DMA_CH->DMACCDestAddr = lli->Destination;
+	UART_DMA_CH->DMACCLLI = lli->NextLinkedList;
+	UART_DMA_CH->DMACCControl = lli->control;
+	UART_DMA_CH->DMACCConfig = UART_DMA_CONFIG;
+}
+
+int uart_dma_send(const char* buf, int length, uart_dma_done_t done, void* arg)
+{
+	UBaseType_t mask;
+	uint32_t tail;
+	uint32_t slot;
+	DMA_LinkedList* lli;
+	int result = -1;
+
+	if( length <= 0 || length > UART_TX_DMA_MAX )
 	{
-		_uart_send(buf,length);
-		return 0;
+		return -1;
+	}
+
+	mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	tail = tx_seg_tail;
+	if( tail - tx_seg_head < UART_TX_DMA_SEGMENTS )
+	{
+		slot = UART_DMA_SLOT(tail);
+		lli = &tx_seg_lli[slot];
+		lli->Src = (uint32_t)buf;
+		lli->Destination = (uint32_t)&LPC_UART2->THR;
+		lli->NextLinkedList = 0;
+		lli->control = UART_DMA_CONTROL(length);
+		tx_seg_done[slot] = done;
+		tx_seg_arg[slot] = arg;
+
+		if( tail == tx_seg_head )
+		{
+			//queue empty, the channel is idle
+			uart_dma_start(slot);
+			tx_seg_linked = tail + 1;
+		}
+		else
+		{
+			//link on behind the last segment. If the channel has not
+			//loaded that one yet (its LLI register is still set) it
+			//will follow the link, otherwise the ISR restarts it here
+			tx_seg_lli[UART_DMA_SLOT(tail - 1)].NextLinkedList = (uint32_t)lli;
+			__DSB();
+			if( tx_seg_linked == tail && (UART_DMA_CH->DMACCConfig & 1) &&
+				UART_DMA_CH->DMACCLLI != 0 )
+			{
+				tx_seg_linked = tail + 1;
+			}
+		}
+		tx_seg_tail = tail + 1;
+		result = 0;
 	}
-	return -1;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	return result;
 }
 
-// Internal send - sets the correct variables and loads the
-// first character into the buffer
-void _uart_send(char* buf, int length)
+//Terminal count (one per segment) or error on the channel. Works out
+//from the channel registers how far it got, so merged interrupts are
+//handled too, completes those segments and restarts an idle channel
+//on segments it did not reach.
+static void uart_dma_isr(portBASE_TYPE* woken)
 {
-	send_buffer_index = 0;
-	if( length <= UART_SEND_LENGTH )
+	uint32_t done_end;
+	uint32_t next;
+	uint32_t slot;
+
+	if( LPC_GPDMA->DMACIntErrStat & UART_DMA_BIT )
 	{
-		send_buffer_length = length;
+		LPC_GPDMA->DMACIntErrClr = UART_DMA_BIT;
+		uart_dma_errors++;
 	}
-	else if(length <= 0)
+	LPC_GPDMA->DMACIntTCClear = UART_DMA_BIT;
+
+	if( UART_DMA_CH->DMACCConfig & 1 )
 	{
-#if UART_DEBUG
-		printf("Warning - length set to 0, not sending data\n");
-#endif
-		return;
+		//the segment before the one the LLI register points at is
+		//still running, or the last reachable one if that is 0
+		next = UART_DMA_CH->DMACCLLI;
+		if( next == 0 )
+		{
+			done_end = tx_seg_linked - 1;
+		}
+		else
+		{
+			slot = ((DMA_LinkedList*)next) - tx_seg_lli;
+			done_end = tx_seg_head + UART_DMA_SLOT(slot - tx_seg_head) - 1;
+		}
 	}
 	else
 	{
-		send_buffer_length = UART_SEND_LENGTH;
-#if UART_DEBUG
-		printf("Warning - truncating uart_send data to %i bytes\n",UART_SEND_LENGTH);
-#endif
+		done_end = tx_seg_linked;
 	}
-	memcpy(send_buffer,buf,sizeof(send_buffer));
 
-	LPC_UART2->THR = send_buffer[send_buffer_index];
+	while( tx_seg_head != done_end )
+	{
+		slot = UART_DMA_SLOT(tx_seg_head);
+		tx_seg_head++;
+		if( tx_seg_done[slot] )
+		{
+			tx_seg_done[slot](tx_seg_arg[slot], woken);
+		}
+	}
+
+	if( !(UART_DMA_CH->DMACCConfig & 1) && tx_seg_head != tx_seg_tail )
+	{
+		uart_dma_start(UART_DMA_SLOT(tx_seg_head));
+		tx_seg_linked = tx_seg_tail;
+	}
 }
 
-//The LPC1769 has one interrupt for transmit and receive
-void UART2_IRQHandler()
+//A span of the TX ring has gone out, free it and send the next
+static void uart_ring_done(void* arg, portBASE_TYPE* woken)
 {
-	uint32_t interrupt_reg = LPC_UART2->IIR;
-
-	//transmit interrupt (interrupt status = 0 and transmit interrupt)
-	if( interrupt_reg & 0x2 )
+	tx_tail += (uint32_t)arg;
+	tx_idle = 1;
+	if( tx_waiting && UART_TX_FREE() >= UART_TX_WAKE_SPACE )
 	{
-		xSemaphoreGiveFromISR(txHandleSem,NULL);
+		tx_waiting = 0;
+		xSemaphoreGiveFromISR(txSpaceSem,woken);
+	}
+	uart_ring_kick();
+}
 
-		//if not use this - from example
-		portCLEAR_INTERRUPT_MASK_FROM_ISR( 0 );
+//Queues the bytes waiting in the TX ring, up to its wrap, as one
+//segment unless one is already out. Called from the DMA ISR or with
+//it masked.
+static void uart_ring_kick(void)
+{
+	uint32_t tail = tx_tail;
+	uint32_t count = UART_TX_COUNT(tx_head, tail);
+	uint32_t offset = tail & (UART_TX_RING_SIZE - 1);
 
-		//context switch
-		portEND_SWITCHING_ISR( uart_tx_handler );
+	if( !tx_idle || count == 0 )
+	{
+		return;
 	}
-	//receive interrupt (interrupt status = 0 and receive interrupt
-	else if( (interrupt_reg & 0xf) == 0x4 )
+	if( count > UART_TX_RING_SIZE - offset )
 	{
-		xSemaphoreGiveFromISR(rxHandleSem,NULL);
-
-		//if not use this - from example
-		portCLEAR_INTERRUPT_MASK_FROM_ISR( 0 );
-
-		recv_buffer[recv_buffer_index] = LPC_UART2->RBR;
+		count = UART_TX_RING_SIZE - offset;
+	}
+	if( 0 == uart_dma_send((const char*)&tx_ring[offset], count, uart_ring_done, (void*)count) )
+	{
+		tx_idle = 0;
+	}
+}
+#else
+//Moves up to a FIFO's worth of bytes from the TX ring to the UART,
+//called from the ISR or with the ISR masked. Returns bytes moved.
+static uint32_t uart_fill_fifo(void)
+{
+	uint32_t tail = tx_tail;
+	uint32_t count = UART_TX_COUNT(tx_head, tail);
+	uint32_t i;
 
-		//context switch
-		portEND_SWITCHING_ISR( uart_rx_handler );
+	if( count > UART_FIFO_DEPTH )
+	{
+		count = UART_FIFO_DEPTH;
 	}
+	for( i = 0; i < count; i++ )
+	{
+		LPC_UART2->THR = tx_ring[(tail + i) & (UART_TX_RING_SIZE - 1)];
+	}
+	tx_tail = tail + count;
+	tx_idle = (count == 0);
+	return count;
 }
+#endif
 
-//transmit handler, load next character into transmit buffer
-void uart_tx_handler()
+//Starts the transmitter if it is idle, the ISR keeps it going from
+//there. Safe from tasks and interrupts.
+static void uart_tx_start(void)
 {
-	while(1)
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+#if UART_TX_DMA
+	uart_ring_kick();
+#else
+	if( tx_idle )
 	{
-		xSemaphoreTake(txHandleSem,portMAX_DELAY);
-		send_buffer_index++;
+		uart_fill_fifo();
+	}
+#endif
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+//Moves tx_head forward to pos, unless another producer already
+//published past it
+static void uart_tx_publish(uint32_t pos)
+{
+	uint32_t head;
+	uint32_t ahead;
 
-		//not done sending
-		if( send_buffer_index < send_buffer_length )
+	do
+	{
+		head = __LDREXW((uint32_t*)&tx_head);
+		ahead = UART_TX_COUNT(pos, head);
+		if( ahead == 0 || ahead > UART_TX_RING_SIZE )
 		{
-			LPC_UART2->THR = send_buffer[send_buffer_index];
-#if UART_DEBUG
-			printf("Sending %i\n",send_buffer[send_buffer_index]);
-#endif
+			__CLREX();
+			return;
 		}
-		else
+	} while( __STREXW(pos, (uint32_t*)&tx_head) );
+
+	uart_tx_start();
+}
+
+// Internal send - reserves room for the whole message in the TX ring,
+// copies it in and publishes it. Never waits and takes no lock.
+// Returns 0, or -1 without queueing anything if the message does not
+// fit.
+int _uart_send(const char* buf, int length)
+{
+	uint32_t old;
+	uint32_t pos;
+	uint32_t used;
+	uint32_t i;
+
+	if( length <= 0 || length > UART_TX_RING_SIZE )
+	{
+		return -1;
+	}
+
+	//reserve, and count ourselves in as a writer
+	do
+	{
+		old = __LDREXW((uint32_t*)&tx_reserve);
+		pos = old & UART_TX_POS_MASK;
+		used = UART_TX_COUNT(pos, tx_tail) + length;
+		if( used > UART_TX_RING_SIZE )
 		{
-#if UART_DEBUG
-			printf("Done sending\n");
-#endif
-			//done sending, unlock transmit resource
-			xSemaphoreGive(transmit_mutex);
+			__CLREX();
+			return -1;
 		}
+	} while( __STREXW(((old & ~UART_TX_POS_MASK) + UART_TX_WRITER) |
+				((pos + length) & UART_TX_POS_MASK), (uint32_t*)&tx_reserve) );
 
+	if( used > uart_tx_high_water )
+	{
+		uart_tx_high_water = used;
 	}
-}
 
-//Set up receive queue, or pend on the receive mutex
-void uart_receive_block(int length, QueueHandle_t* queue)
-{
-	xSemaphoreTake(receive_mutex,portMAX_DELAY);
-	_uart_receive(length,queue);
-}
+	for( i = 0; i < (uint32_t)length; i++ )
+	{
+		tx_ring[(pos + i) & (UART_TX_RING_SIZE - 1)] = buf[i];
+	}
 
-//Set up receive queue or return with a failure
-int uart_receive_noblock(int length, QueueHandle_t* queue)
-{
-	if(pdPASS == xSemaphoreTake(receive_mutex,0))
+	//count ourselves out, the last writer out publishes
+	do
+	{
+		old = __LDREXW((uint32_t*)&tx_reserve) - UART_TX_WRITER;
+	} while( __STREXW(old, (uint32_t*)&tx_reserve) );
+
+	if( (old & ~UART_TX_POS_MASK) == 0 )
 	{
-		_uart_receive(length,queue);
-		return 0;
+		uart_tx_publish(old & UART_TX_POS_MASK);
 	}
-	return -1;
+	return 0;
 }
 
-//Internal receive - loads receive variables
-void _uart_receive(int length, QueueHandle_t* queue)
+//attempts to take mutex, waits until that happens, then waits for space
+//as needed. Long messages go out in pieces of UART_TX_WAKE_SPACE bytes,
+//kept together by the mutex among blocking senders.
+void uart_send_block(char* buf, int length)
 {
-	recv_buffer_index = 0;
-	recv_queue = queue;
-	memset(recv_buffer,0,sizeof(recv_buffer));
-	if( length <= UART_RECV_LENGTH )
+	int chunk;
+
+	xSemaphoreTake(transmit_mutex,portMAX_DELAY);
+	while( length > 0 )
 	{
-		recv_buffer_length = length;
+		chunk = (length > UART_TX_WAKE_SPACE) ? UART_TX_WAKE_SPACE : length;
+		if( _uart_send(buf,chunk) != 0 )
+		{
+			//woken by the ISR once UART_TX_WAKE_SPACE bytes are free
+			tx_waiting = 1;
+			if( UART_TX_FREE() < (uint32_t)chunk )
+			{
+				xSemaphoreTake(txSpaceSem,portMAX_DELAY);
+			}
+			continue;
+		}
+		buf += chunk;
+		length -= chunk;
 	}
-	else if( length <= 0 )
+	xSemaphoreGive(transmit_mutex);
+}
+
+//queues the whole message without waiting or locking, or drops it
+int uart_send_noblock(char* buf, int length)
+{
+	if( _uart_send(buf,length) != 0 )
 	{
 #if UART_DEBUG
-		printf("Warning - length set to 0, not receiving data\n");
+		printf("Warning - TX ring full, dropping %d bytes\n",length);
 #endif
-		return;
+		uart_tx_dropped++;
+		return -1;
 	}
-	else
+	return 0;
+}
+
+//The LPC1769 has one interrupt for transmit and receive
+void UART2_IRQHandler()
+{
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+	uint32_t interrupt_reg;
+#if UART_CPU_STATS
+	uint32_t start = CycleCounterGet();
+	uint32_t bytes = 0;
+#endif
+
+	//handle every pending source (bit 0 clear = interrupt pending)
+	while( ((interrupt_reg = LPC_UART2->IIR) & 0x1) == 0 )
 	{
-		recv_buffer_length = UART_RECV_LENGTH;
-#if UART_DEBUG
-		printf("Warning - truncating received bytes to %i bytes\n",UART_RECV_LENGTH);
+		switch( interrupt_reg & 0xe )
+		{
+#if !UART_TX_DMA
+		//transmit FIFO empty, refill it or go idle
+		case 0x2:
+#if UART_CPU_STATS
+			bytes +=
 #endif
+			uart_fill_fifo();
+			if( tx_waiting && UART_TX_FREE() >= UART_TX_WAKE_SPACE )
+			{
+				tx_waiting = 0;
+				xSemaphoreGiveFromISR(txSpaceSem,&xHigherPriorityTaskWoken);
+			}
+			break;
+#endif
+
+		//receive data at the trigger level, or a character timeout:
+		//drain the FIFO and copy it into the RX stream in one go
+		case 0x4:
+		case 0xc:
+		case 0x6:
+		{
+			uint8_t chunk[UART_FIFO_DEPTH];
+			uint32_t count = 0;
+			uint8_t line_end = 0;
+
+			while( count < UART_FIFO_DEPTH && (LPC_UART2->LSR & 0x1) )
+			{
+				chunk[count] = LPC_UART2->RBR;
+				if( chunk[count] == '\r' || chunk[count] == '\n' )
+				{
+					line_end = 1;
+				}
+				count++;
+			}
+#if UART_CPU_STATS
+			bytes += count;
+#endif
+			if( count > 0 )
+			{
+				//the stream wakes the parser itself before it fills up
+				//with a long line, what does not fit is lost
+				uart_rx_overruns += count - xStreamBufferSendFromISR(rx_stream,chunk,count,&xHigherPriorityTaskWoken);
+			}
+			//and the parser takes a line as soon as it ends
+			if( line_end )
+			{
+				xStreamBufferSendCompletedFromISR(rx_stream,&xHigherPriorityTaskWoken);
+			}
+			break;
+		}
+
+		default:
+			//line status only, reading LSR clears it
+			(void)LPC_UART2->LSR;
+			break;
+		}
 	}
 
-#if UART_DEBUG
-	printf("Receive buffer length set to %d, index is %d\n",recv_buffer_length,recv_buffer_index);
+#if UART_CPU_STATS
+	uart_isr_cycles += CycleCounterGet() - start;
+	uart_isr_bytes += bytes;
 #endif
+
+	portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
 }
 
-// Receive handler, loads next character into receive buffer,
-// sends when complete
+//Start passing command lines to queue
+void uart_receive_commands(QueueHandle_t queue)
+{
+	cmd_queue = queue;
+}
+
+//Hand a command buffer back once the consumer is done with it, and
+//wake the parser in case it was waiting for one
+void uart_command_release(uart_command_t* cmd)
+{
+	if( cmd != NULL )
+	{
+		MsgFree(cmd);
+		if( rx_task != NULL )
+		{
+			xTaskNotifyGive(rx_task);
+		}
+	}
+}
+
+// Receive handler - a streaming line parser. Woken by the RX stream at
+// the end of a line (or once UART_RX_WAKE_LEVEL bytes are waiting), it
+// takes the new bytes a block at a time and moves them straight into the
+// command buffer being built. A finished line is posted to the consumer
+// as a single pointer. If every buffer is still with the consumer it
+// waits for one to be released, leaving bytes in the stream, rather than
+// drop a command. Lines longer than UART_CMD_LENGTH are discarded whole
+// and counted.
 void uart_rx_handler()
 {
+	uart_command_t* cmd = NULL;
+	uint8_t chunk[UART_RX_CHUNK];
+	size_t count = 0;
+	size_t next = 0;
+	uint8_t discard = 0;
+	uint8_t c;
+
+	rx_task = xTaskGetCurrentTaskHandle();
+
 	while(1)
 	{
-		if( pdFAIL == xSemaphoreTake(rxHandleSem,portMAX_DELAY) )
+		if( next == count )
 		{
-#if UART_DEBUG
-			printf("xSemaphoreTake failed!\n");
-#endif
+			//returns at once with whatever is waiting, only an empty
+			//stream blocks
+			count = xStreamBufferReceive(rx_stream,chunk,sizeof(chunk),portMAX_DELAY);
+			next = 0;
+			continue;
 		}
 
-		//recv_buffer[recv_buffer_index] = LPC_UART2->RBR;
-		recv_buffer_index++;
+		c = chunk[next];
 
-		//if this was the last character we were expecting
-		if( recv_buffer_index >= recv_buffer_length )
+		if( c == '\r' || c == '\n' )
 		{
-			//don't send to the queue if the queue doesn't exist
-			if( recv_queue != NULL )
+			if( cmd != NULL && !discard && cmd->length > 0 )
 			{
-				//send the character to inform the IO layer that
-				//a series of letters is incoming
+				cmd->text[cmd->length] = '\0';
 #if UART_DEBUG
-				printf("xQueueSend - Sending char %c\n",autodial_char);
+				printf("Command %s\n",cmd->text);
 #endif
-				xQueueSend(*recv_queue,&autodial_char,0);
-				for(int i = 0; i < recv_buffer_index; i++ )
+				if( cmd_queue != NULL )
 				{
-#if UART_DEBUG
-					printf("xQueueSend - Sending char %c\n",recv_buffer[i]);
-#endif
-					//send to provided queue - verify that this would work
-					xQueueSend(*recv_queue,&recv_buffer[i],0);
+					MsgSend(cmd_queue,cmd,portMAX_DELAY);
+					cmd = NULL;
 				}
 			}
+			if( cmd != NULL )
+			{
+				cmd->length = 0;
+			}
+			discard = 0;
+		}
+		else if( !discard )
+		{
+			if( cmd == NULL )
+			{
+				cmd = MsgAlloc(&uart_cmd_pool);
+				if( cmd == NULL )
+				{
+					//keep the byte until uart_command_release()
+					ulTaskNotifyTake(pdTRUE,portMAX_DELAY);
+					continue;
+				}
+				cmd->length = 0;
+			}
+			if( cmd->length < UART_CMD_LENGTH )
+			{
+				cmd->text[cmd->length++] = c;
+			}
 			else
 			{
-#if UART_DEBUG
-				printf("Receive queue not set up, discarding characters %s\n",recv_buffer);
-#endif
+				uart_cmd_rejected++;
+				discard = 1;
 			}
-			recv_buffer_index = 0;
 		}
+		next++;
 	}
 }
@@ -9,6 +9,7 @@
 #include "portable.h"
 #include "semphr.h"
 #include "queue.h"
+#include "msgpool.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -27,20 +28,46 @@
  *   To send, use the uart_send_block() or
  *   uart_send_noblock(), depending on whether it is
  *   acceptable for the calling task to pend on previous
- *   send operations completing.
+ *   send operations completing. uart_send_noblock() is lock
+ *   free: any number of tasks and interrupts may queue
+ *   messages at once, each goes out whole or is dropped and
+ *   counted, and none of them ever blocks.
  *
- *   To receive, use the uart_receive_block() or
- *   uart_receive_noblock() functions.  The receiver
- *   passes in a pointer to the queue that the data
- *   will be sent to.  The queue should accept
- *   one character inputs.
+ *   To receive, call uart_receive_commands() with a queue
+ *   of message pointers. Input is taken as lines of
+ *   any length up to UART_CMD_LENGTH, ended by CR or LF
+ *   (empty lines are skipped). Each line is built in place
+ *   in one of the UART_CMD_BUFFERS buffers of uart_cmd_pool
+ *   and posted whole, by reference (msgpool.h); the consumer
+ *   takes it with MsgReceive() and hands the buffer back with
+ *   uart_command_release() when done with it.
  *
- *   The user will need to create two tasks with the
- *   following entry points:
- *   uart_tx_handler()
- *   uart_rx_handler()
- *   These are interrupt handlers and should be
- *   prioritized accordingly.
+ *   Transmit is driven by the interrupt: sends are copied
+ *   into a TX ring and the ISR refills the 16 byte hardware
+ *   FIFO from it each time it empties, so a message costs
+ *   one interrupt per 16 bytes and no task switches. A
+ *   sender only waits (uart_send_block) when the ring is
+ *   full, and is woken once UART_TX_WAKE_SPACE bytes free up.
+ *
+ *   With UART_TX_DMA the transmitter is fed by GPDMA channel
+ *   UART_TX_DMA_CHANNEL instead of the THRE interrupt. The
+ *   engine takes a queue of (pointer, length) segments, each
+ *   with its own linked list item, and links every new
+ *   segment onto the one before it so the channel runs from
+ *   one to the next without the CPU. Each segment raises one
+ *   terminal count interrupt, which runs its done callback.
+ *   The TX ring is drained through it one contiguous span at
+ *   a time, so a whole report costs one or two interrupts.
+ *   uart_dma_send() queues a caller's own buffer directly,
+ *   without the copy; it must stay untouched until done.
+ *
+ *   Received bytes are drained from the FIFO by the ISR (at
+ *   UART_RX_TRIGGER characters, or on the character timeout)
+ *   and copied whole into an RX stream buffer (stream_buffer.h).
+ *   The user will need to create a task with the entry point
+ *   uart_rx_handler(), the line parser; it is only woken at the
+ *   end of a line, or once UART_RX_WAKE_LEVEL bytes are waiting,
+ *   and then takes up to UART_RX_CHUNK bytes per copy.
  *
  **********************************************************/
 
@@ -48,13 +75,56 @@
 #ifndef UART_H_
 #define UART_H_
 
-//maximum send and receive lengths
+//maximum send length
 #define UART_SEND_LENGTH 50
-#define UART_RECV_LENGTH 50
+
+//command lines
+#define UART_CMD_LENGTH 80           //CONFIGURABLE - longest command line
+#define UART_CMD_BUFFERS 4           //CONFIGURABLE - lines the consumer may hold at once
+
+//ring sizes, the TX ring a power of two
+#define UART_TX_RING_SIZE 256        //CONFIGURABLE - bytes queued for transmit
+#define UART_RX_RING_SIZE 128        //CONFIGURABLE - bytes received, not yet taken
+#define UART_RX_WAKE_LEVEL (UART_RX_RING_SIZE / 2)
+#define UART_RX_CHUNK 32             //bytes the parser takes from the RX stream at a time
+#define UART_TX_WAKE_SPACE (UART_TX_RING_SIZE / 2)
+
+//hardware FIFO depth, and the RX FIFO interrupt trigger
+//(FCR encoding: 0 = 1 char, 1 = 4, 2 = 8, 3 = 14)
+#define UART_FIFO_DEPTH 16
+#define UART_RX_TRIGGER 2
+
+//set this to non-zero to transmit with the GPDMA rather than the
+//THRE interrupt, UART_TX_DMA_SEGMENTS (a power of two) may be queued
+#define UART_TX_DMA 1
+#define UART_TX_DMA_CHANNEL 1
+#define UART_TX_DMA_SEGMENTS 8       //CONFIGURABLE - segments queued on the channel
+#define UART_TX_DMA_MAX 4095         //largest segment, the GPDMA transfer size limit
 
 //set this to non-zero to enable printf debug statements
 #define UART_DEBUG 0
 
+//set this to non-zero to count the cycles spent in the UART ISR
+//(uart_isr_cycles) against the bytes it moved (uart_isr_bytes)
+#define UART_CPU_STATS 0
+
+//bytes lost because the RX stream was full, and command lines
+//discarded for being longer than UART_CMD_LENGTH
+extern volatile uint32_t uart_rx_overruns;
+extern volatile uint32_t uart_cmd_rejected;
+//messages uart_send_noblock() dropped because the TX ring was full, and
+//the most bytes the TX ring has held
+extern volatile uint32_t uart_tx_dropped;
+extern volatile uint32_t uart_tx_high_water;
+#if UART_TX_DMA
+//segments the GPDMA reported an error on
+extern volatile uint32_t uart_dma_errors;
+#endif
+#if UART_CPU_STATS
+extern volatile uint32_t uart_isr_cycles;
+extern volatile uint32_t uart_isr_bytes;
+#endif
+
 //configure the UART - this must be called before the UART will work
 void uart_configure();
 
@@ -62,26 +132,49 @@ void uart_configure();
 //
 // Send data - attempts to take mutex, waits until that happens
 void uart_send_block(char* buf, int length);
-// Send data - attempts to take mutex, returns immediately if
-//   take operation fails.  Returns 0 on success or -1 on
-//   failure.
+// Send data - queues the whole message in the TX ring without
+//   taking a lock or waiting, from any task or interrupt that may
+//   use the FreeRTOS API. Returns 0 on success or -1 if the ring
+//   has no room, in which case the message is dropped and counted
+//   in uart_tx_dropped.
 int uart_send_noblock(char* buf, int length);
 
+#if UART_TX_DMA
+// Segment done callback, run from the DMA interrupt once the segment
+//   has been moved into the UART FIFO
+typedef void (*uart_dma_done_t)(void* arg, portBASE_TYPE* woken);
+// Send a buffer by DMA without copying it - buf must be in RAM and
+//   stay unchanged until done (may be NULL) is called with arg.
+//   Safe from tasks and from interrupts that may use the FreeRTOS
+//   API. Returns 0 on success or -1 if
+//   the segment queue is full or length is out of range.
+int uart_dma_send(const char* buf, int length, uart_dma_done_t done, void* arg);
+#endif
+
+//one received command line, NUL terminated
+typedef struct
+{
+	uint16_t length;
+	char text[UART_CMD_LENGTH + 1];
+} uart_command_t;
+
+//the command buffers, its exhausted count is how often the parser
+//had to wait for the consumer
+MSG_POOL_DECLARE(uart_cmd_pool, uart_command_t);
+
 //UART public receive functions
 //
-// Receive data - attempts to take mutex, waits until that happens
-void uart_receive_block(int length, QueueHandle_t* queue);
-// Receive data - attempts to take mutex, returns immediately if
-//   take operation fails.  Returns 0 on success or -1 on
-//   failure
-int uart_receive_noblock(int length, QueueHandle_t* queue);
+// Post every command line received to queue (items of
+//   MSG_QUEUE_ITEM_SIZE, uart_command_t messages taken with
+//   MsgReceive()), from now on
+void uart_receive_commands(QueueHandle_t queue);
+// Return a command's buffer to the receiver
+void uart_command_release(uart_command_t* cmd);
 
 //private functions - unsafe to call directly
-void _uart_send(char* buf, int length);
-void _uart_receive(int length, QueueHandle_t* queue);
+int _uart_send(const char* buf, int length);
 
-//function names for handler tasks
-void uart_tx_handler();
+//function name for the receive handler task
 void uart_rx_handler();
 
 #endif /* UART_H_ */
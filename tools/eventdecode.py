@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Decode the binary event stream sent with DTMF_BINARY_EVENTS.
+
+Frames are COBS encoded and end in a 0x00 byte; each holds type, seq, the
+record body and a CRC-16/CCITT-FALSE, as described in src/event_proto.h.
+The decoder can be used as a library (EventDecoder, decode_frame) or run on
+a captured stream:
+
+    eventdecode.py capture.bin
+    eventdecode.py --serial /dev/ttyUSB0 --baud 12195
+
+Frames that fail the CRC or do not parse are reported and skipped, and gaps
+in seq are reported as lost frames. Detections carry the time since the
+previous frame; EventDecoder adds them to the last absolute time from a
+stats or ack record, and leaves the time unknown (None) after lost frames
+until the next one.
+"""
+
+import argparse
+import struct
+import sys
+from collections import namedtuple
+
+EVENT_DETECT = 1
+EVENT_STATS = 2
+EVENT_ACK = 3
+
+Detect = namedtuple("Detect", "seq delta_ms code snr_db time_ms")
+Stats = namedtuple(
+    "Stats", "seq time_ms frames detections tx_dropped rx_overruns tx_high_water")
+Ack = namedtuple("Ack", "seq time_ms command status")
+
+
+class FrameError(Exception):
+    pass
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Decode one COBS frame, without its 0x00 delimiter."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise FrameError("bad COBS code at %d" % i)
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(frame):
+    """Turn one frame (delimiter removed) into a record namedtuple."""
+    data = cobs_decode(frame)
+    if len(data) < 4:
+        raise FrameError("short frame")
+    body, (crc,) = data[:-2], struct.unpack("<H", data[-2:])
+    if crc16(body) != crc:
+        raise FrameError("CRC mismatch")
+    kind, seq = body[0], body[1]
+    fields = body[2:]
+    try:
+        if kind == EVENT_DETECT:
+            delta_ms, code, snr = struct.unpack("<HBB", fields)
+            return Detect(seq, delta_ms, chr(code), snr / 2.0, None)
+        if kind == EVENT_STATS:
+            return Stats(seq, *struct.unpack("<IIIIIH", fields))
+        if kind == EVENT_ACK:
+            return Ack(seq, *struct.unpack("<IBB", fields))
+    except struct.error:
+        raise FrameError("bad length for record type %d" % kind)
+    raise FrameError("unknown record type %d" % kind)
+
+
+class EventDecoder:
+    """Feed it bytes as they arrive, get back records and errors."""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.next_seq = None
+        self.time_ms = None
+        self.lost = 0
+        self.errors = 0
+
+    def feed(self, data):
+        """Yields a record, or a FrameError, for every complete frame."""
+        self.pending += data
+        while True:
+            end = self.pending.find(0)
+            if end < 0:
+                return
+            frame = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if not frame:
+                continue
+            try:
+                record = decode_frame(frame)
+            except FrameError as err:
+                self.errors += 1
+                yield err
+                continue
+            if self.next_seq is not None and record.seq != self.next_seq:
+                self.lost += (record.seq - self.next_seq) & 0xFF
+                self.time_ms = None
+            self.next_seq = (record.seq + 1) & 0xFF
+            if isinstance(record, Detect):
+                if self.time_ms is not None:
+                    self.time_ms += record.delta_ms
+                record = record._replace(time_ms=self.time_ms)
+            else:
+                self.time_ms = record.time_ms
+            yield record
+
+
+def format_time(time_ms):
+    if time_ms is None:
+        return "%10s" % "?"
+    return "%10.3f" % (time_ms / 1000.0)
+
+
+def format_record(record):
+    if isinstance(record, FrameError):
+        return "error %s" % record
+    if isinstance(record, Detect):
+        return "%s detect %s snr %.1f dB" % (
+            format_time(record.time_ms), record.code, record.snr_db)
+    if isinstance(record, Stats):
+        return ("%s stats frames %d detections %d tx dropped %d "
+                "rx overruns %d tx high water %d") % (
+                    format_time(record.time_ms), record.frames, record.detections,
+                    record.tx_dropped, record.rx_overruns, record.tx_high_water)
+    return "%s ack command %d status %d" % (
+        format_time(record.time_ms), record.command, record.status)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="captured stream, - for stdin")
+    parser.add_argument("--serial", help="read from this serial port (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=12195)
+    args = parser.parse_args()
+
+    if args.serial:
+        import serial
+        port = serial.Serial(args.serial, args.baud, timeout=1)
+        read = lambda: port.read(256)
+    elif args.capture and args.capture != "-":
+        stream = open(args.capture, "rb")
+        read = lambda: stream.read(4096)
+    else:
+        read = lambda: sys.stdin.buffer.read1(4096)
+
+    decoder = EventDecoder()
+    try:
+        while True:
+            data = read()
+            if not data and not args.serial:
+                break
+            for record in decoder.feed(data):
+                print(format_record(record))
+    except KeyboardInterrupt:
+        pass
+    print("%d frames lost, %d bad frames" % (decoder.lost, decoder.errors),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
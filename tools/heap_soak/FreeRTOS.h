@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for FreeRTOS.h and FreeRTOSConfig.h, used by heap_soak.c.
+ * The heap settings match src/FreeRTOSConfig.h with the heap enabled; build
+ * with -DHEAP_SOAK_POOLS to add its fixed size pools.
+ */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "projdefs.h"
+#include "portable.h"
+
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
+#define configUSE_TLSF_HEAP			1
+#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 20 * 1024 ) )
+#ifdef HEAP_SOAK_POOLS
+	#define configHEAP_POOL_SIZES		{ 16, 32, 96 }
+	#define configHEAP_POOL_BLOCKS		{ 16, 8, 8 }
+#endif
+#define configUSE_MALLOC_FAILED_HOOK	0
+#define configASSERT( x )			assert( x )
+
+#define traceMALLOC( pvAddress, uiSize )
+#define traceFREE( pvAddress, uiSize )
+
+#endif /* INC_FREERTOS_H */
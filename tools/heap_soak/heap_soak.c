@@ -0,0 +1,246 @@
+/*
+ * Host soak test for src/FreeRTOS/portable/heap_tlsf.c.
+ *
+ * Runs a long random mix of pvPortMalloc() and vPortFree() over the same
+ * 20 KB heap the target would use, mostly small requests with some up to
+ * 1500 bytes, filling every block with a pattern that is checked when it is
+ * freed.  At soakCHECKPOINTS points in the run it reads vPortGetHeapStats()
+ * and checks that the heap has not fragmented:
+ *
+ * - Freed blocks are merged with their neighbours, so there can never be
+ *   more free blocks than used ones plus one.
+ * - The largest free block can be used: a request of that block less one
+ *   second level size range (an eighth) and a header must succeed, since
+ *   TLSF rounds a request up by at most one range.
+ * - Fragmentation, the share of the free space outside the largest free
+ *   block, is recorded at every checkpoint.  Leaving out the first
+ *   soakWARM_UP checkpoints, while the heap fills from empty, its average
+ *   over the second half of the run must not be more than
+ *   soakFRAGMENT_GROWTH above its average over the first, so it stays
+ *   bounded however long the run.
+ *
+ * At the end everything is freed and the heap must be back to one free
+ * block beside the pools, with nothing lost.
+ *
+ * Build and run from the top of the tree, with and without the pools of
+ * src/FreeRTOSConfig.h:
+ *
+ *   gcc -O2 -Wall -Itools/heap_soak -Isrc/FreeRTOS/include \
+ *       tools/heap_soak/heap_soak.c src/FreeRTOS/portable/heap_tlsf.c -o heap_soak
+ *   ./heap_soak [iterations [seed]]
+ *
+ *   gcc ... -DHEAP_SOAK_POOLS ...
+ *
+ * Exits 0 if every check passed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+#define soakSLOTS			64		/* Blocks live at once, at most. */
+#define soakCHECKPOINTS		1000
+#define soakWARM_UP			100
+#define soakPRINT_EVERY		100		/* Checkpoints between printed stats. */
+#define soakFRAGMENT_GROWTH	0.05
+#define soakHEADER_SIZE		16		/* At least heapHEADER_SIZE. */
+#define soakLARGE_ONE_IN	4		/* One request in this many is large. */
+#define soakSMALL_MAX		120
+#define soakLARGE_MAX		1500
+
+static void *pvBlock[ soakSLOTS ];
+static size_t xBlockSize[ soakSLOTS ];
+static uint8_t ucBlockFill[ soakSLOTS ];
+static double dFragment[ soakCHECKPOINTS ];
+
+static void prvPrintStats( const char *pcWhen, const HeapStats_t *pxStats )
+{
+	printf( "%-10s free %5zu largest %5zu free blocks %3zu min ever %5zu allocs %zu frees %zu failed %zu\n",
+			pcWhen,
+			pxStats->xAvailableHeapSpaceInBytes,
+			pxStats->xSizeOfLargestFreeBlockInBytes,
+			pxStats->xNumberOfFreeBlocks,
+			pxStats->xMinimumEverFreeBytesRemaining,
+			pxStats->xNumberOfSuccessfulAllocations,
+			pxStats->xNumberOfSuccessfulFrees,
+			pxStats->xNumberOfFailedAllocations );
+}
+
+static int prvFree( int iSlot )
+{
+const uint8_t *pucData = pvBlock[ iSlot ];
+size_t x;
+
+	for( x = 0; x < xBlockSize[ iSlot ]; x++ )
+	{
+		if( pucData[ x ] != ucBlockFill[ iSlot ] )
+		{
+			printf( "FAIL: block of %zu bytes overwritten at %zu\n", xBlockSize[ iSlot ], x );
+			return 1;
+		}
+	}
+	vPortFree( pvBlock[ iSlot ] );
+	pvBlock[ iSlot ] = NULL;
+	return 0;
+}
+
+int main( int argc, char **argv )
+{
+long lIterations = ( argc > 1 ) ? atol( argv[ 1 ] ) : 2000000L;
+unsigned uSeed = ( argc > 2 ) ? ( unsigned ) atoi( argv[ 2 ] ) : 1U;
+long lCheckEvery, l;
+size_t xLive = 0, xPools = 0, xSize;
+HeapStats_t xInitial, xStats;
+HeapPoolStats_t xPoolStats;
+char cWhen[ 24 ];
+int iSlot, iCheck = 0;
+double dFirstHalf = 0.0, dSecondHalf = 0.0;
+void *pvLargest;
+
+	if( lIterations < soakCHECKPOINTS )
+	{
+		lIterations = soakCHECKPOINTS;
+	}
+	lCheckEvery = lIterations / soakCHECKPOINTS;
+	srand( uSeed );
+
+	vPortGetHeapStats( &xInitial );
+	prvPrintStats( "start", &xInitial );
+
+	for( l = 1; l <= lIterations; l++ )
+	{
+		iSlot = rand() % soakSLOTS;
+
+		if( pvBlock[ iSlot ] != NULL )
+		{
+			if( prvFree( iSlot ) != 0 )
+			{
+				return 1;
+			}
+			xLive--;
+		}
+		else
+		{
+			if( ( rand() % soakLARGE_ONE_IN ) == 0 )
+			{
+				xSize = 1 + ( size_t ) rand() % soakLARGE_MAX;
+			}
+			else
+			{
+				xSize = 1 + ( size_t ) rand() % soakSMALL_MAX;
+			}
+
+			pvBlock[ iSlot ] = pvPortMalloc( xSize );
+			if( pvBlock[ iSlot ] != NULL )
+			{
+				xBlockSize[ iSlot ] = xSize;
+				ucBlockFill[ iSlot ] = ( uint8_t ) rand();
+				memset( pvBlock[ iSlot ], ucBlockFill[ iSlot ], xSize );
+				xLive++;
+			}
+		}
+
+		if( ( l % lCheckEvery ) == 0 )
+		{
+			/* The pools are carved out of the heap as used blocks. */
+			for( xPools = 0; xPortGetHeapPoolStats( ( UBaseType_t ) xPools, &xPoolStats ) == pdPASS; xPools++ )
+			{
+			}
+
+			vPortGetHeapStats( &xStats );
+			if( ( ( iCheck + 1 ) % soakPRINT_EVERY ) == 0 )
+			{
+				snprintf( cWhen, sizeof( cWhen ), "%ld", l );
+				prvPrintStats( cWhen, &xStats );
+			}
+
+			if( xStats.xNumberOfFreeBlocks > xLive + xPools + 1 )
+			{
+				printf( "FAIL: %zu free blocks beside %zu used\n", xStats.xNumberOfFreeBlocks, xLive + xPools );
+				return 1;
+			}
+
+			xSize = xStats.xSizeOfLargestFreeBlockInBytes;
+			if( xSize > xSize / 8 + soakHEADER_SIZE )
+			{
+				xSize -= xSize / 8 + soakHEADER_SIZE;
+				pvLargest = pvPortMalloc( xSize );
+				if( pvLargest == NULL )
+				{
+					printf( "FAIL: %zu bytes not served from a %zu byte free block\n", xSize, xStats.xSizeOfLargestFreeBlockInBytes );
+					return 1;
+				}
+				vPortFree( pvLargest );
+			}
+
+			if( ( xStats.xAvailableHeapSpaceInBytes != 0 ) && ( iCheck < soakCHECKPOINTS ) )
+			{
+				dFragment[ iCheck ] = 1.0 - ( double ) xStats.xSizeOfLargestFreeBlockInBytes / ( double ) xStats.xAvailableHeapSpaceInBytes;
+			}
+			iCheck++;
+		}
+	}
+
+	for( iSlot = 0; iSlot < ( soakCHECKPOINTS - soakWARM_UP ) / 2; iSlot++ )
+	{
+		dFirstHalf += dFragment[ soakWARM_UP + iSlot ];
+		dSecondHalf += dFragment[ ( soakCHECKPOINTS + soakWARM_UP ) / 2 + iSlot ];
+	}
+	dFirstHalf /= ( soakCHECKPOINTS - soakWARM_UP ) / 2;
+	dSecondHalf /= ( soakCHECKPOINTS - soakWARM_UP ) / 2;
+	printf( "fragmentation %.3f in the first half, %.3f in the second\n", dFirstHalf, dSecondHalf );
+	if( dSecondHalf > dFirstHalf + soakFRAGMENT_GROWTH )
+	{
+		printf( "FAIL: fragmentation grew\n" );
+		return 1;
+	}
+
+	for( iSlot = 0; iSlot < soakSLOTS; iSlot++ )
+	{
+		if( ( pvBlock[ iSlot ] != NULL ) && ( prvFree( iSlot ) != 0 ) )
+		{
+			return 1;
+		}
+	}
+
+	vPortGetHeapStats( &xStats );
+	prvPrintStats( "end", &xStats );
+
+	for( xPools = 0; xPortGetHeapPoolStats( ( UBaseType_t ) xPools, &xPoolStats ) == pdPASS; xPools++ )
+	{
+		printf( "pool %3zu bytes: %2zu of %2zu free, fewest %2zu, allocs %zu, misses %zu\n",
+				xPoolStats.xBlockSize,
+				xPoolStats.xNumberOfFreeBlocks,
+				xPoolStats.xNumberOfBlocks,
+				xPoolStats.xMinimumEverFreeBlocks,
+				xPoolStats.xNumberOfAllocations,
+				xPoolStats.xNumberOfMisses );
+
+		if( xPoolStats.xNumberOfFreeBlocks != xPoolStats.xNumberOfBlocks )
+		{
+			printf( "FAIL: pool blocks lost\n" );
+			return 1;
+		}
+	}
+
+	if( xStats.xNumberOfSuccessfulAllocations != xStats.xNumberOfSuccessfulFrees )
+	{
+		printf( "FAIL: allocations and frees do not match\n" );
+		return 1;
+	}
+	if( xStats.xNumberOfFreeBlocks > xPools + 1 )
+	{
+		printf( "FAIL: heap left in %zu free blocks\n", xStats.xNumberOfFreeBlocks );
+		return 1;
+	}
+	if( ( xPools == 0 ) && ( ( xStats.xAvailableHeapSpaceInBytes != xInitial.xAvailableHeapSpaceInBytes ) ||
+							 ( xStats.xSizeOfLargestFreeBlockInBytes != xInitial.xSizeOfLargestFreeBlockInBytes ) ) )
+	{
+		printf( "FAIL: heap not back to its starting size\n" );
+		return 1;
+	}
+
+	printf( "PASS\n" );
+	return 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for the Cortex-M3 portmacro.h, enough for heap_soak.c to
+ * build heap_tlsf.c against the kernel's own portable.h.
+ */
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uintptr_t StackType_t;
+
+#define portBYTE_ALIGNMENT			8
+#define portPOINTER_SIZE_TYPE		uintptr_t
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for task.h: heap_soak.c has no scheduler to suspend.
+ */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#define vTaskSuspendAll()
+#define xTaskResumeAll()	( ( BaseType_t ) pdFALSE )
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,28 @@
+/*
+ * Host stand-in for the CMSIS LPC17xx.h, used by loopback_host.c.  The
+ * sources it builds name these registers only in code the harness never
+ * calls, so they only have to compile.
+ */
+#ifndef __LPC17xx_H__
+#define __LPC17xx_H__
+
+#include <stdint.h>
+
+#define __INLINE	inline
+#define __I			volatile const
+#define __O			volatile
+#define __IO		volatile
+
+#define __NVIC_PRIO_BITS	5
+
+typedef struct
+{
+	__IO uint32_t DHCSR;
+	__O  uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define CoreDebug					( ( CoreDebug_Type * ) 0xE000EDF0UL )
+#define CoreDebug_DEMCR_TRCENA_Msk	( 1UL << 24 )
+#endif
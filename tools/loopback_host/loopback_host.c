@@ -0,0 +1,273 @@
+//=============================================================================
+// loopback_host.c - the loopback self test on the host, DAC and ADC simulated
+//=============================================================================
+/* The host side of the LOOPBACK_BENCHMARK harness (src/loopback.h).  The
+ * firmware's own tone tables (ToneTableInit()) are played through a
+ * simulated DAC, sampled by a simulated ADC at DTMFSampleRate in the format
+ * adc_read() returns under LOOPBACK_DIGITAL, and each frame is put through
+ * the detector's own fft(), pick_peaks() and decode_tones() exactly as
+ * vDTMFDetectTask() does.  The sources are the firmware's; only the kernel
+ * and the chip are replaced, by the stand-in headers next to this file.
+ *
+ * For each key, LOOPBACK_HOST_FRAMES frames are taken at a different phase
+ * of the table, clean and with noise added, and must all decode to that
+ * key.  Silence must decode to nothing.  Then the echo canceller
+ * (echo_cancel.h) is given the board's own tone back through a delayed,
+ * attenuated path as the ADC input with the DAC as its reference: once it
+ * has converged the own tone must disappear, and a far end key played over
+ * it must still be detected.
+ *
+ * Build and run from the top of the tree:
+ *
+ *   gcc -O2 -Wall -ffunction-sections -fdata-sections -Wl,--gc-sections \
+ *       -Itools/loopback_host -Isrc -Isrc/FreeRTOS/include -Isrc/FreeRTOS/demo_code \
+ *       tools/loopback_host/loopback_host.c src/tonegen.c src/sinelut.c \
+ *       src/dtmf_detect_task.c src/echo_cancel.c src/fft/fft.c \
+ *       src/fft/complex_numbers.c src/fft/trig_approximations.c -lm -o loopback_host
+ *   ./loopback_host
+ *
+ * Linking with --gc-sections drops the tasks, which are never called, and
+ * with them every reference to the kernel.  Exits 0 if every check passed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tonegen.h"
+#include "dtmf_data.h"
+#include "dtmf_detect_task.h"
+#include "echo_cancel.h"
+#include "adc_task.h"
+#include "fft/fft.h"
+
+#define LOOPBACK_HOST_FRAMES     20    // Frames taken of every key
+#define LOOPBACK_HOST_NOISE      200   // Peak of the added noise, DAC counts
+#define LOOPBACK_HOST_ECHO_DELAY 3     // DAC to ADC delay of the echo path, ADC samples
+#define LOOPBACK_HOST_ECHO_GAIN  0.6f  // Gain of the echo path
+#define LOOPBACK_HOST_CONVERGE   30    // Frames the echo canceller gets to learn the path
+#define LOOPBACK_HOST_FAR_END    (DTMF_AMPLITUDE / 2)  // Peak of each far end tone
+
+#define DAC_PER_ADC (DAC_SAMPLE_PER_SECOND / DTMFSampleRate)
+
+static DTMFSampleType samples[DTMFSampleSize];
+static DTMFSampleType reference[DTMFSampleSize];
+static complex cs[DTMFSampleSize];
+static uint32_t noiseState = 1;
+static int failures = 0;
+
+//=============================================================================
+// ulPortSetInterruptMask() - where configASSERT() stops, abort on the host
+//=============================================================================
+uint32_t ulPortSetInterruptMask(void)
+{
+  printf("FAIL: configASSERT\n");
+  abort();
+}
+
+//=============================================================================
+// Noise() - uniform noise of peak amplitude, repeatable from run to run
+//=============================================================================
+static int32_t Noise(int32_t amplitude)
+{
+  noiseState = noiseState * 1664525UL + 1013904223UL;
+  return (int32_t)((noiseState >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+//=============================================================================
+// DacValue() - what the DAC drives at DAC sample n while a key's table loops
+//=============================================================================
+static int32_t DacValue(int key, uint32_t n)
+{
+  return DAC_SAMPLE_VALUE(toneTableStart[key][n % toneTableInfo[key].length]);
+}
+
+//=============================================================================
+// AdcSample() - a DAC value as adc_read() returns it under LOOPBACK_DIGITAL
+//=============================================================================
+static DTMFSampleType AdcSample(int32_t value)
+{
+  if(value < 0)
+  {
+    value = 0;
+  }
+  else if(value > MAX_AMPLITUDE)
+  {
+    value = MAX_AMPLITUDE;
+  }
+  return ADC_FROM_DACR(DAC_SAMPLE(value));
+}
+
+//=============================================================================
+// Detect() - one frame through the detector, as vDTMFDetectTask() runs it
+//=============================================================================
+static char Detect(struct EchoCanceller_t *ec)
+{
+  int16_t toneA;
+  int16_t toneB;
+  float snr;
+  int i;
+
+  for(i = 0; i < DTMFSampleSize; i++)
+  {
+    cs[i].Re = (float)samples[i] / 16384.0f;
+    cs[i].Im = 0.0f;
+  }
+  if(ec != NULL)
+  {
+    echo_cancel_frame(ec, cs, reference, DTMFSampleSize);
+  }
+  fft(cs, DTMFSampleSize);
+  pick_peaks(cs, DTMFPeakThreshold, &toneA, &toneB, &snr);
+  return decode_tones(toneA, toneB);
+}
+
+//=============================================================================
+// Check() - count a detection against the expected key
+//=============================================================================
+static void Check(const char *what, char want, char got)
+{
+  if(got != want)
+  {
+    printf("FAIL: %s: expected '%c', detected '%c'\n", what, want, got);
+    failures++;
+  }
+}
+
+//=============================================================================
+// TestKeys() - every key, clean and noisy, from LOOPBACK_HOST_FRAMES phases
+//=============================================================================
+static void TestKeys(void)
+{
+  uint32_t start;
+  int key;
+  int frame;
+  int noisy;
+  int hits;
+  char got;
+  int i;
+
+  printf("key  hits\n");
+  for(key = 0; key < NUM_DTMF_TONES; key++)
+  {
+    hits = 0;
+    for(frame = 0; frame < LOOPBACK_HOST_FRAMES; frame++)
+    {
+      // Frames start wherever the ADC happens to catch the table
+      start = (uint32_t)(frame * 37 + key);
+      for(noisy = 0; noisy < 2; noisy++)
+      {
+        for(i = 0; i < DTMFSampleSize; i++)
+        {
+          samples[i] = AdcSample(DacValue(key, start + i * DAC_PER_ADC) +
+                                 (noisy ? Noise(LOOPBACK_HOST_NOISE) : 0));
+        }
+        got = Detect(NULL);
+        if(got == toneTableInfo[key].btn)
+        {
+          hits++;
+        }
+        Check(noisy ? "noisy key" : "key", toneTableInfo[key].btn, got);
+      }
+    }
+    printf("  %c  %3d/%d\n", toneTableInfo[key].btn, hits, 2 * LOOPBACK_HOST_FRAMES);
+  }
+
+  for(i = 0; i < DTMFSampleSize; i++)
+  {
+    samples[i] = AdcSample(DAC_MIDSCALE + Noise(LOOPBACK_HOST_NOISE));
+  }
+  Check("silence", ' ', Detect(NULL));
+}
+
+//=============================================================================
+// EchoFrame() - an ADC frame of our own key's echo, plus a far end key
+//=============================================================================
+static void EchoFrame(int own, TONE_OSC *far, uint32_t start)
+{
+  DAC_Sample farSample = DAC_SAMPLE(DAC_MIDSCALE);
+  uint32_t n;
+  int32_t echo;
+  int i;
+
+  for(i = 0; i < DTMFSampleSize; i++)
+  {
+    n = start + i * DAC_PER_ADC;
+    reference[i] = AdcSample(DacValue(own, n));
+
+    echo = DacValue(own, n - LOOPBACK_HOST_ECHO_DELAY * DAC_PER_ADC) - DAC_MIDSCALE;
+    if(far != NULL)
+    {
+      // The far end runs at the DAC rate too, one sample per ADC sample kept
+      ToneGenBlock(far, 2, DAC_MIDSCALE, &farSample, 1);
+      ToneGenBlock(far, 2, DAC_MIDSCALE, &farSample, 1);
+    }
+    samples[i] = AdcSample(DAC_SAMPLE_VALUE(farSample) +
+                           (int32_t)(LOOPBACK_HOST_ECHO_GAIN * echo) +
+                           Noise(LOOPBACK_HOST_NOISE / 40));
+  }
+}
+
+//=============================================================================
+// TestEchoCancel() - our own key cancelled, a far end key kept
+//=============================================================================
+static void TestEchoCancel(void)
+{
+  static const char farKeys[] = "5#";
+  struct EchoCanceller_t ec;
+  TONE_OSC far[2];
+  uint32_t start = 0;
+  int own = ToneTableIndex('1');
+  int frame;
+  int k;
+
+  echo_cancel_init(&ec);
+
+  // Without the canceller the echo of our own key is detected
+  EchoFrame(own, NULL, start);
+  Check("echo, no canceller", '1', Detect(NULL));
+
+  for(frame = 0; frame < LOOPBACK_HOST_CONVERGE; frame++)
+  {
+    EchoFrame(own, NULL, start);
+    start += DTMFSampleSize * DAC_PER_ADC;
+    Detect(&ec);
+  }
+  EchoFrame(own, NULL, start);
+  start += DTMFSampleSize * DAC_PER_ADC;
+  Check("echo cancelled", ' ', Detect(&ec));
+
+  for(k = 0; farKeys[k] != '\0'; k++)
+  {
+    // The far end key's nominal DTMF frequencies
+    switch(farKeys[k])
+    {
+    case '5':
+      ToneOscInit(&far[0], DTMF_L1_FREQ, LOOPBACK_HOST_FAR_END);
+      ToneOscInit(&far[1], DTMF_H1_FREQ, LOOPBACK_HOST_FAR_END);
+      break;
+    default:
+      ToneOscInit(&far[0], DTMF_L3_FREQ, LOOPBACK_HOST_FAR_END);
+      ToneOscInit(&far[1], DTMF_H2_FREQ, LOOPBACK_HOST_FAR_END);
+      break;
+    }
+    EchoFrame(own, far, start);
+    start += DTMFSampleSize * DAC_PER_ADC;
+    Check("far end over the echo", farKeys[k], Detect(&ec));
+  }
+}
+
+int main(void)
+{
+  ToneTableInit();
+  init_Wn();
+
+  TestKeys();
+  TestEchoCancel();
+
+  if(failures != 0)
+  {
+    printf("%d checks failed\n", failures);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
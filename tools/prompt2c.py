@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Convert a WAV file into a flash-resident prompt for src/prompt.c.
+
+The input must be 16 bit mono PCM at 8000 or 16000 Hz. The output is a C
+source file defining <name>Data[] and the PROMPT <name>, ready to add to
+the build next to src/prompt_data.c.
+
+    prompt2c.py --format adpcm --name promptWelcome welcome.wav > prompt_welcome.c
+
+Formats: ulaw, alaw (G.711, 8 bits a sample) and adpcm (IMA ADPCM, 4 bits a
+sample in WAV style blocks of --block bytes).
+"""
+
+import argparse
+import struct
+import sys
+import wave
+
+IMA_STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+    3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
+    9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+    24623, 27086, 29794, 32767,
+]
+IMA_INDEX = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+FORMATS = {"ulaw": 0, "alaw": 1, "adpcm": 2}
+
+
+def ulaw_encode(sample):
+    sign = 0x80 if sample < 0 else 0
+    magnitude = min(abs(sample), 32635) + 0x84
+    exponent = 7
+    while exponent > 0 and not magnitude & (0x4000 >> (7 - exponent)):
+        exponent -= 1
+    mantissa = (magnitude >> (exponent + 3)) & 0x0F
+    return ~(sign | (exponent << 4) | mantissa) & 0xFF
+
+
+def alaw_encode(sample):
+    sign = 0x80 if sample >= 0 else 0
+    magnitude = min(abs(sample), 32767) >> 3
+    if magnitude < 32:
+        code = magnitude >> 1
+    else:
+        segment = 1
+        while magnitude >= 64 << (segment - 1) and segment < 7:
+            segment += 1
+        code = (segment << 4) | ((magnitude >> segment) & 0x0F)
+    return (sign | code) ^ 0x55
+
+
+def adpcm_encode(samples, block_bytes):
+    per_block = 1 + 2 * (block_bytes - 4)
+    out = bytearray()
+    index = 0
+    for start in range(0, len(samples), per_block):
+        block = samples[start:start + per_block]
+        predictor = block[0]
+        out += struct.pack("<hBB", predictor, index, 0)
+        nibbles = []
+        for sample in block[1:]:
+            step = IMA_STEPS[index]
+            diff = sample - predictor
+            code = 8 if diff < 0 else 0
+            diff = abs(diff)
+            delta = step >> 3
+            for bit, part in ((4, step), (2, step >> 1), (1, step >> 2)):
+                if diff >= part:
+                    code |= bit
+                    diff -= part
+                    delta += part
+            predictor += -delta if code & 8 else delta
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(88, index + IMA_INDEX[code & 7]))
+            nibbles.append(code)
+        if len(nibbles) % 2:
+            nibbles.append(0)
+        for lo, hi in zip(nibbles[0::2], nibbles[1::2]):
+            out.append(lo | (hi << 4))
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("wav")
+    parser.add_argument("--name", required=True, help="C name of the PROMPT")
+    parser.add_argument("--format", choices=sorted(FORMATS), default="adpcm")
+    parser.add_argument("--block", type=int, default=256, help="ADPCM block bytes")
+    args = parser.parse_args()
+
+    with wave.open(args.wav, "rb") as wav:
+        if wav.getnchannels() != 1 or wav.getsampwidth() != 2:
+            sys.exit("need 16 bit mono PCM")
+        rate = wav.getframerate()
+        if rate not in (8000, 16000):
+            sys.exit("need 8000 or 16000 Hz")
+        raw = wav.readframes(wav.getnframes())
+    samples = list(struct.unpack("<%dh" % (len(raw) // 2), raw))
+
+    if args.format == "ulaw":
+        data = bytes(ulaw_encode(s) for s in samples)
+    elif args.format == "alaw":
+        data = bytes(alaw_encode(s) for s in samples)
+    else:
+        data = adpcm_encode(samples, args.block)
+
+    print("/* Generated by tools/prompt2c.py from %s, do not edit */" % args.wav.split("/")[-1])
+    print('#include "prompt.h"')
+    print()
+    print("static const uint8_t %sData[%d] =" % (args.name, len(data)))
+    print("{")
+    for i in range(0, len(data), 16):
+        print("  " + ", ".join("0x%02X" % b for b in data[i:i + 16]) + ",")
+    print("};")
+    print()
+    print("const PROMPT %s =" % args.name)
+    print("{")
+    print("  %d, %d, %d, %d, %sData" % (FORMATS[args.format], rate,
+                                        args.block if args.format == "adpcm" else 0,
+                                        len(samples), args.name))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()